@@ -0,0 +1,85 @@
+#ifndef ASYNCMATCH_INCLUDED
+#define ASYNCMATCH_INCLUDED
+
+// The match loop of Match.h as a coroutine, for matches in which a player
+// may have to wait for its decisions.  Seats declared as an AsyncPlayer
+// type are awaited and may suspend the match; any other player is called
+// directly, as in runMatch, and a match between two of those is simply
+// handed to runMatch, so it costs no more than the coroutine's frame.
+// Either way the same calls are made in the same order as by runMatch.
+// The instrumentation doesn't time awaited decisions, since their time
+// would include the wait.
+
+#include "Coroutine.h"
+
+#if BATTLESHIP_COROUTINES
+
+#include "Match.h"
+#include "AsyncPlayer.h"
+
+  // As runMatch.  Every argument must outlive the match, which runs when
+  // the returned Async is awaited, spawned on a Scheduler or run with
+  // runNow.
+template <class P1, class P2, class Observer>
+Async<void> runMatchAsync(const Game& g, P1* p1, P2* p2, Board& b1, Board& b2,
+                          Observer& observer, MatchResult& result)
+{
+    if constexpr (!isAsyncPlayer<P1>  &&  !isAsyncPlayer<P2>)
+    {
+        runMatch(g, p1, p2, b1, b2, observer, result); //nothing to wait for
+        co_return;
+    }
+    Player* const players[2] = { p1, p2 };
+    const Board* const constBoards[2] = { &b1, &b2 };
+    observer.matchStarted(g, players, constBoards);
+    bool placed;
+    if constexpr (isAsyncPlayer<P1>)
+        placed = co_await p1->placeShipsAsync(b1);
+    else
+        placed = p1->placeShips(b1);
+    if (placed)
+    {
+        GameEvent e = { GameEvent::PLACEMENT_DONE, 0, Point(), -1 };
+        notifyObserver(observer, e, p1);
+        if constexpr (isAsyncPlayer<P2>)
+            placed = co_await p2->placeShipsAsync(b2);
+        else
+            placed = p2->placeShips(b2);
+        if (placed)
+        {
+            e.player = 1;
+            notifyObserver(observer, e, p2);
+        }
+    }
+    if (!placed  ||  b1.allShipsDestroyed()  ||  b2.allShipsDestroyed())
+    {
+        observer.matchEnded();
+        co_return; //nobody wins
+    }
+    for (;;)
+    {
+        result.turns++;
+        GameEvent e = { GameEvent::TURN_START, 0, Point(), -1 };
+        notifyObserver(observer, e, p1);
+        Point p;
+        if constexpr (isAsyncPlayer<P1>)
+            p = co_await p1->recommendAttackAsync();
+        else
+            p = p1->recommendAttack();
+        if (resolveShot(p1, p, b2, 0, observer, result))
+            break;
+        e.player = 1;
+        notifyObserver(observer, e, p2);
+        if constexpr (isAsyncPlayer<P2>)
+            p = co_await p2->recommendAttackAsync();
+        else
+            p = p2->recommendAttack();
+        if (resolveShot(p2, p, b1, 1, observer, result))
+            break;
+    }
+    observer.matchEnded();
+}
+
+#endif // BATTLESHIP_COROUTINES
+
+#endif // ASYNCMATCH_INCLUDED
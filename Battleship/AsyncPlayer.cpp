@@ -0,0 +1,138 @@
+#include "AsyncPlayer.h"
+
+#if BATTLESHIP_COROUTINES
+
+#include "Board.h"
+#include "Game.h"
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+Async<bool> StreamLines::nextLine(string& line)
+{
+    return bool(getline(m_in, line));
+}
+
+Async<bool> MailboxLines::nextLine(string& line)
+{
+    line = co_await m_box.receive();
+    co_return true;
+}
+
+  // Read two integers from line, as getLineWithTwoIntegers does from cin
+static bool twoIntegers(const string& line, int& r, int& c)
+{
+    istringstream in(line);
+    return bool(in >> r >> c);
+}
+
+AsyncHumanPlayer::AsyncHumanPlayer(string nm, const Game& g, LineSource& lines, ostream& out)
+ : AsyncPlayer(nm, g), m_lines(lines), m_out(out)
+{}
+
+bool AsyncHumanPlayer::isHuman() const
+{
+    return true;
+}
+
+Async<bool> AsyncHumanPlayer::placeShipsAsync(Board& b)
+{
+    return placeFrom(m_lines, m_out, b);
+}
+
+Async<Point> AsyncHumanPlayer::recommendAttackAsync()
+{
+    return attackFrom(m_lines, m_out);
+}
+
+  // Reading cin never suspends, so these run to the end at once
+bool AsyncHumanPlayer::placeShips(Board& b)
+{
+    StreamLines in(cin);
+    bool placed = false;
+    placeFrom(in, cout, b).runNow(placed);
+    return placed;
+}
+
+Point AsyncHumanPlayer::recommendAttack()
+{
+    StreamLines in(cin);
+    Point p(-1, -1);
+    attackFrom(in, cout).runNow(p);
+    return p;
+}
+
+Async<bool> AsyncHumanPlayer::placeFrom(LineSource& lines, ostream& out, Board& b)
+{
+    out << name() << " must place " << game().nShips() << " ships." << endl;
+    string line;
+    for (int i = 0; i < game().nShips(); i++)
+    {
+        Direction dir;
+        for (;;)
+        {
+            out << "Enter h or v for direction of " << game().shipName(i)
+                << " (length " << game().shipLength(i) << "): " << flush;
+            if (!co_await lines.nextLine(line))
+                co_return false;
+            size_t k = line.find_first_not_of(" \t");
+            char direction = (k == string::npos ? ' ' : line[k]);
+            if (direction == 'h'  ||  direction == 'v')
+            {
+                dir = (direction == 'h' ? HORIZONTAL : VERTICAL);
+                break;
+            }
+            out << "Direction must be h or v." << endl;
+        }
+        for (;;)
+        {
+            out << "Enter row and column of " << (dir == HORIZONTAL ? "leftmost" : "topmost")
+                << " cell (e.g. 3 5): " << flush;
+            if (!co_await lines.nextLine(line))
+                co_return false;
+            int r;
+            int c;
+            if (!twoIntegers(line, r, c))
+                out << "You must enter two integers." << endl;
+            else if (b.placeShip(Point(r, c), i, dir))
+                break;
+            else
+                out << "The ship can not be placed there." << endl;
+        }
+    }
+    co_return true;
+}
+
+Async<Point> AsyncHumanPlayer::attackFrom(LineSource& lines, ostream& out)
+{
+    string line;
+    for (;;)
+    {
+        out << "Enter the row and column to attack (e.g, 3 5): " << flush;
+        if (!co_await lines.nextLine(line))
+            co_return Point(-1, -1);
+        int r;
+        int c;
+        if (twoIntegers(line, r, c))
+            co_return Point(r, c);
+    }
+}
+
+void AsyncHumanPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
+                                          bool shipDestroyed, int shipId)
+{
+    //does nothing for a human player
+}
+
+void AsyncHumanPlayer::recordAttackByOpponent(Point p)
+{
+    //does nothing for a human player
+}
+
+void AsyncHumanPlayer::reset()
+{
+    //a human remembers what they like
+}
+
+#endif // BATTLESHIP_COROUTINES
@@ -0,0 +1,95 @@
+#ifndef ASYNCPLAYER_INCLUDED
+#define ASYNCPLAYER_INCLUDED
+
+#include "Coroutine.h"
+
+#if BATTLESHIP_COROUTINES
+
+#include "Player.h"
+#include "globals.h"
+#include <iosfwd>
+#include <string>
+#include <type_traits>
+
+  // A player whose decisions may have to wait for something, like a
+  // person typing or a move arriving from elsewhere.  placeShipsAsync and
+  // recommendAttackAsync are coroutines that can suspend until then, so
+  // the match (see runMatchAsync) doesn't hold up its thread.  Recording
+  // results never waits, so those stay as they are in Player.
+class AsyncPlayer : public Player
+{
+  public:
+    AsyncPlayer(std::string nm, const Game& g) : Player(nm, g) {}
+    virtual Async<bool> placeShipsAsync(Board& b) = 0;
+    virtual Async<Point> recommendAttackAsync() = 0;
+};
+
+  // Whether a player of type P may suspend a match, which only an
+  // AsyncPlayer type can
+template <class P>
+constexpr bool isAsyncPlayer = std::is_base_of<AsyncPlayer, P>::value;
+
+  // Where an AsyncHumanPlayer's answers come from, a line at a time
+class LineSource
+{
+  public:
+    virtual ~LineSource() {}
+      // Set line to the next line; false if there are no more
+    virtual Async<bool> nextLine(std::string& line) = 0;
+};
+
+  // Lines read from a stream, which are always ready
+class StreamLines final : public LineSource
+{
+  public:
+    explicit StreamLines(std::istream& in) : m_in(in) {}
+    virtual Async<bool> nextLine(std::string& line);
+
+  private:
+    std::istream& m_in;
+};
+
+  // Lines sent from anywhere, such as a thread reading a terminal or a
+  // socket; the player waits for each
+class MailboxLines final : public LineSource
+{
+  public:
+    explicit MailboxLines(Scheduler& s) : m_box(s) {}
+    void send(std::string line) { m_box.send(std::move(line)); }
+      // Whether the player is waiting for a line
+    bool waiting() const { return m_box.waiting(); }
+    virtual Async<bool> nextLine(std::string& line);
+
+  private:
+    Mailbox<std::string> m_box;
+};
+
+  // HumanPlayer, asking its questions on out and waiting for each answer
+  // from lines.  Called through Player's interface, it asks on cout and
+  // reads cin instead, as HumanPlayer does.  Once its lines run out it
+  // places nothing and fires off the board.
+class AsyncHumanPlayer final : public AsyncPlayer
+{
+  public:
+    AsyncHumanPlayer(std::string nm, const Game& g, LineSource& lines, std::ostream& out);
+    virtual bool isHuman() const;
+    virtual Async<bool> placeShipsAsync(Board& b);
+    virtual Async<Point> recommendAttackAsync();
+    virtual bool placeShips(Board& b);
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+                                    bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+    virtual void reset();
+
+  private:
+    LineSource& m_lines;
+    std::ostream& m_out;
+
+    Async<bool> placeFrom(LineSource& lines, std::ostream& out, Board& b);
+    Async<Point> attackFrom(LineSource& lines, std::ostream& out);
+};
+
+#endif // BATTLESHIP_COROUTINES
+
+#endif // ASYNCPLAYER_INCLUDED
@@ -0,0 +1,130 @@
+#ifndef BITGRID_INCLUDED
+#define BITGRID_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+  // A rows x cols grid of bits, stored row-major.  Each row is padded out to
+  // a whole number of 64-bit words, so column c of row r is bit (c % 64) of
+  // word (c / 64) of that row.  Keeping rows word-aligned lets a horizontal
+  // run of cells be tested or changed with a couple of mask operations.
+class BitGrid
+{
+  public:
+    BitGrid() : m_rows(0), m_cols(0), m_wordsPerRow(0) {}
+    BitGrid(int nRows, int nCols) { resize(nRows, nCols); }
+
+    void resize(int nRows, int nCols)
+    {
+        m_rows = nRows;
+        m_cols = nCols;
+        m_wordsPerRow = (nCols + 63) / 64;
+        m_words.assign(m_rows * m_wordsPerRow, 0);
+    }
+
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int wordsPerRow() const { return m_wordsPerRow; }
+
+    bool test(int r, int c) const
+    {
+        return (word(r, c) >> (c & 63)) & 1;
+    }
+    void set(int r, int c)   { word(r, c) |= bit(c); }
+    void reset(int r, int c) { word(r, c) &= ~bit(c); }
+
+    void clear()
+    {
+        for (std::size_t i = 0; i < m_words.size(); i++)
+            m_words[i] = 0;
+    }
+
+    bool any() const
+    {
+        for (std::size_t i = 0; i < m_words.size(); i++)
+            if (m_words[i] != 0)
+                return true;
+        return false;
+    }
+
+    int count() const
+    {
+        int n = 0;
+        for (std::size_t i = 0; i < m_words.size(); i++)
+            n += __builtin_popcountll(m_words[i]);
+        return n;
+    }
+
+      // Horizontal runs of len cells starting at (r,c); the run must lie
+      // within the row.
+    bool anyInRun(int r, int c, int len) const
+    {
+        for (int end = c + len; c < end; )
+        {
+            int n = runInWord(c, end);
+            if (word(r, c) & runMask(c, n))
+                return true;
+            c += n;
+        }
+        return false;
+    }
+    bool allInRun(int r, int c, int len) const
+    {
+        for (int end = c + len; c < end; )
+        {
+            int n = runInWord(c, end);
+            uint64_t m = runMask(c, n);
+            if ((word(r, c) & m) != m)
+                return false;
+            c += n;
+        }
+        return true;
+    }
+    void setRun(int r, int c, int len)
+    {
+        for (int end = c + len; c < end; )
+        {
+            int n = runInWord(c, end);
+            word(r, c) |= runMask(c, n);
+            c += n;
+        }
+    }
+    void resetRun(int r, int c, int len)
+    {
+        for (int end = c + len; c < end; )
+        {
+            int n = runInWord(c, end);
+            word(r, c) &= ~runMask(c, n);
+            c += n;
+        }
+    }
+
+    uint64_t* row(int r) { return &m_words[r * m_wordsPerRow]; }
+    const uint64_t* row(int r) const { return &m_words[r * m_wordsPerRow]; }
+
+  private:
+    int m_rows;
+    int m_cols;
+    int m_wordsPerRow;
+    std::vector<uint64_t> m_words;
+
+    uint64_t& word(int r, int c) { return m_words[r * m_wordsPerRow + (c >> 6)]; }
+    uint64_t word(int r, int c) const { return m_words[r * m_wordsPerRow + (c >> 6)]; }
+    static uint64_t bit(int c) { return uint64_t(1) << (c & 63); }
+
+      // Number of cells of the run [c, end) that lie in c's word
+    static int runInWord(int c, int end)
+    {
+        int room = 64 - (c & 63);
+        return end - c < room ? end - c : room;
+    }
+      // n consecutive bits starting at c's position in its word
+    static uint64_t runMask(int c, int n)
+    {
+        uint64_t m = (n == 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1);
+        return m << (c & 63);
+    }
+};
+
+#endif // BITGRID_INCLUDED
@@ -1,33 +1,130 @@
 #include "Board.h"
 #include "Game.h"
 #include "globals.h"
+#include "BitGrid.h"
+#include "BoardT.h"
+#include <cstdint>
 #include <iostream>
+#include <vector>
 
 using namespace std;
 
+  // The interface shared by the board implementations.  Board picks one
+  // when it is constructed, based on the game's size and fleet.
 class BoardImpl
 {
   public:
-    BoardImpl(const Game& g);
-    void clear();
-    void block();
-    void unblock();
-    bool placeShip(Point topOrLeft, int shipId, Direction dir);
-    bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
-    void display(bool shotsOnly) const;
-    bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
-    bool allShipsDestroyed() const;
+    virtual ~BoardImpl() {}
+    virtual void clear() = 0;
+    virtual void block() = 0;
+    virtual void unblock() = 0;
+    virtual bool placeShip(Point topOrLeft, int shipId, Direction dir) = 0;
+    virtual bool unplaceShip(Point topOrLeft, int shipId, Direction dir) = 0;
+    virtual void display(bool shotsOnly) const = 0;
+    virtual bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId) = 0;
+    virtual bool unattack(Point p) = 0;
+    virtual bool allShipsDestroyed() const = 0;
+    virtual bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const = 0;
+    virtual const Game& game() const = 0;
+      // other is for the same game, so it is the same kind of BoardImpl
+    virtual void copyFrom(const BoardImpl& other) = 0;
+};
+
+//******************** FixedBoardImpl *********************************
+
+  // For the common board sizes, a BoardT whose placement tables and loop
+  // bounds are fixed at compile time
+template <int Rows, int Cols>
+class FixedBoardImpl : public BoardImpl
+{
+  public:
+    FixedBoardImpl(const Game& g) : m_board(g) {}
+    virtual void clear() { m_board.clear(); }
+    virtual void block() { m_board.block(); }
+    virtual void unblock() { m_board.unblock(); }
+    virtual bool placeShip(Point topOrLeft, int shipId, Direction dir)
+    {
+        return m_board.placeShip(topOrLeft, shipId, dir);
+    }
+    virtual bool unplaceShip(Point topOrLeft, int shipId, Direction dir)
+    {
+        return m_board.unplaceShip(topOrLeft, shipId, dir);
+    }
+    virtual void display(bool shotsOnly) const { m_board.display(shotsOnly); }
+    virtual bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
+    {
+        return m_board.attack(p, shotHit, shipDestroyed, shipId);
+    }
+    virtual bool unattack(Point p) { return m_board.unattack(p); }
+    virtual bool allShipsDestroyed() const { return m_board.allShipsDestroyed(); }
+    virtual bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+    {
+        return m_board.shipPlacement(shipId, topOrLeft, dir);
+    }
+    virtual const Game& game() const { return m_board.game(); }
+    virtual void copyFrom(const BoardImpl& other)
+    {
+        m_board = static_cast<const FixedBoardImpl&>(other).m_board;
+    }
+
+    static bool supports(const Game& g) { return BoardT<Rows, Cols>::supports(g); }
+
+  private:
+    BoardT<Rows, Cols> m_board;
+};
+
+//******************** GridBoardImpl **********************************
+
+  // Any other board, with storage sized at run time
+class GridBoardImpl : public BoardImpl
+{
+  public:
+    GridBoardImpl(const Game& g);
+    virtual void clear();
+    virtual void block();
+    virtual void unblock();
+    virtual bool placeShip(Point topOrLeft, int shipId, Direction dir);
+    virtual bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
+    virtual void display(bool shotsOnly) const;
+    virtual bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+    virtual bool unattack(Point p);
+    virtual bool allShipsDestroyed() const;
+    virtual bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const;
+    virtual const Game& game() const;
+    virtual void copyFrom(const BoardImpl& other);
 
   private:
-      // TODO:  Decide what private members you need.  Here's one that's likely
-      //        to be useful:
     const Game& m_game;
-    char board [MAXROWS][MAXCOLS];
     int m_rows;
     int m_cols;
+    BitGrid m_occupied;              //cells covered by some ship
+    BitGrid m_shots;                 //cells that have been attacked
+    BitGrid m_blocked;               //cells blocked by block()
+    int m_cellsLeft;                 //unhit ship cells left on the board
+      // One plus the id of the ship on each cell, 0 for none, by
+      // r * cols + c, so an attack finds its ship in one lookup however
+      // big the fleet.  Ship symbols are distinct printable ASCII
+      // characters, so there are fewer than 255 ships.
+    vector<uint8_t> m_shipAt;
+
+      // Where a ship sits.  A ship is a straight run of cells, so this is
+      // all that's needed to tell which cells it covers; a full-board mask
+      // per ship would cost far too much on large boards.
+    struct ShipPlacement
+    {
+        bool placed;
+        Point topOrLeft;
+        Direction dir;
+        int health;                  //unhit cells left on the ship
+    };
+    vector<ShipPlacement> m_ships;
+
+    bool footprintFits(Point topOrLeft, int length, Direction dir) const;
+    int shipAt(Point p) const;
+    void markShip(Point topOrLeft, int length, Direction dir, uint8_t value);
 };
 
-BoardImpl::BoardImpl(const Game& g)
+GridBoardImpl::GridBoardImpl(const Game& g)
  : m_game(g)
 {
     m_rows = m_game.rows();
@@ -36,43 +133,85 @@ BoardImpl::BoardImpl(const Game& g)
     clear();
 }
 
-void BoardImpl::clear()
+void GridBoardImpl::clear()
 {
-    for (int i = 0; i < m_rows; i++)
+    if (m_shipAt.size() != size_t(m_rows) * m_cols)
     {
-        for (int j = 0; j < m_cols; j++)
+        m_shipAt.assign(size_t(m_rows) * m_cols, 0);
+    }
+    else
+    {
+        for (size_t i = 0; i < m_ships.size(); i++) //cheaper than every cell on a big board
         {
-            board[i][j] = '.';      //clear the board by putting '.' every point
+            if (m_ships[i].placed)
+            {
+                markShip(m_ships[i].topOrLeft, m_game.shipLength(i), m_ships[i].dir, 0);
+            }
         }
     }
+    m_occupied.resize(m_rows, m_cols);
+    m_shots.resize(m_rows, m_cols);
+    m_blocked.resize(m_rows, m_cols);
+    ShipPlacement none = { false, Point(), HORIZONTAL, 0 };
+    m_ships.assign(m_game.nShips(), none);
+    m_cellsLeft = 0;
 }
 
-void BoardImpl::block()
+void GridBoardImpl::block()
 {
-      // Block cells with 50% probability
-    for (int r = 0; r < m_game.rows(); r++)
-        for (int c = 0; c < m_game.cols(); c++)
-            if (randInt(2) == 0)
-            {
-                board[r][c] = '#'; //# sign used to denote a blocked location
-            }
+      // Block cells with 50% probability, 64 cells per random draw
+    RandomEngine& rng = m_game.rng();
+    int lastBits = m_cols % 64; //used cells in the last word of a row
+    uint64_t lastMask = (lastBits == 0 ? ~uint64_t(0) : (uint64_t(1) << lastBits) - 1);
+    for (int r = 0; r < m_rows; r++)
+    {
+        uint64_t* row = m_blocked.row(r);
+        for (int w = 0; w < m_blocked.wordsPerRow(); w++)
+        {
+            row[w] = rng.next(); //blocked cells can't hold a ship
+        }
+        row[m_blocked.wordsPerRow()-1] &= lastMask; //nothing past the last column
+    }
 }
 
-void BoardImpl::unblock()
+void GridBoardImpl::unblock()
 {
-    for (int r = 0; r < m_game.rows(); r++)
-        for (int c = 0; c < m_game.cols(); c++)
+    m_blocked.clear();
+}
+
+bool GridBoardImpl::footprintFits(Point topOrLeft, int length, Direction dir) const
+{
+    if (dir == HORIZONTAL) //for horizontal only column increases
+    {
+        if (topOrLeft.c + length > m_cols)
+        {
+            return false; //ship would hang off the right edge
+        }
+        return !m_occupied.anyInRun(topOrLeft.r, topOrLeft.c, length) &&
+               !m_blocked.anyInRun(topOrLeft.r, topOrLeft.c, length);
+    }
+    else if (dir == VERTICAL) //for vertical only row increases
+    {
+        if (topOrLeft.r + length > m_rows)
+        {
+            return false; //ship would hang off the bottom edge
+        }
+        for (int i = 0; i < length; i++)
         {
-            if (board[r][c] == '#')
+            if (m_occupied.test(topOrLeft.r+i, topOrLeft.c) ||
+                m_blocked.test(topOrLeft.r+i, topOrLeft.c))
             {
-                board[r][c] = '.'; //unblock by putting back the period
+                return false; //overlaps a ship or a blocked cell
             }
         }
+        return true;
+    }
+    return false;
 }
 
-bool BoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
+bool GridBoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
 {
-    if (shipId < 0 || shipId>=m_game.nShips())
+    if (shipId < 0 || shipId >= static_cast<int>(m_ships.size()))
     {
         return false;   //if shipId is negative or bigger than the number of ships is false
     }
@@ -80,73 +219,37 @@ bool BoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
     {
         return false; //point is outside of the board
     }
-    if (board[topOrLeft.r][topOrLeft.c] != '.')
+    if (m_ships[shipId].placed)
     {
-        return false;   //if ship overlaps already placed ship or is blocked
+        return false;   //if the ship is already on the board, return false
     }
-    char idCheck = m_game.shipSymbol(shipId);
-    for (int i = 0; i < m_rows; i++)
+    int length = m_game.shipLength(shipId);
+    if (!footprintFits(topOrLeft, length, dir))
     {
-        for (int j = 0; j < m_cols; j++)
-        {
-            if (board[i][j] == idCheck)
-            {
-                return false;   //if the ship symbol is already on the board, return false
-            }
-        }
+        return false; //ship overlaps another ship, is blocked, or is off the board
     }
     
-    //check overlap ship or if ship would be partly or fully outside the board
-    
-    if (dir == HORIZONTAL) //for horizontal only column increases
+    if (dir == HORIZONTAL)
     {
-        for (int i = 0; i < m_game.shipLength(shipId); i++)
-        {
-            if (board[topOrLeft.r][topOrLeft.c + i] != '.')
-            {
-                return false;    //if not an empty spot on the board return false
-            }
-            Point temp(topOrLeft.r, topOrLeft.c+i);
-            if (m_game.isValid(temp) == false)
-            {
-                return false; //if not a point on the board return false
-            }
-        }
-        //check all points before placing the ships with the symbol and returning true
-        for (int i = 0; i < m_game.shipLength(shipId); i++)
-        {
-            board[topOrLeft.r][topOrLeft.c+i] = idCheck; //set the board to the ship symbol
-        }
-        return true;
+        m_occupied.setRun(topOrLeft.r, topOrLeft.c, length);
     }
-    else if (dir == VERTICAL) //for vertical only row increases
+    else
     {
-        for (int i = 0; i < m_game.shipLength(shipId); i++)
-        {
-            if (board[topOrLeft.r+i][topOrLeft.c] != '.')
-            {
-                return false;    //if not an empty spot on the board return false
-            }
-            Point temp(topOrLeft.r+i, topOrLeft.c);
-            if (m_game.isValid(temp) == false)
-            {
-                return false; //if not a point on the board return false
-            }
-        }
-        //check all points before placing the ships with the symbol and returning true
-        for (int i = 0; i < m_game.shipLength(shipId); i++)
+        for (int i = 0; i < length; i++)
         {
-            board[topOrLeft.r+i][topOrLeft.c] = idCheck; //set the board to the ship symbol
+            m_occupied.set(topOrLeft.r+i, topOrLeft.c);
         }
-        return true;
     }
-    
+    markShip(topOrLeft, length, dir, uint8_t(shipId + 1));
+    ShipPlacement placement = { true, topOrLeft, dir, length };
+    m_ships[shipId] = placement;
+    m_cellsLeft += length;
     return true;
 }
 
-bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
+bool GridBoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
 {
-    if (shipId < 0 || shipId>=m_game.nShips())
+    if (shipId < 0 || shipId >= static_cast<int>(m_ships.size()))
     {
         return false;   //if shipId is negative or bigger than the number of ships is false
     }
@@ -155,53 +258,47 @@ bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
         return false; //point is outside of the board
     }
     
-    char shipSymbol = m_game.shipSymbol(shipId);
-    
+    ShipPlacement& ship = m_ships[shipId];
+    if (!ship.placed  ||  ship.dir != dir  ||
+        ship.topOrLeft.r != topOrLeft.r  ||  ship.topOrLeft.c != topOrLeft.c)
+    {
+        return false;    //the ship is not at that spot
+    }
+    int length = m_game.shipLength(shipId);
     if (dir == HORIZONTAL)
     {
-        for (int i = 0; i < m_game.shipLength(shipId); i++)
-        {
-            if (board[topOrLeft.r][topOrLeft.c + i] != shipSymbol)
-            {
-                return false;    //if not correct ship symbol return false
-            }
-            Point temp(topOrLeft.r, topOrLeft.c+i);
-            if (m_game.isValid(temp) == false)
-            {
-                return false; //if not a point on the board return false
-            }
-        }
-        for (int i = 0; i < m_game.shipLength(shipId); i++)
-        {
-            board[topOrLeft.r][topOrLeft.c+i] = '.'; //set the board back to empty
-        }
-        return true;
+        m_occupied.resetRun(topOrLeft.r, topOrLeft.c, length);
     }
-    else if (dir == VERTICAL)
+    else
     {
-        for (int i = 0; i < m_game.shipLength(shipId); i++)
-        {
-            if (board[topOrLeft.r+i][topOrLeft.c] != shipSymbol)
-            {
-                return false;    //if not correct ship symbol return false
-            }
-            Point temp(topOrLeft.r+i, topOrLeft.c);
-            if (m_game.isValid(temp) == false)
-            {
-                return false; //if not a point on the board return false
-            }
-        }
-        for (int i = 0; i < m_game.shipLength(shipId); i++)
+        for (int i = 0; i < length; i++)
         {
-            board[topOrLeft.r+i][topOrLeft.c] = '.'; //set the board back to empty
+            m_occupied.reset(topOrLeft.r+i, topOrLeft.c);
         }
-        return true;
     }
-    
+    markShip(topOrLeft, length, dir, 0);
+    m_cellsLeft -= ship.health;
+    ship.placed = false;
+    ship.health = 0;
     return true;
 }
 
-void BoardImpl::display(bool shotsOnly) const
+int GridBoardImpl::shipAt(Point p) const
+{
+    return int(m_shipAt[size_t(p.r) * m_cols + p.c]) - 1; //-1 if no ship there
+}
+
+void GridBoardImpl::markShip(Point topOrLeft, int length, Direction dir, uint8_t value)
+{
+    size_t cell = size_t(topOrLeft.r) * m_cols + topOrLeft.c;
+    size_t step = (dir == HORIZONTAL ? 1 : m_cols);
+    for (int i = 0; i < length; i++, cell += step)
+    {
+        m_shipAt[cell] = value;
+    }
+}
+
+void GridBoardImpl::display(bool shotsOnly) const
 {
     cout << "  "; //two spaces
     for (int i = 0; i < m_cols; i++)
@@ -211,111 +308,106 @@ void BoardImpl::display(bool shotsOnly) const
     cout << endl; //newline
     //END OF FIRST LINE
     
-    if (shotsOnly) //if shots only is true
+    for (int i = 0; i < m_rows; i++)
     {
-        for (int i = 0; i < m_rows; i++)
+        cout << i << " "; //row number with space
+        for (int j = 0; j < m_cols; j++)
         {
-            cout << i << " "; //row number with space
-            for (int j = 0; j < m_cols; j++)
+            if (m_shots.test(i, j))
             {
-               if ((board[i][j] != 'X') && (board[i][j] != 'o'))
-               {
-                   cout << '.'; //if a ship is here replace with period
-               }
-               else {
-                   cout << board[i][j]; //just print the X or the o for the shots
-               }
+                cout << (m_occupied.test(i, j) ? 'X' : 'o'); //hit or miss
             }
-            cout << endl; //newline
-        }
-    }
-    else
-    {
-        for (int i = 0; i < m_rows; i++)
-        {
-            cout << i << " "; //row number with space
-            for (int j = 0; j < m_cols; j++)
+            else if (shotsOnly)
+            {
+                cout << '.'; //if only shots are shown, hide the ships
+            }
+            else if (m_blocked.test(i, j))
             {
-                cout << board[i][j]; //contents of current row
+                cout << '#';
+            }
+            else if (m_occupied.test(i, j))
+            {
+                cout << m_game.shipSymbol(shipAt(Point(i, j)));
+            }
+            else
+            {
+                cout << '.';
             }
-            cout << endl; //newline
         }
+        cout << endl; //newline
     }
 }
 
-bool BoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
+bool GridBoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
 {
-    if (m_game.isValid(p) == false)
-    {
-        shipDestroyed = false;
-        shotHit = false;
-        shipId = -1; //make shipId -1 to say it failed
-        return false; //point is outside of the board
-    }
-    if ((board[p.r][p.c] == 'X') || (board[p.r][p.c] == 'o'))
+    if (m_game.isValid(p) == false  ||  m_shots.test(p.r, p.c))
     {
         shipDestroyed = false;
         shotHit = false;
         shipId = -1; //make shipId -1 to say it failed
-        return false; //point has already been attacked previously
+        return false; //point is outside of the board or was attacked previously
     }
-    if (board[p.r][p.c] == '.')
+    m_shots.set(p.r, p.c);
+    if (!m_occupied.test(p.r, p.c))
     {
-        board[p.r][p.c] = 'o'; //if point was empty, set to a miss
         shotHit = false;
         shipDestroyed = false; //ship wasn't hit or destroyed so bools set to false
         shipId = -1; //make shipId -1 to say it failed
         return true;
     }
-    else
+    
+    shotHit = true; //hit the ship
+    shipId = shipAt(p);
+    m_cellsLeft--;
+    shipDestroyed = (--m_ships[shipId].health == 0); //no unhit cells left on that ship
+    return true;
+}
+
+bool GridBoardImpl::unattack(Point p)
+{
+    if (m_game.isValid(p) == false  ||  !m_shots.test(p.r, p.c))
     {
-        char shipSymbol = board[p.r][p.c];
-        board[p.r][p.c] = 'X';
-        shotHit = true; //hit the ship
-        bool shipLeft = false;
-        for (int i = 0; i < m_rows; i++)
-        {
-            for (int j = 0; j < m_cols; j++)
-            {
-                if (board[i][j] == shipSymbol)
-                {
-                    shipLeft = true; //if the ship that we just hit has symbols still on board, set shipLeft to true
-                }
-            }
-        }
-        if (shipLeft)
-        {
-            shipDestroyed = false; //part of the ship is still on the board so not destroyed
-        }
-        else
-        {
-            shipDestroyed = true;
-        }
-        for (int i = 0; i < m_game.nShips(); i++)
-        {
-            if (m_game.shipSymbol(i) == shipSymbol)
-            {
-                shipId = i; //set the matching ship symbol to shipId
-            }
-        }
-        
-        return true;
+        return false; //point is outside of the board or wasn't attacked
+    }
+    m_shots.reset(p.r, p.c);
+    if (m_occupied.test(p.r, p.c))
+    {
+        m_ships[shipAt(p)].health++; //the hit is undone
+        m_cellsLeft++;
     }
+    return true;
 }
 
-bool BoardImpl::allShipsDestroyed() const
+bool GridBoardImpl::allShipsDestroyed() const
 {
-    for (int i = 0; i < m_rows; i++)
+    return m_cellsLeft == 0; //every ship cell has been hit
+}
+
+bool GridBoardImpl::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+{
+    if (shipId < 0 || shipId >= static_cast<int>(m_ships.size()) || !m_ships[shipId].placed)
     {
-        for (int j = 0; j < m_cols; j++)
-        {
-            if ((board[i][j] != '.')&&(board[i][j] != 'X') && (board[i][j] != 'o'))
-            {
-                return false; //it is character other than empty board, hit and miss
-            }
-        }
+        return false; //no such ship, or it hasn't been placed
     }
-    return true; //only '.', 'X', and 'o' remain
+    topOrLeft = m_ships[shipId].topOrLeft;
+    dir = m_ships[shipId].dir;
+    return true;
+}
+
+const Game& GridBoardImpl::game() const
+{
+    return m_game;
+}
+
+void GridBoardImpl::copyFrom(const BoardImpl& other)
+{
+    const GridBoardImpl& o = static_cast<const GridBoardImpl&>(other);
+    m_occupied = o.m_occupied; //same sizes, so the vectors keep their storage
+    m_shots = o.m_shots;
+    m_blocked = o.m_blocked;
+    m_cellsLeft = o.m_cellsLeft;
+    m_shipAt = o.m_shipAt;
+    m_ships = o.m_ships;
 }
 
 //******************** Board functions ********************************
@@ -323,9 +415,20 @@ bool BoardImpl::allShipsDestroyed() const
 // These functions simply delegate to BoardImpl's functions.
 // You probably don't want to change any of this code.
 
+static BoardImpl* makeBoardImpl(const Game& g)
+{
+    if (FixedBoardImpl<10, 10>::supports(g))
+        return new FixedBoardImpl<10, 10>(g);
+    if (FixedBoardImpl<8, 8>::supports(g))
+        return new FixedBoardImpl<8, 8>(g);
+    if (FixedBoardImpl<12, 12>::supports(g))
+        return new FixedBoardImpl<12, 12>(g);
+    return new GridBoardImpl(g);
+}
+
 Board::Board(const Game& g)
 {
-    m_impl = new BoardImpl(g);
+    m_impl = makeBoardImpl(g);
 }
 
 Board::~Board()
@@ -368,7 +471,26 @@ bool Board::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
     return m_impl->attack(p, shotHit, shipDestroyed, shipId);
 }
 
+bool Board::unattack(Point p)
+{
+    return m_impl->unattack(p);
+}
+
 bool Board::allShipsDestroyed() const
 {
     return m_impl->allShipsDestroyed();
 }
+
+bool Board::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+{
+    return m_impl->shipPlacement(shipId, topOrLeft, dir);
+}
+
+bool Board::copyFrom(const Board& other)
+{
+    if (&m_impl->game() != &other.m_impl->game())
+        return false;
+    if (this != &other)
+        m_impl->copyFrom(*other.m_impl);
+    return true;
+}
@@ -18,7 +18,17 @@ class Board
     bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
     void display(bool shotsOnly) const;
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+      // Take back the shot at p, as if it had never been made; returns
+      // false if p hasn't been attacked.  Shots must be taken back before
+      // any placement made after them is.
+    bool unattack(Point p);
     bool allShipsDestroyed() const;
+      // Where ship shipId sits; returns false if it isn't on the board
+    bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const;
+      // Make this board a copy of other, ships, shots and blocked cells;
+      // returns false if other belongs to a different game.  Unlike
+      // copying a Board, this reuses this board's storage.
+    bool copyFrom(const Board& other);
       // We prevent a Board object from being copied or assigned
     Board(const Board&) = delete;
     Board& operator=(const Board&) = delete;
@@ -0,0 +1,321 @@
+#ifndef BOARDT_INCLUDED
+#define BOARDT_INCLUDED
+
+#include "globals.h"
+#include "Game.h"
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+
+  // A fixed-size set of cells of a Rows x Cols board, one bit per cell, cell
+  // (r,c) being bit r*Cols+c
+template <int Rows, int Cols>
+struct CellMask
+{
+    static constexpr int NWORDS = (Rows * Cols + 63) / 64;
+    uint64_t w[NWORDS] = {};
+
+    constexpr void set(int cell) { w[cell >> 6] |= uint64_t(1) << (cell & 63); }
+    constexpr void reset(int cell) { w[cell >> 6] &= ~(uint64_t(1) << (cell & 63)); }
+    constexpr bool test(int cell) const { return (w[cell >> 6] >> (cell & 63)) & 1; }
+
+    bool any() const
+    {
+        uint64_t x = 0;
+        for (int i = 0; i < NWORDS; i++)
+            x |= w[i];
+        return x != 0;
+    }
+    bool intersects(const CellMask& m) const
+    {
+        uint64_t x = 0;
+        for (int i = 0; i < NWORDS; i++)
+            x |= w[i] & m.w[i];
+        return x != 0;
+    }
+    bool operator==(const CellMask& m) const
+    {
+        for (int i = 0; i < NWORDS; i++)
+            if (w[i] != m.w[i])
+                return false;
+        return true;
+    }
+    CellMask& operator|=(const CellMask& m)
+    {
+        for (int i = 0; i < NWORDS; i++)
+            w[i] |= m.w[i];
+        return *this;
+    }
+    CellMask& andNot(const CellMask& m)
+    {
+        for (int i = 0; i < NWORDS; i++)
+            w[i] &= ~m.w[i];
+        return *this;
+    }
+    int count() const
+    {
+        int n = 0;
+        for (int i = 0; i < NWORDS; i++)
+            n += __builtin_popcountll(w[i]);
+        return n;
+    }
+};
+
+  // Every legal placement on a Rows x Cols board of a ship of length 1
+  // through MaxLength, as a cell mask indexed by length, direction and the
+  // top or left cell.  Built at compile time; fits says whether the
+  // placement stays on the board.
+template <int Rows, int Cols, int MaxLength>
+struct PlacementTable
+{
+    CellMask<Rows, Cols> mask[MaxLength+1][2][Rows * Cols];
+    bool fits[MaxLength+1][2][Rows * Cols];
+
+    constexpr PlacementTable() : mask(), fits()
+    {
+        for (int len = 1; len <= MaxLength; len++)
+            for (int r = 0; r < Rows; r++)
+                for (int c = 0; c < Cols; c++)
+                {
+                    if (c + len <= Cols)
+                    {
+                        fits[len][HORIZONTAL][r*Cols+c] = true;
+                        for (int i = 0; i < len; i++)
+                            mask[len][HORIZONTAL][r*Cols+c].set(r*Cols + c+i);
+                    }
+                    if (r + len <= Rows)
+                    {
+                        fits[len][VERTICAL][r*Cols+c] = true;
+                        for (int i = 0; i < len; i++)
+                            mask[len][VERTICAL][r*Cols+c].set((r+i)*Cols + c);
+                    }
+                }
+    }
+};
+
+  // A board whose size is known at compile time.  It offers the same
+  // operations as Board, but every ship footprint comes from a precomputed
+  // PlacementTable and every loop has a constant bound, so placing and
+  // attacking are a handful of word operations.  It handles games of
+  // exactly Rows x Cols with at most MaxShips ships of length at most
+  // MaxLength (see supports()); Board falls back to its run-time sized
+  // implementation for anything else.
+  //
+  // Everything about a position, apart from the blocked cells and the
+  // cell-to-ship table, is in a State of a few dozen bytes (56 at 10x10),
+  // so copying a board (see Board::copyFrom) is cheap.  Within a search,
+  // placeShip and unplaceShip make and unmake placements, and attack and
+  // unattack make and unmake shots.
+template <int Rows, int Cols, int MaxShips = 8, int MaxLength = 6>
+class BoardT
+{
+    static_assert(MaxShips <= 32, "placed ships are tracked in an unsigned");
+
+  public:
+    typedef CellMask<Rows, Cols> Mask;
+    typedef PlacementTable<Rows, Cols, MaxLength> Table;
+    static constexpr Table TABLE = Table();
+
+    static bool supports(const Game& g)
+    {
+        if (g.rows() != Rows  ||  g.cols() != Cols  ||  g.nShips() > MaxShips)
+            return false;
+        for (int i = 0; i < g.nShips(); i++)
+            if (g.shipLength(i) > MaxLength)
+                return false;
+        return true;
+    }
+
+    typedef typename std::conditional<(Rows * Cols <= 256), uint8_t, uint16_t>::type CellIndex;
+    typedef typename std::conditional<(MaxShips <= 8), uint8_t,
+            typename std::conditional<(MaxShips <= 16), uint16_t, uint32_t>::type>::type ShipBits;
+
+    struct State
+    {
+        Mask occupied;                //cells covered by some ship
+        Mask shots;                   //cells that have been attacked
+        CellIndex where[MaxShips];    //top or left cell of each placed ship
+        uint8_t health[MaxShips];     //unhit cells left on each placed ship
+        ShipBits placed;              //bit i is set if ship i is on the board
+        ShipBits vertical;            //bit i is set if ship i is VERTICAL
+        uint16_t cellsLeft;           //unhit ship cells on the board
+    };
+    static_assert(std::is_trivially_copyable<State>::value, "a State is copied as bytes");
+
+    explicit BoardT(const Game& g)
+     : m_game(&g), m_nShips(g.nShips()), m_shipAt(), m_state()
+    {
+        for (int i = 0; i < m_nShips; i++)
+            m_length[i] = g.shipLength(i);
+        clear();
+    }
+
+    void clear()
+    {
+        for (int i = 0; i < m_nShips; i++)
+            if (isPlaced(m_state, i))
+                markShip(m_state, i, 0);
+        m_state = State();
+        m_blocked = Mask();
+    }
+
+    void block()
+    {
+          // Block cells with 50% probability, 64 cells per random draw
+        for (int i = 0; i < Mask::NWORDS; i++)
+            m_blocked.w[i] = m_game->rng().next();
+        int spare = Mask::NWORDS * 64 - Rows * Cols;
+        m_blocked.w[Mask::NWORDS-1] &= ~uint64_t(0) >> spare;
+    }
+
+    void unblock() { m_blocked = Mask(); }
+
+    bool placeShip(Point topOrLeft, int shipId, Direction dir)
+    {
+        if (shipId < 0  ||  shipId >= m_nShips  ||  !isValid(topOrLeft)  ||
+            isPlaced(m_state, shipId))
+            return false;
+        int cell = topOrLeft.r * Cols + topOrLeft.c;
+        if (!TABLE.fits[m_length[shipId]][dir][cell])
+            return false; //would run off the board
+        const Mask& footprint = TABLE.mask[m_length[shipId]][dir][cell];
+        if (footprint.intersects(m_state.occupied)  ||  footprint.intersects(m_blocked))
+            return false;
+        ShipBits bit = ShipBits(1u << shipId);
+        m_state.occupied |= footprint;
+        m_state.where[shipId] = CellIndex(cell);
+        m_state.vertical = ShipBits(dir == VERTICAL ? m_state.vertical | bit : m_state.vertical & ~bit);
+        m_state.health[shipId] = uint8_t(m_length[shipId]);
+        m_state.placed |= bit;
+        m_state.cellsLeft += m_length[shipId];
+        markShip(m_state, shipId, uint8_t(shipId + 1));
+        return true;
+    }
+
+    bool unplaceShip(Point topOrLeft, int shipId, Direction dir)
+    {
+        if (shipId < 0  ||  shipId >= m_nShips  ||  !isValid(topOrLeft)  ||
+            !isPlaced(m_state, shipId))
+            return false;
+        if (m_state.where[shipId] != topOrLeft.r * Cols + topOrLeft.c  ||
+            direction(m_state, shipId) != dir)
+            return false; //the ship is not at that spot
+        m_state.occupied.andNot(TABLE.mask[m_length[shipId]][dir][m_state.where[shipId]]);
+        markShip(m_state, shipId, 0);
+        m_state.cellsLeft -= m_state.health[shipId];
+        m_state.health[shipId] = 0;
+        m_state.placed &= ShipBits(~(1u << shipId));
+        return true;
+    }
+
+    bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
+    {
+        shotHit = false;
+        shipDestroyed = false;
+        shipId = -1;
+        if (!isValid(p))
+            return false;
+        int cell = p.r * Cols + p.c;
+        if (m_state.shots.test(cell))
+            return false;
+        m_state.shots.set(cell);
+        if (!m_state.occupied.test(cell))
+            return true;
+        shotHit = true;
+        shipId = m_shipAt[cell] - 1;
+        m_state.cellsLeft--;
+        shipDestroyed = (--m_state.health[shipId] == 0);
+        return true;
+    }
+
+      // Take back the shot at p, as if it had never been made; false if p
+      // hasn't been attacked.  Shots must be taken back before any
+      // placement made after them is.
+    bool unattack(Point p)
+    {
+        if (!isValid(p))
+            return false;
+        int cell = p.r * Cols + p.c;
+        if (!m_state.shots.test(cell))
+            return false;
+        m_state.shots.reset(cell);
+        if (m_state.occupied.test(cell))
+        {
+            m_state.health[m_shipAt[cell] - 1]++;
+            m_state.cellsLeft++;
+        }
+        return true;
+    }
+
+    bool allShipsDestroyed() const { return m_state.cellsLeft == 0; }
+
+    bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+    {
+        if (shipId < 0  ||  shipId >= m_nShips  ||  !isPlaced(m_state, shipId))
+            return false;
+        topOrLeft = Point(m_state.where[shipId] / Cols, m_state.where[shipId] % Cols);
+        dir = direction(m_state, shipId);
+        return true;
+    }
+
+    const Game& game() const { return *m_game; }
+
+    void display(bool shotsOnly) const
+    {
+        std::cout << "  ";
+        for (int c = 0; c < Cols; c++)
+            std::cout << c;
+        std::cout << std::endl;
+        for (int r = 0; r < Rows; r++)
+        {
+            std::cout << r << " ";
+            for (int c = 0; c < Cols; c++)
+                std::cout << cellSymbol(r * Cols + c, shotsOnly);
+            std::cout << std::endl;
+        }
+    }
+
+  private:
+    const Game* m_game;
+    int m_nShips;
+    int m_length[MaxShips];
+    Mask m_blocked;
+      // One plus the id of the ship on each cell, 0 for none, kept in step
+      // with the ships in m_state so an attack finds its ship in one lookup
+    uint8_t m_shipAt[Rows * Cols];
+    State m_state;
+
+    static bool isPlaced(const State& s, int shipId) { return (s.placed >> shipId) & 1; }
+    static Direction direction(const State& s, int shipId)
+    {
+        return ((s.vertical >> shipId) & 1) ? VERTICAL : HORIZONTAL;
+    }
+
+      // Set the cells of ship shipId, placed as in s, to value in m_shipAt
+    void markShip(const State& s, int shipId, uint8_t value)
+    {
+        int step = (direction(s, shipId) == HORIZONTAL ? 1 : Cols);
+        for (int i = 0, cell = s.where[shipId]; i < m_length[shipId]; i++, cell += step)
+            m_shipAt[cell] = value;
+    }
+
+    static bool isValid(Point p)
+    {
+        return p.r >= 0  &&  p.r < Rows  &&  p.c >= 0  &&  p.c < Cols;
+    }
+
+    char cellSymbol(int cell, bool shotsOnly) const
+    {
+        if (m_state.shots.test(cell))
+            return m_state.occupied.test(cell) ? 'X' : 'o';
+        if (shotsOnly)
+            return '.';
+        if (m_blocked.test(cell))
+            return '#';
+        if (m_shipAt[cell] != 0)
+            return m_game->shipSymbol(m_shipAt[cell] - 1);
+        return '.';
+    }
+};
+
+#endif // BOARDT_INCLUDED
@@ -0,0 +1,108 @@
+#include "Coroutine.h"
+
+#if BATTLESHIP_COROUTINES
+
+using namespace std;
+
+  // A coroutine that owns a spawned task: it waits its turn on the
+  // scheduler, runs the task to its end, and then frees itself
+struct SpawnedTask
+{
+    struct promise_type
+    {
+        SpawnedTask get_return_object() { return SpawnedTask(); }
+        suspend_never initial_suspend() noexcept { return {}; }
+        suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { abort(); }
+    };
+
+    struct Posted
+    {
+        Scheduler& s;
+        bool await_ready() noexcept { return false; }
+        void await_suspend(coroutine_handle<> h) { s.post(h); }
+        void await_resume() noexcept {}
+    };
+
+    static SpawnedTask launch(Scheduler& s, Async<void> task)
+    {
+        co_await Posted{s};
+        co_await task;
+        s.finished();
+    }
+};
+
+Scheduler::Scheduler()
+ : m_live(0)
+{}
+
+Scheduler::~Scheduler()
+{
+    // Tasks that never finished stay suspended for good
+}
+
+void Scheduler::spawn(Async<void> task)
+{
+    {
+        lock_guard<mutex> lock(m_lock);
+        m_live++;
+    }
+    SpawnedTask::launch(*this, std::move(task));
+}
+
+void Scheduler::post(coroutine_handle<> h)
+{
+    {
+        lock_guard<mutex> lock(m_lock);
+        m_ready.push_back(h);
+    }
+    m_wake.notify_one();
+}
+
+void Scheduler::finished()
+{
+    lock_guard<mutex> lock(m_lock);
+    m_live--;
+}
+
+int Scheduler::poll()
+{
+    for (;;)
+    {
+        {
+            lock_guard<mutex> lock(m_lock);
+            if (m_ready.empty())
+                return m_live;
+            m_running.swap(m_ready);
+        }
+        for (size_t i = 0; i < m_running.size(); i++)
+            m_running[i].resume();
+        m_running.clear();
+    }
+}
+
+void Scheduler::run()
+{
+    for (;;)
+    {
+        {
+            unique_lock<mutex> lock(m_lock);
+            m_wake.wait(lock, [this]() { return !m_ready.empty()  ||  m_live == 0; });
+            if (m_ready.empty())
+                return;
+            m_running.swap(m_ready);
+        }
+        for (size_t i = 0; i < m_running.size(); i++)
+            m_running[i].resume();
+        m_running.clear();
+    }
+}
+
+int Scheduler::live() const
+{
+    lock_guard<mutex> lock(m_lock);
+    return m_live;
+}
+
+#endif // BATTLESHIP_COROUTINES
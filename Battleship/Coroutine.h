@@ -0,0 +1,269 @@
+#ifndef COROUTINE_INCLUDED
+#define COROUTINE_INCLUDED
+
+// Support for playing matches as C++20 coroutines, so that a player can
+// suspend while it waits for input instead of blocking its thread, and one
+// Scheduler thread can interleave any number of matches.  It is only
+// compiled where the language has coroutines; BATTLESHIP_COROUTINES says
+// whether it has been.
+
+#if defined(__cpp_impl_coroutine)  &&  defined(__has_include)
+#if __has_include(<coroutine>)
+#define BATTLESHIP_COROUTINES 1
+#endif
+#endif
+#ifndef BATTLESHIP_COROUTINES
+#define BATTLESHIP_COROUTINES 0
+#endif
+
+#if BATTLESHIP_COROUTINES
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace AsyncDetail
+{
+      // What the promise of every Async coroutine has: the coroutine starts
+      // suspended, and when it finishes it resumes whoever awaited it
+    struct PromiseBase
+    {
+        std::coroutine_handle<> continuation;
+
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept { return false; }
+            template <class Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept
+            {
+                std::coroutine_handle<> next = h.promise().continuation;
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void unhandled_exception() { std::abort(); } //nothing in a match throws
+    };
+}
+
+  // The result of a decision that may not have been made yet.  It is
+  // either a value known at once, which costs nothing to await, or a
+  // coroutine, which runs when it is first awaited and resumes its awaiter
+  // when it finishes.  That lets an ordinary player answer through the same
+  // interface as one that has to wait.
+template <class T>
+class Async
+{
+  public:
+    struct promise_type : AsyncDetail::PromiseBase
+    {
+        T value;
+        Async get_return_object()
+        {
+            return Async(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        void return_value(T v) { value = std::move(v); }
+    };
+
+    Async(T value) : m_value(std::move(value)) {}
+    Async(Async&& other) noexcept
+     : m_handle(std::exchange(other.m_handle, nullptr)), m_value(std::move(other.m_value))
+    {}
+    ~Async()
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return !m_handle; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        m_handle.promise().continuation = awaiting;
+        return m_handle;
+    }
+    T await_resume() { return m_handle ? std::move(m_handle.promise().value) : std::move(m_value); }
+
+      // Run the coroutine, if there is one, here and now, setting result;
+      // false if it suspended to wait for something, in which case it is
+      // abandoned when this Async is destroyed
+    bool runNow(T& result)
+    {
+        if (m_handle)
+        {
+            m_handle.resume();
+            if (!m_handle.done())
+                return false;
+        }
+        result = await_resume();
+        return true;
+    }
+
+      // We prevent an Async object from being copied or assigned
+    Async(const Async&) = delete;
+    Async& operator=(const Async&) = delete;
+
+  private:
+    std::coroutine_handle<promise_type> m_handle;
+    T m_value = T();
+
+    explicit Async(std::coroutine_handle<promise_type> h) : m_handle(h) {}
+};
+
+template <>
+class Async<void>
+{
+  public:
+    struct promise_type : AsyncDetail::PromiseBase
+    {
+        Async get_return_object()
+        {
+            return Async(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        void return_void() {}
+    };
+
+    Async(Async&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+    ~Async()
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return !m_handle; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        m_handle.promise().continuation = awaiting;
+        return m_handle;
+    }
+    void await_resume() {}
+
+      // As Async<T>::runNow
+    bool runNow()
+    {
+        if (m_handle)
+            m_handle.resume();
+        return !m_handle  ||  m_handle.done();
+    }
+
+      // We prevent an Async object from being copied or assigned
+    Async(const Async&) = delete;
+    Async& operator=(const Async&) = delete;
+
+  private:
+    std::coroutine_handle<promise_type> m_handle;
+
+    explicit Async(std::coroutine_handle<promise_type> h) : m_handle(h) {}
+};
+
+  // Runs coroutines on one thread.  Tasks handed to spawn run until they
+  // suspend; whatever they were waiting for then posts them back to be
+  // resumed.  post may be called from any thread; everything else belongs
+  // to the thread running the scheduler.
+class Scheduler
+{
+  public:
+    Scheduler();
+    ~Scheduler();
+
+      // Start task on the next poll or run
+    void spawn(Async<void> task);
+
+      // Resume h on the scheduler's thread
+    void post(std::coroutine_handle<> h);
+
+      // Run everything that is ready to run until nothing is, and return
+      // how many spawned tasks have not finished
+    int poll();
+
+      // Run until every spawned task has finished, sleeping while they all
+      // wait for something posted from another thread
+    void run();
+
+    int live() const;
+
+      // We prevent a Scheduler object from being copied or assigned
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+  private:
+    mutable std::mutex m_lock;
+    std::condition_variable m_wake;
+    std::vector<std::coroutine_handle<> > m_ready;
+    std::vector<std::coroutine_handle<> > m_running; //the batch being resumed
+    int m_live;
+
+    void finished();
+    friend struct SpawnedTask;
+};
+
+  // Items sent from anywhere to one coroutine, which awaits receive() for
+  // each.  If nothing has been sent yet, the receiver suspends until
+  // something is, then is resumed by the scheduler.
+template <class T>
+class Mailbox
+{
+  public:
+    explicit Mailbox(Scheduler& s) : m_scheduler(s) {}
+
+    void send(T item)
+    {
+        std::coroutine_handle<> waiter;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_items.push_back(std::move(item));
+            waiter = std::exchange(m_waiter, nullptr);
+        }
+        if (waiter)
+            m_scheduler.post(waiter);
+    }
+
+      // Whether the receiver is suspended waiting for an item
+    bool waiting() const
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return bool(m_waiter);
+    }
+
+    struct Receive
+    {
+        Mailbox& box;
+        bool await_ready() noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            std::lock_guard<std::mutex> lock(box.m_lock);
+            if (!box.m_items.empty())
+                return false; //no need to wait
+            box.m_waiter = h;
+            return true;
+        }
+        T await_resume()
+        {
+            std::lock_guard<std::mutex> lock(box.m_lock);
+            T item = std::move(box.m_items.front());
+            box.m_items.pop_front();
+            return item;
+        }
+    };
+
+    Receive receive() { return Receive{*this}; }
+
+      // We prevent a Mailbox object from being copied or assigned
+    Mailbox(const Mailbox&) = delete;
+    Mailbox& operator=(const Mailbox&) = delete;
+
+  private:
+    Scheduler& m_scheduler;
+    mutable std::mutex m_lock;
+    std::deque<T> m_items;
+    std::coroutine_handle<> m_waiter;
+};
+
+#endif // BATTLESHIP_COROUTINES
+
+#endif // COROUTINE_INCLUDED
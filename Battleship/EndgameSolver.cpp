@@ -0,0 +1,459 @@
+#include "EndgameSolver.h"
+#include "Game.h"
+#include "Knowledge.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+  // For a solver not given a table, which holds its own positions only
+static const size_t TABLESIZE = size_t(1) << 14;
+
+  // The most work a table entry records, far more than any maxWork worth
+  // setting
+static const long long MAXENTRYWORK = (1LL << 31) - 1;
+
+static uint64_t mix(uint64_t x)
+{
+    return RandomEngine::splitmix64(x);
+}
+
+static uint64_t bit(int i)
+{
+    return uint64_t(1) << i;
+}
+
+  // Keys of the cells of the board and of the ships' placements on it,
+  // the same in every solve and every game
+static uint64_t cellKey(int r, int c)
+{
+    return mix(uint64_t(r) << 32 | uint32_t(c));
+}
+
+static uint64_t placementKey(int shipId, int length, int r, int c, Direction dir)
+{
+    return mix(cellKey(r, c) ^ (uint64_t(shipId) << 40 | uint64_t(length) << 8 |
+                                (dir == HORIZONTAL ? 1 : 2)));
+}
+
+  // A table entry: a search value, as a float, and the work it took,
+  // never 0
+static uint64_t packEntry(float v, long long work)
+{
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    return uint64_t(min(work, MAXENTRYWORK)) << 33 | uint64_t(bits) << 1 | 1;
+}
+
+static float unpackValue(uint64_t entry)
+{
+    uint32_t bits = uint32_t(entry >> 1);
+    float v;
+    memcpy(&v, &bits, sizeof v);
+    return v;
+}
+
+static long long unpackWork(uint64_t entry)
+{
+    return (long long)(entry >> 33);
+}
+
+EndgameSolver::EndgameSolver(const Game& g, TranspositionTable* table)
+ : m_game(g), m_cellIndex(g.rows() * g.cols(), -1), m_hitsKey(0), m_requiredHits(0),
+   m_forbiddenHits(0), m_copies(1), m_table(table), m_words(0), m_slots(0), m_work(0),
+   m_aborted(false)
+{
+    Stats none = { -1, 0, 0, 0, 0, false, 0 };
+    m_stats = none;
+}
+
+  // Add the placement of ship m_afloat[afloat] at (r,c) if it agrees with
+  // k, numbering any unknown cells it covers for the first time.  Returns
+  // false if that makes too many unknown cells.
+bool EndgameSolver::addPlacement(const Knowledge& k, int afloat, int r, int c, Direction dir)
+{
+    int length = m_game.shipLength(m_afloat[afloat]);
+    int dr = (dir == VERTICAL ? 1 : 0);
+    int dc = (dir == HORIZONTAL ? 1 : 0);
+    if (r + dr*(length-1) >= m_game.rows()  ||  c + dc*(length-1) >= m_game.cols())
+        return true;
+    m_work += length;
+    uint64_t hits = 0;
+    int unfired = 0;
+    int added = 0;
+    for (int i = 0; i < length; i++)
+    {
+        int rr = r + i*dr;
+        int cc = c + i*dc;
+        if (k.blocked(rr, cc))
+            return true;
+        int index = m_cellIndex[rr * m_game.cols() + cc];
+        if (k.fired(rr, cc))
+        {
+            if (index > -2)
+                return true; //fired, but its result isn't in
+            hits |= bit(-2 - index);
+        }
+        else
+        {
+            unfired++;
+            if (index == -1)
+                added++;
+        }
+    }
+    if (unfired == 0)
+        return true; //a ship hit everywhere would have been sunk
+    if (int(m_cells.size()) + added > min(m_limits.maxUnknownCells, 64))
+        return false;
+
+    Placement pl = { afloat, 0, hits, placementKey(m_afloat[afloat], length, r, c, dir) };
+    for (int i = 0; i < length; i++)
+    {
+        int rr = r + i*dr;
+        int cc = c + i*dc;
+        if (k.fired(rr, cc))
+            continue;
+        int& index = m_cellIndex[rr * m_game.cols() + cc];
+        if (index == -1)
+        {
+            index = int(m_cells.size());
+            m_cells.push_back(rr * m_game.cols() + cc);
+            m_cellKey.push_back(cellKey(rr, cc));
+        }
+        pl.unknown |= bit(index);
+    }
+    m_placements.push_back(pl);
+    return true;
+}
+
+  // List every placement of every ship afloat that agrees with k.  Each
+  // origin tried counts as work, so a board too big for the limits is
+  // given up on partway through.
+bool EndgameSolver::findPlacements(const Knowledge& k)
+{
+    const vector<Point>& hits = k.openHits();
+    const vector<Point>& unsure = k.unsureHits();
+    if (hits.size() + unsure.size() > 64)
+        return false;
+    for (size_t h = 0; h < hits.size() + unsure.size(); h++)
+    {
+        Point p = (h < hits.size() ? hits[h] : unsure[h - hits.size()]);
+        m_cellIndex[p.r * m_game.cols() + p.c] = -2 - int(h);
+        m_hitsKey ^= cellKey(p.r, p.c);
+    }
+    for (size_t a = 0; a < m_afloat.size(); a++)
+    {
+        m_firstPlacement.push_back(int(m_placements.size()));
+        bool single = (m_game.shipLength(m_afloat[a]) == 1); //has only one direction
+        for (int r = 0; r < m_game.rows(); r++)
+        {
+            for (int c = 0; c < m_game.cols(); c++)
+            {
+                if (++m_work > m_limits.maxWork)
+                    return false;
+                if (!addPlacement(k, int(a), r, c, HORIZONTAL)  ||
+                    (!single  &&  !addPlacement(k, int(a), r, c, VERTICAL)))
+                    return false;
+            }
+        }
+    }
+    m_firstPlacement.push_back(int(m_placements.size()));
+    return true;
+}
+
+  // Extend a layout of the ships before ship with placements of the rest
+  // that don't overlap it, keeping those that cover exactly the required
+  // hits, m_copies times over.  key is the XOR of the placements' keys so
+  // far.
+void EndgameSolver::listLayouts(int ship, uint64_t unknown, uint64_t hits, uint64_t* shipMasks,
+                                uint64_t key)
+{
+    int nAfloat = int(m_afloat.size());
+    if (ship == nAfloat)
+    {
+        if (hits != m_requiredHits)
+            return;
+        for (int copy = 0; copy < m_copies; copy++)
+        {
+            if (int(m_layoutMask.size()) == m_limits.maxLayouts)
+            {
+                m_aborted = true;
+                return;
+            }
+            m_layoutMask.push_back(unknown);
+            for (int a = 0; a < MAXAFLOAT; a++)
+                m_shipMask.push_back(a < nAfloat ? shipMasks[a] : 0);
+            m_layoutKey.push_back(mix(key + uint64_t(copy)));
+        }
+        return;
+    }
+    int lengthLeft = 0;
+    for (int a = ship; a < nAfloat; a++)
+        lengthLeft += m_game.shipLength(m_afloat[a]);
+    if (__builtin_popcountll(m_requiredHits & ~hits) > lengthLeft)
+        return; //too few cells left to cover the hits
+    for (int i = m_firstPlacement[ship]; i < m_firstPlacement[ship+1]  &&  !m_aborted; i++)
+    {
+        const Placement& pl = m_placements[i];
+        if (++m_work > m_limits.maxWork)
+            m_aborted = true;
+        if ((pl.unknown & unknown) != 0  ||  (pl.hits & (hits | m_forbiddenHits)) != 0)
+            continue;
+        shipMasks[ship] = pl.unknown;
+        listLayouts(ship + 1, unknown | pl.unknown, hits | pl.hits, shipMasks, key ^ pl.key);
+    }
+}
+
+bool EndgameSolver::solve(const Knowledge& k, Point& p)
+{
+    Stats none = { -1, 0, 0, 0, 0, false, 0 };
+    m_stats = none;
+    m_afloat.clear();
+    for (int i = 0; i < m_game.nShips(); i++)
+        if (!k.shipSunk(i))
+            m_afloat.push_back(i);
+    if (m_afloat.empty()  ||  int(m_afloat.size()) > min(m_limits.maxShipsAfloat, int(MAXAFLOAT))  ||
+        !k.sunkCoversExact())
+        return false;
+
+    m_work = 0;
+    m_aborted = false;
+    m_cells.clear();
+    m_cellKey.clear();
+    m_hitsKey = 0;
+    m_placements.clear();
+    m_firstPlacement.clear();
+    m_layoutMask.clear();
+    m_shipMask.clear();
+    m_layoutKey.clear();
+    bool endgame = findPlacements(k);
+    for (size_t i = 0; i < m_cells.size(); i++) //ready for the next solve
+        m_cellIndex[m_cells[i]] = -1;
+    for (size_t h = 0; h < k.openHits().size(); h++)
+        m_cellIndex[k.openHits()[h].r * m_game.cols() + k.openHits()[h].c] = -1;
+    for (size_t h = 0; h < k.unsureHits().size(); h++)
+        m_cellIndex[k.unsureHits()[h].r * m_game.cols() + k.unsureHits()[h].c] = -1;
+    if (!endgame)
+    {
+        m_stats.work = m_work;
+        return false;
+    }
+    m_stats.unknownCells = int(m_cells.size());
+
+      // The layouts must cover the open hits, and the unsure ones that the
+      // sunk ships don't, in each way they could
+    int nOpen = int(k.openHits().size());
+    int nHits = nOpen + int(k.unsureHits().size());
+    uint64_t allHits = (nHits == 64 ? ~uint64_t(0) : bit(nHits) - 1);
+    const vector<uint64_t>& covers = k.sunkCovers();
+    uint64_t shipMasks[MAXAFLOAT];
+    for (size_t c = 0; c < max(covers.size(), size_t(1))  &&  !m_aborted; c++)
+    {
+        m_forbiddenHits = (covers.empty() ? 0 : covers[c] << nOpen);
+        m_requiredHits = allHits & ~m_forbiddenHits;
+        m_copies = (covers.empty() ? 1 : k.sunkCoverWeights()[c]);
+        listLayouts(0, 0, 0, shipMasks, 0);
+    }
+    int nLayouts = int(m_layoutMask.size());
+    m_stats.layouts = nLayouts;
+    if (m_aborted  ||  nLayouts == 0)
+    {
+        m_stats.work = m_work;
+        return false; //too many layouts, or k contradicts itself
+    }
+
+    m_words = (nLayouts + 63) / 64;
+    m_slots = 2 + int(m_afloat.size());
+    int nUnknown = int(m_cells.size());
+    m_covers.assign(size_t(nUnknown) * m_words, 0);
+    uint64_t key = 0;
+    for (int c = 0; c < nLayouts; c++)
+    {
+        for (uint64_t m = m_layoutMask[c]; m != 0; m &= m - 1)
+            m_covers[size_t(__builtin_ctzll(m)) * m_words + c / 64] |= bit(c % 64);
+        key ^= m_layoutKey[c];
+    }
+      // The layouts at the start, then the sets each depth splits into
+    m_sets.assign(size_t(m_words) * (1 + size_t(nUnknown + 1) * m_slots), 0);
+    for (int c = 0; c < nLayouts; c++)
+        m_sets[c / 64] |= bit(c % 64);
+
+    if (m_table == nullptr) //the first search of a solver given no table
+    {
+        m_ownTable.reset(new TranspositionTable(TABLESIZE));
+        m_table = m_ownTable.get();
+    }
+    int best = -1;
+    double misses = search(0, &m_sets[0], nLayouts, 0, key, &best);
+    m_stats.work = m_work;
+    if (m_aborted  ||  best < 0  ||  m_work > m_limits.maxWork)
+        return false; //positions found in the table can take it over
+    m_stats.solved = true;
+    m_stats.expectedShots = misses + __builtin_popcountll(m_layoutMask[0]);
+    p = Point(m_cells[best] / m_game.cols(), m_cells[best] % m_game.cols());
+    return true;
+}
+
+  // The least expected number of misses still to come, given that the
+  // count layouts in the set are those that agree with every result so
+  // far and the unknown cells in fired have been fired at.  key is the XOR
+  // of the layouts' keys.  At the root, bestCell is set to the shot that
+  // achieves it.  The work charged doesn't depend on what the table holds,
+  // nor on how the unknown cells happen to be numbered.
+double EndgameSolver::search(int depth, const uint64_t* layouts, int count, uint64_t fired,
+                             uint64_t key, int* bestCell)
+{
+    int first = 0;
+    while (layouts[first] == 0)
+        first++;
+    first = first * 64 + __builtin_ctzll(layouts[first]);
+    if ((m_layoutMask[first] & ~fired) == 0)
+        return 0; //they agree on every cell, and every one has been hit
+
+    uint64_t any = 0;
+    uint64_t all = ~uint64_t(0);
+    for (int w = 0; w < m_words; w++)
+    {
+        for (uint64_t m = layouts[w]; m != 0; m &= m - 1)
+        {
+            uint64_t cells = m_layoutMask[w * 64 + __builtin_ctzll(m)];
+            any |= cells;
+            all &= cells;
+        }
+    }
+    long long start = m_work;
+    m_work += count;
+
+      // The cells fired at that are on some layout left are hits, and the
+      // misses off every layout make no difference to what follows, so a
+      // position is its layouts and its hits
+    uint64_t hitKey = m_hitsKey;
+    for (uint64_t m = fired & any; m != 0; m &= m - 1)
+        hitKey ^= m_cellKey[__builtin_ctzll(m)];
+    uint64_t memo = mix(key ^ mix(hitKey));
+    uint64_t entry;
+    if (bestCell == nullptr  &&  m_table->probe(memo, entry))
+    {
+        m_stats.tableHits++;
+        m_work = start + unpackWork(entry);
+        return unpackValue(entry);
+    }
+    m_stats.searched++;
+    if (m_work > m_limits.maxWork)
+    {
+        m_aborted = true;
+        return 0;
+    }
+    any &= ~fired;
+    all &= ~fired;
+
+    double best;
+    if (all != 0)
+    {
+          // A sure hit costs nothing and may tell something, so take it,
+          // the first on the board if there are several
+        int cell = __builtin_ctzll(all);
+        for (uint64_t m = all & (all - 1); m != 0; m &= m - 1)
+            if (m_cells[__builtin_ctzll(m)] < m_cells[cell])
+                cell = __builtin_ctzll(m);
+        best = shoot(depth, layouts, count, fired, key, cell, numeric_limits<double>::infinity());
+        if (bestCell != nullptr)
+            *bestCell = cell;
+    }
+    else
+    {
+          // The unfired cells by how many layouts cover them, most first,
+          // and then in board order
+        int order[64];
+        int covered[64];
+        int n = 0;
+        for (uint64_t m = any; m != 0; m &= m - 1)
+        {
+            int cell = __builtin_ctzll(m);
+            const uint64_t* covers = &m_covers[size_t(cell) * m_words];
+            int h = 0;
+            for (int w = 0; w < m_words; w++)
+                h += __builtin_popcountll(covers[w] & layouts[w]);
+            covered[cell] = h;
+            int i = n++;
+            for ( ; i > 0  &&  (covered[order[i-1]] < h  ||
+                                (covered[order[i-1]] == h  &&  m_cells[order[i-1]] > m_cells[cell])); i--)
+                order[i] = order[i-1];
+            order[i] = cell;
+        }
+        m_work += n;
+
+        best = numeric_limits<double>::infinity();
+        for (int i = 0; i < n; i++)
+        {
+              // Every later shot misses at least as often as this one
+            if (1 - double(covered[order[i]]) / count >= best)
+                break;
+            double v = shoot(depth, layouts, count, fired, key, order[i], best);
+            if (m_aborted)
+                return 0;
+            if (v < best)
+            {
+                best = v;
+                if (bestCell != nullptr)
+                    *bestCell = order[i];
+            }
+        }
+    }
+    if (m_aborted)
+        return 0;
+    best = float(best); //as the table holds it, so a lookup gives the same
+    m_table->store(memo, packEntry(float(best), m_work - start));
+    return best;
+}
+
+  // The expected misses from firing at cell next, or at least cutoff if
+  // that is more
+double EndgameSolver::shoot(int depth, const uint64_t* layouts, int count, uint64_t fired,
+                            uint64_t key, int cell, double cutoff)
+{
+      // Split the layouts by what the shot would show: a miss, a hit, or
+      // a hit that sinks each ship afloat
+    uint64_t* out = &m_sets[size_t(m_words) * (1 + size_t(depth) * m_slots)];
+    fill(out, out + size_t(m_words) * m_slots, 0);
+    int n[2 + MAXAFLOAT] = {};
+    uint64_t keys[2 + MAXAFLOAT] = {};
+    uint64_t now = fired | bit(cell);
+    const uint64_t* covers = &m_covers[size_t(cell) * m_words];
+    for (int w = 0; w < m_words; w++)
+    {
+        uint64_t hit = layouts[w] & covers[w];
+        out[w] = layouts[w] & ~hit;
+        for (uint64_t m = hit; m != 0; m &= m - 1)
+        {
+            int c = w * 64 + __builtin_ctzll(m);
+            const uint64_t* ships = &m_shipMask[size_t(c) * MAXAFLOAT];
+            int a = 0;
+            while ((ships[a] & bit(cell)) == 0)
+                a++;
+            int slot = ((ships[a] & ~now) == 0 ? 2 + a : 1);
+            out[size_t(slot) * m_words + w] |= m & -m;
+            n[slot]++;
+            keys[slot] ^= m_layoutKey[c];
+        }
+    }
+    m_work += count;
+    n[0] = count;
+    keys[0] = key;
+    for (int s = 1; s < m_slots; s++)
+    {
+        n[0] -= n[s];
+        keys[0] ^= keys[s];
+    }
+
+    double cost = 0;
+    for (int s = 0; s < m_slots  &&  cost < cutoff  &&  !m_aborted; s++)
+    {
+        if (n[s] == 0)
+            continue;
+        double rest = search(depth + 1, out + size_t(s) * m_words, n[s], now, keys[s], nullptr);
+        cost += double(n[s]) / count * (s == 0 ? 1 + rest : rest);
+    }
+    return cost;
+}
@@ -0,0 +1,126 @@
+#ifndef ENDGAMESOLVER_INCLUDED
+#define ENDGAMESOLVER_INCLUDED
+
+#include "globals.h"
+#include "TranspositionTable.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class Game;
+class Knowledge;
+
+  // Plays the end of a game exactly.  Once only a few ships are afloat and
+  // few cells could still hold them, it lists every layout of those ships
+  // that agrees with what the attacker knows, taking their lengths from the
+  // game, and searches for the shot that minimizes the expected number of
+  // shots still needed to sink them all, every layout being equally
+  // likely.  Since every ship cell must be fired at anyway, that is the
+  // shot that minimizes the expected number of misses.  Where it isn't
+  // known which hits the sunk ships covered, the layouts for each way they
+  // could have are listed as many times as there are placements of the
+  // sunk ships that give it, so that the ships' placements, sunk or not,
+  // stay equally likely.
+  //
+  // The unknown cells are bits of a 64-bit word and a set of layouts is a
+  // bitset, so the search is a matter of word operations.  Shots certain
+  // to hit are taken first, since they cost no miss, and shots are tried
+  // in order of their chance of hitting, so the rest can be cut off once
+  // their chance of missing alone is too high.  The solver gives up once
+  // it has done maxWork units of work (placements tried and layout tests,
+  // from the first scan of the board on), which bounds the cost of a move;
+  // the caller then chooses its shot as it would have without the solver.
+  //
+  // Positions are looked up in a table, keyed by the ships' cells on the
+  // board and the hits among them, so a position searched in one move is
+  // found again in the next, and, if the table is shared, in other games
+  // of the same fleet and on other threads.  A position found costs the
+  // work it took to search, so whether it is found, and hence what is
+  // in the table, never changes whether a solve runs out of work or what
+  // it answers.
+class EndgameSolver
+{
+  public:
+    struct Limits
+    {
+        int maxShipsAfloat = 2;     //at most MAXAFLOAT; 0 turns the solver off
+        int maxUnknownCells = 32;   //unfired cells that could hold a ship, at most 64
+        int maxLayouts = 256;
+        long long maxWork = 1 << 20; //a few ms at worst, as positions found
+                                     //in the table count their whole search
+    };
+    static const int MAXAFLOAT = 4;
+
+      // With the default Limits until setLimits says otherwise.  Given a
+      // table, which any number of solvers and threads may share, the
+      // solver caches positions there; otherwise it makes one of its own
+      // the first time it has a position to search.
+    explicit EndgameSolver(const Game& g, TranspositionTable* table = nullptr);
+    void setLimits(const Limits& limits) { m_limits = limits; }
+    const Limits& limits() const { return m_limits; }
+
+      // If k is an endgame within the limits, set p to the best shot and
+      // return true; otherwise, or if the search runs out of work, return
+      // false.  Deterministic: the same k always gets the same answer.
+    bool solve(const Knowledge& k, Point& p);
+
+      // What the last call of solve found
+    struct Stats
+    {
+        int unknownCells;           //-1 if it wasn't an endgame
+        int layouts;
+        long long work;             //placements tried and layout tests
+        long long searched;         //positions searched
+        long long tableHits;        //positions found in the table instead
+        bool solved;
+        double expectedShots;       //including this one, if solved
+    };
+    const Stats& lastSolve() const { return m_stats; }
+
+  private:
+    struct Placement
+    {
+        int afloat;                 //index into m_afloat
+        uint64_t unknown;           //unknown cells it covers
+        uint64_t hits;              //unresolved hits it covers, by index
+        uint64_t key;               //of the ship and its cells
+    };
+
+    const Game& m_game;
+    Limits m_limits;
+    Stats m_stats;
+    std::vector<int> m_afloat;           //ids of the ships afloat
+    std::vector<int> m_cellIndex;        //per board cell: unknown cell index,
+                                         //-2 - hit index, or -1 for neither;
+                                         //open hits come before unsure ones
+    std::vector<int> m_cells;            //board cell of each unknown cell
+    std::vector<uint64_t> m_cellKey;     //per unknown cell
+    uint64_t m_hitsKey;                  //of the unresolved hits' cells
+    std::vector<Placement> m_placements; //grouped by ship
+    std::vector<int> m_firstPlacement;   //per ship afloat, plus an end
+    std::vector<uint64_t> m_layoutMask;  //unknown cells of each layout
+    std::vector<uint64_t> m_shipMask;    //per layout, per ship afloat
+    std::vector<uint64_t> m_layoutKey;
+    std::vector<uint64_t> m_covers;      //per unknown cell, the layouts on it
+    std::vector<uint64_t> m_sets;        //layout sets of the search, per depth
+    uint64_t m_requiredHits;             //hits the layouts being listed cover,
+    uint64_t m_forbiddenHits;            //those the sunk ships do,
+    int m_copies;                        //and how many times each is listed
+    TranspositionTable* m_table;
+    std::unique_ptr<TranspositionTable> m_ownTable; //if not given one, once needed
+    int m_words;                         //words in a set of layouts
+    int m_slots;                         //sets per depth: miss, hit, a sink per ship
+    long long m_work;
+    bool m_aborted;
+
+    bool findPlacements(const Knowledge& k);
+    bool addPlacement(const Knowledge& k, int afloat, int r, int c, Direction dir);
+    void listLayouts(int ship, uint64_t unknown, uint64_t hits, uint64_t* shipMasks,
+                     uint64_t key);
+    double search(int depth, const uint64_t* layouts, int count, uint64_t fired,
+                  uint64_t key, int* bestCell);
+    double shoot(int depth, const uint64_t* layouts, int count, uint64_t fired,
+                 uint64_t key, int cell, double cutoff);
+};
+
+#endif // ENDGAMESOLVER_INCLUDED
@@ -0,0 +1,264 @@
+#include "FleetPlacer.h"
+#include "Game.h"
+#include "Board.h"
+#include "Instrument.h"
+#include <algorithm>
+#include <climits>
+#include <numeric>
+
+using namespace std;
+
+  // How many independent draws to make before switching to the search
+static const int MAXSCATTERS = 1000;
+  // How many spots to try for one ship when keeping ships apart.  That bias
+  // is a strategy, not a rule, so it needn't be exactly uniform.
+static const int APARTTRIES = 64;
+  // How many placements the search may try while keeping ships apart before
+  // settling for a layout where they may touch
+static const long MAXAPARTSEARCH = 1L << 16;
+
+FleetPlacer::FleetPlacer(const Game& g)
+ : m_game(g), m_rows(g.rows()), m_cols(g.cols()),
+   m_taken(g.rows(), g.cols()), m_apart(false), m_budget(0)
+{
+    for (int i = 0; i < g.nShips(); i++)
+    {
+        m_order.push_back(i);
+        m_length.push_back(g.shipLength(i));
+        m_nPlacements.push_back(nHorizontal(m_length[i]) + nVertical(m_length[i]));
+    }
+      // Long ships are the hardest to fit, so a collision tends to show up
+      // early and little work is wasted on a doomed draw
+    stable_sort(m_order.begin(), m_order.end(), [this](int a, int b) {
+        return m_length[a] > m_length[b];
+    });
+    m_fleet.reserve(g.nShips());
+    m_smallBoard = (m_rows * m_taken.wordsPerRow() <= 64);
+}
+
+  // The k-th placement of a ship: the horizontal ones in row-major order of
+  // their left cell, then the vertical ones in row-major order of their top
+FleetPlacer::Placement FleetPlacer::nth(int shipId, int k) const
+{
+    int length = m_length[shipId];
+    int nH = nHorizontal(length);
+    if (k < nH)
+    {
+        int width = m_cols - length + 1;
+        Placement pl = { shipId, Point(k / width, k % width), HORIZONTAL };
+        return pl;
+    }
+    k -= nH;
+    Placement pl = { shipId, Point(k / m_cols, k % m_cols), VERTICAL };
+    return pl;
+}
+
+bool FleetPlacer::fits(const Placement& pl) const
+{
+    int length = m_length[pl.shipId];
+    if (pl.dir == HORIZONTAL)
+        return !m_taken.anyInRun(pl.topOrLeft.r, pl.topOrLeft.c, length);
+    for (int i = 0; i < length; i++)
+        if (m_taken.test(pl.topOrLeft.r+i, pl.topOrLeft.c))
+            return false;
+    return true;
+}
+
+  // The cells mark(pl) rules out: the ship's own, and if ships are being
+  // kept apart the ones around it too
+void FleetPlacer::area(const Placement& pl, int& r0, int& c0, int& r1, int& c1) const
+{
+    int length = m_length[pl.shipId];
+    r0 = pl.topOrLeft.r;
+    c0 = pl.topOrLeft.c;
+    r1 = r0 + (pl.dir == VERTICAL ? length-1 : 0);
+    c1 = c0 + (pl.dir == HORIZONTAL ? length-1 : 0);
+    if (m_apart)
+    {
+        r0 = max(r0-1, 0);
+        c0 = max(c0-1, 0);
+        r1 = min(r1+1, m_rows-1);
+        c1 = min(c1+1, m_cols-1);
+    }
+}
+
+void FleetPlacer::mark(const Placement& pl)
+{
+    int r0, c0, r1, c1;
+    area(pl, r0, c0, r1, c1);
+    for (int r = r0; r <= r1; r++)
+        m_taken.setRun(r, c0, c1-c0+1);
+}
+
+void FleetPlacer::take(const Placement& pl)
+{
+    mark(pl);
+    m_fleet.push_back(pl);
+}
+
+  // Clear the cells mark(pl) ruled out.  When ships are kept apart their
+  // borders overlap, so this also clears cells another ship still needs
+  // ruled out; only wipe() and drop() can use it safely.
+void FleetPlacer::unmark(const Placement& pl)
+{
+    int r0, c0, r1, c1;
+    area(pl, r0, c0, r1, c1);
+    for (int r = r0; r <= r1; r++)
+        m_taken.resetRun(r, c0, c1-c0+1);
+}
+
+  // Take every ship off.  On a small board it's quickest to clear every
+  // cell; on a large one, where that would cost far more than drawing a
+  // layout, clear just the cells the ships ruled out.
+void FleetPlacer::wipe()
+{
+    if (m_smallBoard)
+    {
+        m_taken.clear();
+    }
+    else
+    {
+        for (size_t i = 0; i < m_fleet.size(); i++)
+            unmark(m_fleet[i]);
+    }
+    m_fleet.clear();
+}
+
+  // Take the last ship placed back off
+void FleetPlacer::drop()
+{
+    if (!m_apart)
+    {
+        unmark(m_fleet.back()); //ships never overlap
+        m_fleet.pop_back();
+        return;
+    }
+    for (size_t i = 0; i < m_fleet.size(); i++)
+        unmark(m_fleet[i]);
+    m_fleet.pop_back();
+    for (size_t i = 0; i < m_fleet.size(); i++)
+        mark(m_fleet[i]);
+}
+
+  // A random placement of a ship, every one equally likely
+FleetPlacer::Placement FleetPlacer::randomPlacement(RandomEngine& rng, int shipId) const
+{
+    int length = m_length[shipId];
+    Placement pl;
+    pl.shipId = shipId;
+    if (rng.nextInt(m_nPlacements[shipId]) < nHorizontal(length))
+    {
+        pl.topOrLeft = Point(rng.nextInt(m_rows), rng.nextInt(m_cols - length + 1));
+        pl.dir = HORIZONTAL;
+    }
+    else
+    {
+        pl.topOrLeft = Point(rng.nextInt(m_rows - length + 1), rng.nextInt(m_cols));
+        pl.dir = VERTICAL;
+    }
+    return pl;
+}
+
+  // Draw random placements for each ship in turn, trying up to tries times
+  // before giving up on the whole layout.  With one try every combination
+  // of placements is drawn with the same probability, so the layouts that
+  // survive are uniform over the legal ones; more tries find a layout
+  // sooner but favor ships that are easy to fit.
+bool FleetPlacer::scatter(RandomEngine& rng, int tries)
+{
+    INSTRUMENT_COUNT(COUNT_LAYOUT_DRAWS);
+    for (size_t i = 0; i < m_order.size(); i++)
+    {
+        int shipId = m_order[i];
+        Placement pl = randomPlacement(rng, shipId);
+        for (int t = 1; t < tries  &&  !fits(pl); t++)
+            pl = randomPlacement(rng, shipId);
+        if (!fits(pl))
+        {
+            wipe();
+            return false;
+        }
+        take(pl);
+    }
+    return true;
+}
+
+  // Place the ships from m_order[depth] on, trying each ship's placements
+  // in a random order (a random start and a random stride coprime with the
+  // number of placements visits each exactly once) and backtracking when a
+  // ship has nowhere left to go
+bool FleetPlacer::search(RandomEngine& rng, size_t depth)
+{
+    if (depth == m_order.size())
+        return true;
+    int shipId = m_order[depth];
+    int total = m_nPlacements[shipId];
+    int start = rng.nextInt(total);
+    int stride;
+    do
+    {
+        stride = 1 + rng.nextInt(total);
+    } while (gcd(stride, total) != 1);
+
+    for (int j = 0; j < total; j++)
+    {
+        Placement pl = nth(shipId, int((start + (long long)j * stride) % total));
+        if (!fits(pl))
+            continue;
+        if (--m_budget < 0)
+            return false;
+        take(pl);
+        if (search(rng, depth+1))
+            return true;
+        drop();
+        if (m_budget < 0)
+            return false;
+    }
+    return false;
+}
+
+bool FleetPlacer::draw(RandomEngine& rng, Bias bias)
+{
+    wipe(); //the last layout drawn
+    for (size_t i = 0; i < m_order.size(); i++)
+        if (m_nPlacements[m_order[i]] == 0)
+            return false; //too long for the board either way
+
+    if (bias == APART)
+    {
+        m_apart = true;
+        for (int attempt = 0; attempt < MAXSCATTERS; attempt++)
+            if (scatter(rng, APARTTRIES))
+                return true;
+        m_budget = MAXAPARTSEARCH;
+        INSTRUMENT_COUNT(COUNT_LAYOUT_SEARCHES);
+        if (search(rng, 0))
+            return true;
+        wipe();
+          // Too crowded to keep the ships apart, so let them touch
+    }
+
+    m_apart = false;
+    for (int attempt = 0; attempt < MAXSCATTERS; attempt++)
+        if (scatter(rng, 1))
+            return true;
+    m_budget = LONG_MAX;
+    INSTRUMENT_COUNT(COUNT_LAYOUT_SEARCHES);
+    return search(rng, 0);
+}
+
+bool FleetPlacer::place(Board& b, RandomEngine& rng, Bias bias)
+{
+    if (!draw(rng, bias))
+        return false;
+    for (size_t i = 0; i < m_fleet.size(); i++)
+    {
+        const Placement& pl = m_fleet[i];
+        if (!b.placeShip(pl.topOrLeft, pl.shipId, pl.dir))
+        {
+            b.clear();
+            return false;
+        }
+    }
+    return true;
+}
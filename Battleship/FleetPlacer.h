@@ -0,0 +1,81 @@
+#ifndef FLEETPLACER_INCLUDED
+#define FLEETPLACER_INCLUDED
+
+#include "globals.h"
+#include "BitGrid.h"
+#include <vector>
+
+class Game;
+class Board;
+
+  // Draws random layouts of a game's whole fleet on an empty board.  The
+  // cells a new ship may not cover are kept as bits, so checking a
+  // horizontal placement is a mask test of a word or two and a vertical one
+  // a test per cell.  A uniform layout is drawn by giving every ship an
+  // independent random placement and starting over at the first collision,
+  // which makes every legal layout equally likely.  If a fleet is so
+  // crowded that this keeps failing, a randomized depth-first search takes
+  // over, so a layout is always found when one exists.  A placer holds
+  // scratch space, so give each thread its own.
+class FleetPlacer
+{
+  public:
+    enum Bias
+    {
+        UNIFORM,    //every legal layout equally likely
+        APART       //no two ships touch, even at a corner, when that's possible
+    };
+
+    explicit FleetPlacer(const Game& g);
+
+      // Draw a layout into fleet().  Returns false only if the fleet can't
+      // fit on the board at all.
+    bool draw(RandomEngine& rng, Bias bias = UNIFORM);
+
+      // Draw a layout and put it on b, which should have no ships on it.
+      // If b refuses a ship, b is cleared and false is returned.
+    bool place(Board& b, RandomEngine& rng, Bias bias = UNIFORM);
+
+    struct Placement
+    {
+        int shipId;
+        Point topOrLeft;
+        Direction dir;
+    };
+    const std::vector<Placement>& fleet() const { return m_fleet; }
+
+  private:
+    const Game& m_game;
+    int m_rows;
+    int m_cols;
+    std::vector<int> m_order;          //ship ids, longest first
+    std::vector<int> m_length;         //by ship id
+    std::vector<int> m_nPlacements;    //by ship id, horizontal and vertical
+    BitGrid m_taken;                   //cells a new ship may not cover
+    std::vector<Placement> m_fleet;    //the ships placed so far
+    bool m_smallBoard;                 //m_taken is quicker to clear than to unmark
+    bool m_apart;                      //m_taken also rules out cells next to a ship
+    long m_budget;                     //placements the search may still try
+
+    int nHorizontal(int length) const
+    {
+        return length <= m_cols ? m_rows * (m_cols - length + 1) : 0;
+    }
+    int nVertical(int length) const
+    {
+        return length <= m_rows ? (m_rows - length + 1) * m_cols : 0;
+    }
+    Placement nth(int shipId, int k) const;
+    bool fits(const Placement& pl) const;
+    void area(const Placement& pl, int& r0, int& c0, int& r1, int& c1) const;
+    void mark(const Placement& pl);
+    void take(const Placement& pl);
+    void unmark(const Placement& pl);
+    void wipe();
+    void drop();
+    Placement randomPlacement(RandomEngine& rng, int shipId) const;
+    bool scatter(RandomEngine& rng, int tries);
+    bool search(RandomEngine& rng, std::size_t depth);
+};
+
+#endif // FLEETPLACER_INCLUDED
@@ -0,0 +1,158 @@
+#include "FleetSampler.h"
+#include "Game.h"
+#include "Knowledge.h"
+
+using namespace std;
+
+  // How many random spots to try for one ship before giving up on a sample
+static const int MAXTRIES = 64;
+
+FleetSampler::FleetSampler(const Game& g)
+ : m_game(g), m_occupied(g.rows(), g.cols())
+{
+    int hits = 0; //at most one per ship cell
+    for (int i = 0; i < g.nShips(); i++)
+        hits += g.shipLength(i);
+    m_required.reserve(hits);
+}
+
+bool FleetSampler::fits(const Knowledge& k, Point topOrLeft, Direction dir, int length) const
+{
+    int dr = (dir == VERTICAL ? 1 : 0);
+    int dc = (dir == HORIZONTAL ? 1 : 0);
+    if (topOrLeft.r < 0  ||  topOrLeft.c < 0  ||
+        topOrLeft.r + dr*(length-1) >= m_game.rows()  ||
+        topOrLeft.c + dc*(length-1) >= m_game.cols())
+        return false;
+      // A ship hit in every cell would have been reported sunk
+    if (dir == HORIZONTAL)
+        return !m_occupied.anyInRun(topOrLeft.r, topOrLeft.c, length)  &&
+               !k.blockedCells().anyInRun(topOrLeft.r, topOrLeft.c, length)  &&
+               !k.hitCells().allInRun(topOrLeft.r, topOrLeft.c, length);
+    bool allHit = true;
+    for (int i = 0; i < length; i++)
+    {
+        if (m_occupied.test(topOrLeft.r+i, topOrLeft.c)  ||
+            k.blocked(topOrLeft.r+i, topOrLeft.c))
+            return false;
+        allHit = allHit  &&  k.hit(topOrLeft.r+i, topOrLeft.c);
+    }
+    return !allHit;
+}
+
+void FleetSampler::place(int shipId, Point topOrLeft, Direction dir)
+{
+    int length = m_game.shipLength(shipId);
+    if (dir == HORIZONTAL)
+        m_occupied.setRun(topOrLeft.r, topOrLeft.c, length);
+    else
+        for (int i = 0; i < length; i++)
+            m_occupied.set(topOrLeft.r+i, topOrLeft.c);
+    Placement pl = { shipId, topOrLeft, dir };
+    m_fleet.push_back(pl);
+}
+
+bool FleetSampler::sample(const Knowledge& k, RandomEngine& rng, vector<int>& cells)
+{
+    m_occupied.clear();
+    m_fleet.clear();
+    m_unplaced.clear();
+    for (int i = 0; i < m_game.nShips(); i++)
+        if (!k.shipSunk(i))
+            m_unplaced.push_back(i);
+
+      // Choose how the sunk ships lie among the unsure hits, if that is
+      // known, keeping the ships afloat off the ones they cover
+    m_required.assign(k.openHits().begin(), k.openHits().end());
+    const vector<uint64_t>& covers = k.sunkCovers();
+    if (!covers.empty())
+    {
+        const vector<int>& weights = k.sunkCoverWeights();
+        int total = 0;
+        for (size_t i = 0; i < weights.size(); i++)
+            total += weights[i];
+        int pick = rng.nextInt(total);
+        size_t which = 0;
+        for ( ; pick >= weights[which]; which++)
+            pick -= weights[which];
+        const vector<Point>& unsure = k.unsureHits();
+        for (size_t u = 0; u < unsure.size(); u++)
+        {
+            if ((covers[which] >> u) & 1)
+                m_occupied.set(unsure[u].r, unsure[u].c);
+            else
+                m_required.push_back(unsure[u]);
+        }
+    }
+
+      // Then cover each unresolved hit that no ship covers yet with a
+      // random unplaced ship through it
+    const vector<Point>& hits = m_required;
+    int nHits = hits.size();
+    int firstHit = (nHits == 0 ? 0 : rng.nextInt(nHits));
+    for (int h = 0; h < nHits; h++)
+    {
+        Point hit = hits[(firstHit + h) % nHits];
+        if (m_occupied.test(hit.r, hit.c))
+            continue;
+        bool placed = false;
+        for (int tries = 0; tries < MAXTRIES  &&  !placed  &&  !m_unplaced.empty(); tries++)
+        {
+            int which = rng.nextInt(m_unplaced.size());
+            int shipId = m_unplaced[which];
+            int length = m_game.shipLength(shipId);
+            Direction dir = (rng.nextInt(2) == 0 ? HORIZONTAL : VERTICAL);
+            int offset = rng.nextInt(length);
+            Point topOrLeft(hit.r - (dir == VERTICAL ? offset : 0),
+                            hit.c - (dir == HORIZONTAL ? offset : 0));
+            if (fits(k, topOrLeft, dir, length))
+            {
+                place(shipId, topOrLeft, dir);
+                m_unplaced[which] = m_unplaced.back();
+                m_unplaced.pop_back();
+                placed = true;
+            }
+        }
+        if (!placed)
+            return false;
+    }
+
+      // Then scatter the rest anywhere they fit
+    for (size_t i = 0; i < m_unplaced.size(); i++)
+    {
+        int shipId = m_unplaced[i];
+        int length = m_game.shipLength(shipId);
+        bool placed = false;
+        for (int tries = 0; tries < MAXTRIES  &&  !placed; tries++)
+        {
+            Direction dir = (rng.nextInt(2) == 0 ? HORIZONTAL : VERTICAL);
+            int rows = m_game.rows() - (dir == VERTICAL ? length-1 : 0);
+            int cols = m_game.cols() - (dir == HORIZONTAL ? length-1 : 0);
+            if (rows <= 0  ||  cols <= 0)
+                continue;
+            Point topOrLeft(rng.nextInt(rows), rng.nextInt(cols));
+            if (fits(k, topOrLeft, dir, length))
+            {
+                place(shipId, topOrLeft, dir);
+                placed = true;
+            }
+        }
+        if (!placed)
+            return false;
+    }
+
+    cells.clear();
+    int nCols = m_game.cols();
+    for (size_t i = 0; i < m_fleet.size(); i++)
+    {
+        const Placement& pl = m_fleet[i];
+        int length = m_game.shipLength(pl.shipId);
+        for (int j = 0; j < length; j++)
+        {
+            int r = pl.topOrLeft.r + (pl.dir == VERTICAL ? j : 0);
+            int c = pl.topOrLeft.c + (pl.dir == HORIZONTAL ? j : 0);
+            cells.push_back(r * nCols + c);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,52 @@
+#ifndef FLEETSAMPLER_INCLUDED
+#define FLEETSAMPLER_INCLUDED
+
+#include "globals.h"
+#include "BitGrid.h"
+#include <vector>
+
+class Game;
+class Knowledge;
+
+  // Draws random placements of the ships still afloat that agree with what
+  // an attacker knows: no ship on a cell known to be empty of them, none
+  // hit in every cell (it would have been reported sunk), no two ships
+  // overlapping, and every unresolved hit covered by some ship.  Where it
+  // isn't known which hits the sunk ships covered, each sample first picks
+  // one of the ways they could have (see Knowledge::sunkCovers), as often
+  // as there are placements of them that give it; the ships afloat then
+  // keep off those hits and cover the other unsure ones.
+  // Ships are first laid through the unresolved hits and the rest are then
+  // scattered at random, so samples are cheap to find even late in a game,
+  // at the cost of not being exactly uniform over all consistent fleets.
+  // A sampler holds scratch space, so give each thread its own.
+class FleetSampler
+{
+  public:
+    explicit FleetSampler(const Game& g);
+
+      // Try to draw one fleet.  On success, return true and set cells to
+      // the cells the fleet covers (one entry per cell, as r * cols + c).
+    bool sample(const Knowledge& k, RandomEngine& rng, std::vector<int>& cells);
+
+      // Where each unsunk ship went in the last successful sample
+    struct Placement
+    {
+        int shipId;
+        Point topOrLeft;
+        Direction dir;
+    };
+    const std::vector<Placement>& lastFleet() const { return m_fleet; }
+
+  private:
+    const Game& m_game;
+    BitGrid m_occupied;
+    std::vector<int> m_unplaced;       //ship ids still to place
+    std::vector<Point> m_required;     //hits the ships afloat must cover
+    std::vector<Placement> m_fleet;
+
+    bool fits(const Knowledge& k, Point topOrLeft, Direction dir, int length) const;
+    void place(int shipId, Point topOrLeft, Direction dir);
+};
+
+#endif // FLEETSAMPLER_INCLUDED
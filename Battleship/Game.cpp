@@ -2,6 +2,11 @@
 #include "Board.h"
 #include "Player.h"
 #include "globals.h"
+#include "GameObserver.h"
+#include "Match.h"
+#include "MoveClock.h"
+#include "Replay.h"
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <cstdlib>
@@ -13,20 +18,32 @@ using namespace std;
 class GameImpl
 {
   public:
-    GameImpl(int nRows, int nCols);
+    GameImpl(int nRows, int nCols, uint64_t seed);
     int rows() const;
     int cols() const;
     bool isValid(Point p) const;
     Point randomPoint() const;
+    RandomEngine& rng() const;
     bool addShip(int length, char symbol, string name);
     int nShips() const;
     int shipLength(int shipId) const;
     char shipSymbol(int shipId) const;
-    string shipName(int shipId) const;
-    Player* play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause);
+    const string& shipName(int shipId) const;
+    int shipWithSymbol(char symbol) const;
+    int totalShipLength() const;
+    int moveTimeLimit() const;
+    void setMoveTimeLimit(int ms);
+    MoveLatency moveLatency(int who) const;
+    void setMoveLatency(int who, const MoveLatency& l);
+    const string& replayFile() const;
+    void setReplayFile(string path);
 private:
     int m_rows;
     int m_cols;
+    int m_moveTimeLimit;   //ms, or 0 for none
+    MoveLatency m_latency[2]; //of the last match played against the clock
+    string m_replayFile;   //where to record matches, or empty
+    mutable RandomEngine m_rng; //every random choice in the game comes from here
     
     struct Ship {
     public:
@@ -42,18 +59,24 @@ private:
         string m_name;
     };
     vector <Ship> m_ships;
+    int m_totalLength; //of all the ships
+      // The id of the ship with each symbol, or -1; symbols are ASCII
+    signed char m_shipBySymbol[128];
 };
 
-void waitForEnter()
-{
-    cout << "Press enter to continue: ";
-    cin.ignore(10000, '\n');
-}
-
-GameImpl::GameImpl(int nRows, int nCols)
+GameImpl::GameImpl(int nRows, int nCols, uint64_t seed)
+ : m_rng(seed)
 {
     m_rows = nRows;
     m_cols = nCols;
+    m_moveTimeLimit = 1000;
+    m_totalLength = 0;
+    MoveLatency none = { 0, 0, 0, 0, 0 };
+    m_latency[0] = m_latency[1] = none;
+    for (int ch = 0; ch < 128; ch++)
+    {
+        m_shipBySymbol[ch] = -1;
+    }
 }
 
 int GameImpl::rows() const
@@ -73,7 +96,13 @@ bool GameImpl::isValid(Point p) const
 
 Point GameImpl::randomPoint() const
 {
-    return Point(randInt(rows()), randInt(cols()));
+    int r = m_rng.nextInt(rows());
+    return Point(r, m_rng.nextInt(cols()));
+}
+
+RandomEngine& GameImpl::rng() const
+{
+    return m_rng;
 }
 
 bool GameImpl::addShip(int length, char symbol, string name)
@@ -81,6 +110,8 @@ bool GameImpl::addShip(int length, char symbol, string name)
     Ship temp(length, symbol, name);
     temp.m_ID = m_ships.size(); //id fgoes from 0 to nships-1
     m_ships.push_back(temp);
+    m_totalLength += length;
+    m_shipBySymbol[symbol & 127] = temp.m_ID;
     
     return true;  //successfully added so return true
 }
@@ -100,112 +131,68 @@ char GameImpl::shipSymbol(int shipId) const
     return m_ships[shipId].m_symbol;
 }
 
-string GameImpl::shipName(int shipId) const
+const string& GameImpl::shipName(int shipId) const
 {
     return m_ships[shipId].m_name;
 }
 
-Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause)
+int GameImpl::shipWithSymbol(char symbol) const
 {
-    if(!p1->placeShips(b1))
-    {
-        return nullptr; //if player's place ship fails return nullptr
-    }
-    if (!p2->placeShips(b2))
-    {
-        return nullptr; //if player's place ships fails return nullptr
-    }
-    while(!b1.allShipsDestroyed() && !b2.allShipsDestroyed())    //while still ships to be destroyed run the loop
+    return m_shipBySymbol[symbol & 127];
+}
+
+int GameImpl::totalShipLength() const
+{
+    return m_totalLength;
+}
+
+int GameImpl::moveTimeLimit() const
+{
+    return m_moveTimeLimit;
+}
+
+void GameImpl::setMoveTimeLimit(int ms)
+{
+    m_moveTimeLimit = (ms > 0 ? ms : 0);
+}
+
+MoveLatency GameImpl::moveLatency(int who) const
+{
+    return m_latency[who];
+}
+
+void GameImpl::setMoveLatency(int who, const MoveLatency& l)
+{
+    m_latency[who] = l;
+}
+
+const string& GameImpl::replayFile() const
+{
+    return m_replayFile;
+}
+
+void GameImpl::setReplayFile(string path)
+{
+    m_replayFile = path;
+}
+
+  // Play a match on fresh boards, reporting it to observer and appending
+  // it to the replay file, if there is one
+template <class Observer, class Clock>
+static void playMatch(const Game& g, Player* p1, Player* p2, Observer& observer,
+                      Clock& clock, MatchResult& result)
+{
+    Board b1(g);
+    Board b2(g);
+    if (g.replayFile().empty())
     {
-        bool shotHit;
-        bool shipDestroyed;
-        int shipId;
-        cout << p1->name() << "'s turn. Board for " << p2->name() << ":" << endl;
-        b2.display(p1->isHuman()); //display second player's board, if first player human show shots only
-        Point temp1 = p1->recommendAttack();
-        if(!b2.attack(temp1, shotHit, shipDestroyed, shipId)) //if attack failed
-        {
-            cout << p1->name() << " wasted a shot at ("<< temp1.r <<"," << temp1.c << ")." << endl;
-            //if attack missed or was unnecessary, say they wasted a shot at that point
-        }
-        else    //shot was valid so determine if they hit or misssed, if ship sank, etc.
-        {
-            p1->recordAttackResult(temp1, true,shotHit, shipDestroyed,shipId);
-            if (shipDestroyed) //ship sunk
-            {
-                cout << p1->name() << " attacked (" << temp1.r <<"," << temp1.c <<") and destroyed the " << m_ships[shipId].m_name <<", resulting in:" << endl;
-            }
-            else if (shotHit) //hit
-            {   //Shuman the Human attacked (3,6) and hit something, resulting in:
-                cout << p1->name() << " attacked (" << temp1.r <<"," << temp1.c <<") and hit something, resulting in:" << endl;
-            }
-            else if (!shotHit)   //miss
-            {
-                cout << p1->name() << " attacked (" << temp1.r <<"," << temp1.c <<") and missed, resulting in:" << endl;
-            }
-        }
-        b2.display(p1->isHuman()); //show the result of the attack
-        if (shouldPause && !b1.allShipsDestroyed() && !b2.allShipsDestroyed())
-        {
-            waitForEnter(); //pause game if shouldPause is true
-        }
-        
-        if (b2.allShipsDestroyed()) //player 2 lost
-        {
-            if(p2->isHuman())
-            {
-                b2.display(false);
-            }
-            cout << p1->name() << " wins!" << endl;
-            return p1;
-        }
-        
-        //do player 2 now attacking player 1
-        bool shotHit2;
-        bool shipDestroyed2;
-        int shipId2;
-        cout << p2->name() << "'s turn. Board for " << p1->name() << ":" << endl;
-        b1.display(p2->isHuman());
-        Point temp2 = p2->recommendAttack();
-        if(!b1.attack(temp2, shotHit2, shipDestroyed2, shipId2)) //if attack failed
-        {
-            cout << p2->name() << " wasted a shot at ("<< temp2.r <<"," << temp2.c << ")." << endl;
-            //if attack missed or was unnecessary, say they wasted a shot at that point
-        }
-        else    //shot was valid so determine if they hit or misssed, if ship sank, etc.
-        {
-             p2->recordAttackResult(temp2, true,shotHit2, shipDestroyed2,shipId2);
-            if (shipDestroyed2) //ship sunk
-            {
-                cout << p2->name() << " attacked (" << temp2.r <<"," << temp2.c <<") and destroyed the " << m_ships[shipId2].m_name <<", resulting in:" << endl;
-            }
-            else if (shotHit2) //only hit not sunk
-            {
-                cout << p2->name() << " attacked (" << temp2.r <<"," << temp2.c <<") and hit something, resulting in:" << endl;
-            }
-            else if (!shotHit2)   //miss
-            {
-                cout << p2->name() << " attacked (" << temp2.r <<"," << temp2.c <<") and missed, resulting in:" << endl;
-            }
-        }
-        b1.display(p2->isHuman()); //show the result of the attack
-         if (shouldPause && !b1.allShipsDestroyed() && !b2.allShipsDestroyed())
-        {
-            waitForEnter(); //pause game if shouldPause is true
-        }
-    
-        if (b1.allShipsDestroyed()) //player 1 lost
-        {
-            if(p1->isHuman())
-            {
-                b1.display(false);
-            }
-            cout << p2->name() << " wins!" << endl;
-            return p2;
-        }
+        runMatch(g, p1, p2, b1, b2, observer, clock, result);
+        return;
     }
-    
-    return nullptr;
+    ofstream out(g.replayFile(), ios::binary | ios::app | ios::ate);
+    ReplayWriter writer(out);
+    TeeObserver both(observer, writer);
+    runMatch(g, p1, p2, b1, b2, both, clock, result);
 }
 
 //******************** Game functions *******************************
@@ -214,6 +201,10 @@ Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool should
 // You probably don't want to change any of the code from this point down.
 
 Game::Game(int nRows, int nCols)
+ : Game(nRows, nCols, freshSeed())
+{}
+
+Game::Game(int nRows, int nCols, uint64_t seed)
 {
     if (nRows < 1  ||  nRows > MAXROWS)
     {
@@ -225,7 +216,7 @@ Game::Game(int nRows, int nCols)
         cout << "Number of columns must be >= 1 and <= " << MAXCOLS << endl;
         exit(1);
     }
-    m_impl = new GameImpl(nRows, nCols);
+    m_impl = new GameImpl(nRows, nCols, seed);
 }
 
 Game::~Game()
@@ -253,6 +244,21 @@ Point Game::randomPoint() const
     return m_impl->randomPoint();
 }
 
+RandomEngine& Game::rng() const
+{
+    return m_impl->rng();
+}
+
+uint64_t Game::seed() const
+{
+    return m_impl->rng().seed();
+}
+
+void Game::reseed(uint64_t seed)
+{
+    m_impl->rng().reseed(seed);
+}
+
 bool Game::addShip(int length, char symbol, string name)
 {
     if (length < 1)
@@ -278,18 +284,13 @@ bool Game::addShip(int length, char symbol, string name)
              << endl;
         return false;
     }
-    int totalOfLengths = 0;
-    for (int s = 0; s < nShips(); s++)
+    if (shipWithSymbol(symbol) != -1)
     {
-        totalOfLengths += shipLength(s);
-        if (shipSymbol(s) == symbol)
-        {
-            cout << "Ship symbol " << symbol
-                 << " must not be used for more than one ship" << endl;
-            return false;
-        }
+        cout << "Ship symbol " << symbol
+             << " must not be used for more than one ship" << endl;
+        return false;
     }
-    if (totalOfLengths + length > rows() * cols())
+    if (m_impl->totalShipLength() + length > rows() * cols())
     {
         cout << "Board is too small to fit all ships" << endl;
         return false;
@@ -314,18 +315,72 @@ char Game::shipSymbol(int shipId) const
     return m_impl->shipSymbol(shipId);
 }
 
-string Game::shipName(int shipId) const
+const string& Game::shipName(int shipId) const
 {
     assert(shipId >= 0  &&  shipId < nShips());
     return m_impl->shipName(shipId);
 }
 
+int Game::shipWithSymbol(char symbol) const
+{
+    if (!isascii(symbol))
+        return -1;
+    return m_impl->shipWithSymbol(symbol);
+}
+
 Player* Game::play(Player* p1, Player* p2, bool shouldPause)
 {
+    ConsoleRenderer console(shouldPause);
+    return simulate(p1, p2, console).winner;
+}
+
+MatchResult Game::simulate(Player* p1, Player* p2)
+{
+    MatchResult result = { nullptr, 0, { 0, 0 }, { 0, 0 }, { 0, 0 } };
     if (p1 == nullptr  ||  p2 == nullptr  ||  nShips() == 0)
-        return nullptr;
-    Board b1(*this);
-    Board b2(*this);
-    return m_impl->play(p1, p2, b1, b2, shouldPause);
+        return result;
+    NullObserver none;
+    UntimedMoves untimed;
+    playMatch(*this, p1, p2, none, untimed, result);
+    return result;
+}
+
+MatchResult Game::simulate(Player* p1, Player* p2, GameObserver& observer)
+{
+    MatchResult result = { nullptr, 0, { 0, 0 }, { 0, 0 }, { 0, 0 } };
+    MoveClock clock(m_impl->moveTimeLimit(), rows() * cols());
+    if (p1 != nullptr  &&  p2 != nullptr  &&  nShips() != 0)
+        playMatch(*this, p1, p2, observer, clock, result);
+    for (int who = 0; who < 2; who++)
+        m_impl->setMoveLatency(who, clock.latency(who));
+    return result;
 }
 
+void Game::setMoveTimeLimit(int ms)
+{
+    m_impl->setMoveTimeLimit(ms);
+}
+
+int Game::moveTimeLimit() const
+{
+    return m_impl->moveTimeLimit();
+}
+
+MoveLatency Game::moveLatency(int who) const
+{
+    assert(who == 0  ||  who == 1);
+    return m_impl->moveLatency(who);
+}
+
+bool Game::setReplayFile(string path)
+{
+    if (!path.empty()  &&  !ofstream(path, ios::binary | ios::app))
+        return false;
+    m_impl->setReplayFile(path);
+    return true;
+}
+
+const string& Game::replayFile() const
+{
+    return m_impl->replayFile();
+}
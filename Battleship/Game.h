@@ -3,26 +3,78 @@
 
 #include <string>
 #include <cassert>
+#include <cstdint>
 
 class Point;
+class RandomEngine;
 class Player;
 class GameImpl;
+class GameObserver;
+
+  // Outcome of a match played by Game::simulate.  Index 0 of each array is
+  // for the first player passed to simulate, index 1 for the second.
+struct MatchResult
+{
+    Player* winner;       // nullptr if the match could not be played
+    int turns;            // rounds started; the first player moves first
+    int shotsFired[2];
+    int hits[2];
+    int wastedShots[2];   // off the board, at an already attacked cell, or forfeited
+};
+
+  // How long one player took to choose its targets in a match played
+  // against the clock (see Game::setMoveTimeLimit)
+struct MoveLatency
+{
+    int moves;
+    double p50Ms;         // median
+    double p99Ms;
+    double maxMs;
+    int overruns;         // moves that ended after their deadline, so were forfeited
+};
 
 class Game
 {
   public:
     Game(int nRows, int nCols);
+    Game(int nRows, int nCols, uint64_t seed);
     ~Game();
     int rows() const;
     int cols() const;
     bool isValid(Point p) const;
     Point randomPoint() const;
+    RandomEngine& rng() const;
+    uint64_t seed() const;
+      // Start the random numbers over, as for a new Game with this seed
+    void reseed(uint64_t seed);
     bool addShip(int length, char symbol, std::string name);
     int nShips() const;
     int shipLength(int shipId) const;
     char shipSymbol(int shipId) const;
-    std::string shipName(int shipId) const;
+    const std::string& shipName(int shipId) const;
+      // The id of the ship drawn with symbol, or -1 if there is none
+    int shipWithSymbol(char symbol) const;
     Player* play(Player* p1, Player* p2, bool shouldPause = true);
+    MatchResult simulate(Player* p1, Player* p2);
+      // Play a match, reporting everything that happens to observer.  This
+      // and play hold each computer player to the move time limit and
+      // record the latencies of both players' moves.
+    MatchResult simulate(Player* p1, Player* p2, GameObserver& observer);
+      // Give computer players at most ms milliseconds for each move in
+      // play and in simulate with an observer, or no limit if ms <= 0; a
+      // move that takes longer is forfeited (see MoveClock).  The default
+      // is a second, so that nobody facing a computer waits long.
+    void setMoveTimeLimit(int ms);
+    int moveTimeLimit() const;
+      // The latencies of player who (0 for the one who moved first) in the
+      // last match played by play or simulate with an observer
+    MoveLatency moveLatency(int who) const;
+      // Append every match played by play or simulate from now on to the
+      // replay file at path (see Replay.h), creating it if need be, or stop
+      // recording if path is empty.  Returns false, and records nothing, if
+      // the file can't be written.
+    bool setReplayFile(std::string path);
+    const std::string& replayFile() const;
       // We prevent a Game object from being copied or assigned
     Game(const Game&) = delete;
     Game& operator=(const Game&) = delete;
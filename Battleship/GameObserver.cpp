@@ -0,0 +1,94 @@
+#include "GameObserver.h"
+#include "Game.h"
+#include "Board.h"
+#include "Player.h"
+#include <iostream>
+
+using namespace std;
+
+void waitForEnter()
+{
+    cout << "Press enter to continue: ";
+    cin.ignore(10000, '\n');
+}
+
+//******************** ConsoleRenderer ********************************
+
+void ConsoleRenderer::matchStarted(const Game& g, Player* const players[2],
+                                   const Board* const boards[2])
+{
+    m_game = &g;
+    for (int i = 0; i < 2; i++)
+    {
+        m_players[i] = players[i];
+        m_boards[i] = boards[i];
+    }
+}
+
+void ConsoleRenderer::event(const GameEvent& e)
+{
+    Player* attacker = m_players[e.player];
+    Player* defender = m_players[1 - e.player];
+    const Board& target = *m_boards[1 - e.player];
+
+    switch (e.kind)
+    {
+      case GameEvent::PLACEMENT_DONE:
+        return;
+      case GameEvent::TURN_START:
+        cout << attacker->name() << "'s turn. Board for " << defender->name() << ":" << endl;
+        target.display(attacker->isHuman()); //if the attacker is human show shots only
+        return;
+      case GameEvent::WIN:
+        if (defender->isHuman())
+        {
+            target.display(false); //let the loser see where the ships were
+        }
+        cout << attacker->name() << " wins!" << endl;
+        return;
+      case GameEvent::WASTED_SHOT:
+        cout << attacker->name() << " wasted a shot at (" << e.p.r << "," << e.p.c << ")." << endl;
+        break;
+      case GameEvent::SINK:
+        cout << attacker->name() << " attacked (" << e.p.r << "," << e.p.c << ") and destroyed the "
+             << m_game->shipName(e.shipId) << ", resulting in:" << endl;
+        break;
+      case GameEvent::HIT:
+        cout << attacker->name() << " attacked (" << e.p.r << "," << e.p.c << ") and hit something, resulting in:" << endl;
+        break;
+      case GameEvent::MISS:
+        cout << attacker->name() << " attacked (" << e.p.r << "," << e.p.c << ") and missed, resulting in:" << endl;
+        break;
+    }
+
+      // After any attack, show its result and pause unless the game is over
+    target.display(attacker->isHuman());
+    if (m_shouldPause  &&  !m_boards[0]->allShipsDestroyed()  &&  !m_boards[1]->allShipsDestroyed())
+    {
+        waitForEnter();
+    }
+}
+
+//******************** BinaryEventLog *********************************
+
+void BinaryEventLog::write(uint8_t kind, uint8_t player, int r, int c, int shipId)
+{
+    char rec[RECORDSIZE] = {
+        char(kind), char(player),
+        char(r & 0xff), char((r >> 8) & 0xff),
+        char(c & 0xff), char((c >> 8) & 0xff),
+        char(shipId < 0 ? 0xff : shipId)
+    };
+    m_out.write(rec, RECORDSIZE);
+}
+
+void BinaryEventLog::matchStarted(const Game& g, Player* const players[2],
+                                  const Board* const boards[2])
+{
+    write(MATCHSTART, 0, g.rows(), g.cols(), -1);
+}
+
+void BinaryEventLog::event(const GameEvent& e)
+{
+    write(uint8_t(e.kind), uint8_t(e.player), e.p.r, e.p.c, e.shipId);
+}
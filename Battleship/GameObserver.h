@@ -0,0 +1,125 @@
+#ifndef GAMEOBSERVER_INCLUDED
+#define GAMEOBSERVER_INCLUDED
+
+#include "globals.h"
+#include <cstdint>
+#include <iosfwd>
+
+class Game;
+class Board;
+class Player;
+
+  // Something that happened during a match.  Every attack produces exactly
+  // one of MISS, HIT, SINK or WASTED_SHOT.
+struct GameEvent
+{
+    enum Kind
+    {
+        PLACEMENT_DONE,   //player has put their fleet on their board
+        TURN_START,       //player is about to choose a target
+        MISS,             //player's shot at p hit nothing
+        HIT,              //player's shot at p hit ship shipId without sinking it
+        SINK,             //player's shot at p sank ship shipId
+        WASTED_SHOT,      //p was off the board or had already been attacked
+        WIN               //player has sunk the whole opposing fleet
+    };
+
+    Kind kind;
+    int player;           //0 for the player who moves first, 1 for the other
+    Point p;              //the cell attacked, for the four kinds of attack
+    int shipId;           //for HIT and SINK, otherwise -1
+};
+
+  // Receives the events of a match as they happen.  players and boards are
+  // indexed like GameEvent::player; boards[i] is player i's own board.
+  // They stay valid until matchEnded is called.
+class GameObserver
+{
+  public:
+    virtual ~GameObserver() {}
+    virtual void matchStarted(const Game& g, Player* const players[2],
+                              const Board* const boards[2]) {}
+    virtual void event(const GameEvent& e) = 0;
+    virtual void matchEnded() {}
+};
+
+  // Ignores everything.  Game::simulate runs its match loop against this
+  // class directly, so the calls compile away and a batch run pays nothing
+  // for events nobody reads.
+class NullObserver final : public GameObserver
+{
+  public:
+    void matchStarted(const Game&, Player* const[2], const Board* const[2]) override {}
+    void event(const GameEvent&) override {}
+    void matchEnded() override {}
+};
+
+  // Passes everything on to two other observers, so that, say, a match can
+  // be shown and recorded at once
+class TeeObserver : public GameObserver
+{
+  public:
+    TeeObserver(GameObserver& first, GameObserver& second)
+     : m_first(first), m_second(second) {}
+    void matchStarted(const Game& g, Player* const players[2],
+                      const Board* const boards[2]) override
+    {
+        m_first.matchStarted(g, players, boards);
+        m_second.matchStarted(g, players, boards);
+    }
+    void event(const GameEvent& e) override
+    {
+        m_first.event(e);
+        m_second.event(e);
+    }
+    void matchEnded() override
+    {
+        m_first.matchEnded();
+        m_second.matchEnded();
+    }
+
+  private:
+    GameObserver& m_first;
+    GameObserver& m_second;
+};
+
+  // Writes the running commentary and board displays that Game::play has
+  // always shown, optionally waiting for enter after each attack
+class ConsoleRenderer : public GameObserver
+{
+  public:
+    explicit ConsoleRenderer(bool shouldPause) : m_shouldPause(shouldPause) {}
+    void matchStarted(const Game& g, Player* const players[2],
+                      const Board* const boards[2]) override;
+    void event(const GameEvent& e) override;
+
+  private:
+    bool m_shouldPause;
+    const Game* m_game = nullptr;
+    Player* m_players[2] = { nullptr, nullptr };
+    const Board* m_boards[2] = { nullptr, nullptr };
+};
+
+  // Appends every event to a stream as a fixed-size little-endian record:
+  // kind and player as one byte each, the row and column as two bytes each,
+  // and the ship id as one byte (255 for none).  Each match begins with a
+  // record of kind MATCHSTART whose row and column fields hold the board
+  // size.
+class BinaryEventLog : public GameObserver
+{
+  public:
+    static const int RECORDSIZE = 7;
+    static const uint8_t MATCHSTART = 0xff;
+
+    explicit BinaryEventLog(std::ostream& out) : m_out(out) {}
+    void matchStarted(const Game& g, Player* const players[2],
+                      const Board* const boards[2]) override;
+    void event(const GameEvent& e) override;
+
+  private:
+    std::ostream& m_out;
+
+    void write(uint8_t kind, uint8_t player, int r, int c, int shipId);
+};
+
+#endif // GAMEOBSERVER_INCLUDED
@@ -0,0 +1,255 @@
+#include "Instrument.h"
+
+#if BATTLESHIP_INSTRUMENT
+
+#include "Player.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+#if defined(__x86_64__)  ||  defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using namespace std;
+
+  // Bucket b of a histogram counts calls that took from 2^(b-1) to 2^b - 1
+  // ticks of the timestamp counter (bucket 0 counts calls that took no
+  // measurable time)
+static const int NBUCKETS = 48;
+  // Distinct player types a thread can keep apart; more are not recorded
+static const int MAXTYPES = 16;
+
+  // Every tally is written only by the thread that owns it, so a relaxed
+  // load and store is enough; the atomics just let the report read them
+static void bump(atomic<uint64_t>& a, uint64_t by)
+{
+    a.store(a.load(memory_order_relaxed) + by, memory_order_relaxed);
+}
+
+struct PhaseStats
+{
+    atomic<uint64_t> calls{0};
+    atomic<uint64_t> totalTicks{0};
+    atomic<uint64_t> maxTicks{0};
+    atomic<uint64_t> hist[NBUCKETS] = {};
+};
+
+struct ThreadStats
+{
+    atomic<const type_info*> types[MAXTYPES] = {};
+    atomic<int> nTypes{0};
+    PhaseStats phases[MAXTYPES][NPHASES];
+    atomic<uint64_t> counters[NCOUNTERS] = {};
+};
+
+  // Each thread's tallies, kept until the program ends so threads that
+  // have finished still show up in the report
+static mutex g_registryLock;
+static vector<unique_ptr<ThreadStats> > g_registry;
+
+static ThreadStats& myStats()
+{
+    static thread_local ThreadStats* mine = nullptr;
+    if (mine == nullptr)
+    {
+        lock_guard<mutex> lock(g_registryLock);
+        g_registry.push_back(unique_ptr<ThreadStats>(new ThreadStats));
+        mine = g_registry.back().get();
+    }
+    return *mine;
+}
+
+static long long clockNs()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(
+                    chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+  // Timestamps come from the processor's cycle counter where there is one,
+  // since reading the system clock can cost more than the calls being
+  // timed.  The report converts ticks to nanoseconds using how far the
+  // counter and the clock have moved since the program started.
+static long long ticks()
+{
+#if defined(__x86_64__)  ||  defined(__i386__)
+    return (long long) __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t t;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(t));
+    return (long long) t;
+#else
+    return clockNs();
+#endif
+}
+
+static const long long g_originTicks = ticks();
+static const long long g_originNs = clockNs();
+
+static double nsPerTick()
+{
+    long long dt = ticks() - g_originTicks;
+    long long dns = clockNs() - g_originNs;
+    return (dt <= 0 ? 1.0 : double(dns) / dt);
+}
+
+PhaseTimer::PhaseTimer(InstrumentPhase phase, const Player* player)
+ : m_phase(phase), m_player(player), m_start(ticks())
+{}
+
+PhaseTimer::~PhaseTimer()
+{
+    uint64_t t = uint64_t(ticks() - m_start);
+    ThreadStats& s = myStats();
+    const type_info* type = &typeid(*m_player);
+    int n = s.nTypes.load(memory_order_relaxed);
+    int slot = 0;
+    while (slot < n  &&  s.types[slot].load(memory_order_relaxed) != type)
+        slot++;
+    if (slot == n)
+    {
+        if (n == MAXTYPES)
+            return;
+        s.types[slot].store(type, memory_order_relaxed);
+        s.nTypes.store(n + 1, memory_order_release);
+    }
+    PhaseStats& p = s.phases[slot][m_phase];
+    bump(p.calls, 1);
+    bump(p.totalTicks, t);
+    if (t > p.maxTicks.load(memory_order_relaxed))
+        p.maxTicks.store(t, memory_order_relaxed);
+    int bucket = (t == 0 ? 0 : 64 - __builtin_clzll(t));
+    bump(p.hist[bucket < NBUCKETS ? bucket : NBUCKETS-1], 1);
+}
+
+void instrumentCount(InstrumentCounter counter)
+{
+    bump(myStats().counters[counter], 1);
+}
+
+//******************** Report *****************************************
+
+static string typeName(const type_info& t)
+{
+#ifdef __GNUG__
+    int status;
+    char* name = abi::__cxa_demangle(t.name(), nullptr, nullptr, &status);
+    if (status == 0)
+    {
+        string result(name);
+        free(name);
+        return result;
+    }
+#endif
+    return t.name();
+}
+
+  // One phase of one player type, summed over the threads
+struct PhaseTotals
+{
+    uint64_t calls = 0;
+    uint64_t totalTicks = 0;
+    uint64_t maxTicks = 0;
+    uint64_t hist[NBUCKETS] = {};
+
+      // Upper end of the bucket holding the given fraction of calls
+    uint64_t quantile(double q) const
+    {
+        uint64_t seen = 0;
+        for (int b = 0; b < NBUCKETS; b++)
+        {
+            seen += hist[b];
+            if (seen > 0  &&  seen >= q * calls)
+                return (uint64_t(1) << b) - 1;
+        }
+        return maxTicks;
+    }
+};
+
+void instrumentReport(ostream& out)
+{
+    static const char* const PHASENAMES[NPHASES] = {
+        "placeShips", "recommendAttack", "recordAttackResult", "board", "render"
+    };
+
+    lock_guard<mutex> lock(g_registryLock);
+    vector<const type_info*> types;
+    vector<PhaseTotals> totals;     //NPHASES per type
+    uint64_t counters[NCOUNTERS] = {};
+    for (size_t i = 0; i < g_registry.size(); i++)
+    {
+        const ThreadStats& s = *g_registry[i];
+        int n = s.nTypes.load(memory_order_acquire);
+        for (int slot = 0; slot < n; slot++)
+        {
+            const type_info* type = s.types[slot].load(memory_order_relaxed);
+            size_t t = 0;
+            while (t < types.size()  &&  *types[t] != *type)
+                t++;
+            if (t == types.size())
+            {
+                types.push_back(type);
+                totals.resize(totals.size() + NPHASES);
+            }
+            for (int ph = 0; ph < NPHASES; ph++)
+            {
+                const PhaseStats& p = s.phases[slot][ph];
+                PhaseTotals& pt = totals[t * NPHASES + ph];
+                pt.calls += p.calls.load(memory_order_relaxed);
+                pt.totalTicks += p.totalTicks.load(memory_order_relaxed);
+                uint64_t mx = p.maxTicks.load(memory_order_relaxed);
+                if (mx > pt.maxTicks)
+                    pt.maxTicks = mx;
+                for (int b = 0; b < NBUCKETS; b++)
+                    pt.hist[b] += p.hist[b].load(memory_order_relaxed);
+            }
+        }
+        for (int c = 0; c < NCOUNTERS; c++)
+            counters[c] += s.counters[c].load(memory_order_relaxed);
+    }
+
+    double k = nsPerTick();
+    char line[200];
+    snprintf(line, sizeof(line), "Instrumentation, %zu thread(s), %.3f ns per tick:",
+             g_registry.size(), k);
+    out << line << endl;
+    snprintf(line, sizeof(line), "%-20s %-19s %12s %12s %10s %10s %10s %12s",
+             "player", "phase", "calls", "total ms", "mean ns", "p50 ns", "p99 ns", "max ns");
+    out << line << endl;
+    for (size_t t = 0; t < types.size(); t++)
+    {
+        string name = typeName(*types[t]);
+        for (int ph = 0; ph < NPHASES; ph++)
+        {
+            const PhaseTotals& pt = totals[t * NPHASES + ph];
+            if (pt.calls == 0)
+                continue;
+            snprintf(line, sizeof(line), "%-20s %-19s %12llu %12.1f %10.0f %10llu %10llu %12llu",
+                     name.c_str(), PHASENAMES[ph], (unsigned long long) pt.calls,
+                     pt.totalTicks * k / 1e6, pt.totalTicks * k / pt.calls,
+                     (unsigned long long) (pt.quantile(0.5) * k),
+                     (unsigned long long) (pt.quantile(0.99) * k),
+                     (unsigned long long) (pt.maxTicks * k));
+            out << line << endl;
+            out << "    calls by log2(ticks):";
+            for (int b = 0; b < NBUCKETS; b++)
+                if (pt.hist[b] != 0)
+                    out << " " << b << ":" << pt.hist[b];
+            out << endl;
+        }
+    }
+    out << "Fleet layouts drawn: " << counters[COUNT_LAYOUT_DRAWS]
+        << ", searches: " << counters[COUNT_LAYOUT_SEARCHES] << endl;
+}
+
+#endif // BATTLESHIP_INSTRUMENT
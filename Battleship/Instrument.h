@@ -0,0 +1,72 @@
+#ifndef INSTRUMENT_INCLUDED
+#define INSTRUMENT_INCLUDED
+
+#include <iosfwd>
+
+// Optional instrumentation of the match loop.  Build with
+// BATTLESHIP_INSTRUMENT defined to 1 to count the calls in each phase of
+// a match and keep a histogram of their latencies, in power-of-two
+// buckets of cycle-counter ticks, for each type of player.  Otherwise every
+// INSTRUMENT_ macro expands to nothing and instrumentReport does nothing,
+// so the disabled build carries no trace of it.
+//
+// When enabled, a timed phase costs two cycle-counter reads (clock reads
+// where the processor has no usable counter) and a few stores to
+// memory owned by the calling thread, so it can be left on for
+// tournaments; the threads' tallies are only combined by the report.
+
+class Player;
+
+enum InstrumentPhase
+{
+    PHASE_PLACE,        //Player::placeShips
+    PHASE_RECOMMEND,    //Player::recommendAttack
+    PHASE_RECORD,       //Player::recordAttackResult
+    PHASE_BOARD,        //Board::attack and checking for a sunk fleet
+    PHASE_RENDER,       //passing events to an observer other than NullObserver
+    NPHASES
+};
+
+  // Plain event counts, not tied to a player
+enum InstrumentCounter
+{
+    COUNT_LAYOUT_DRAWS,         //random fleet layouts tried by FleetPlacer
+    COUNT_LAYOUT_SEARCHES,      //times FleetPlacer fell back to its search
+    NCOUNTERS
+};
+
+#if BATTLESHIP_INSTRUMENT
+
+  // Times the enclosing scope as one call of phase by player
+class PhaseTimer
+{
+  public:
+    PhaseTimer(InstrumentPhase phase, const Player* player);
+    ~PhaseTimer();
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+  private:
+    InstrumentPhase m_phase;
+    const Player* m_player;
+    long long m_start;
+};
+
+void instrumentCount(InstrumentCounter counter);
+
+  // Write a table of everything recorded so far, summed over all threads
+void instrumentReport(std::ostream& out);
+
+#define INSTRUMENT_PHASE(phase, player) PhaseTimer instrumentTimer_(phase, player)
+#define INSTRUMENT_COUNT(counter) instrumentCount(counter)
+
+#else
+
+inline void instrumentReport(std::ostream&) {}
+
+#define INSTRUMENT_PHASE(phase, player) ((void) 0)
+#define INSTRUMENT_COUNT(counter) ((void) 0)
+
+#endif // BATTLESHIP_INSTRUMENT
+
+#endif // INSTRUMENT_INCLUDED
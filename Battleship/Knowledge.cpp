@@ -0,0 +1,422 @@
+#include "Knowledge.h"
+#include "Game.h"
+#include <algorithm>
+
+using namespace std;
+
+  // What the hash keys stand for
+enum { MISS, OPENHIT, SUNKHIT, SUNKSHIP, SHAPE, UNSUREHIT, CANDIDATE };
+
+  // How many placements settle may try in checking the ways the sunk ships
+  // could lie, before it settles for calling their hits unsure
+static const int MAXASSIGNSTEPS = 1 << 12;
+
+  // A fixed random-looking key for each thing a Knowledge can know
+  // (splitmix64's finalizer, so no table has to be built or shared)
+static uint64_t zobristKey(int what, uint64_t n)
+{
+    uint64_t z = (n << 3 | uint64_t(what)) * 0x9E3779B97F4A7C15ULL + 0xD1B54A32D192ED03ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void Knowledge::reset(const Game& g)
+{
+    m_game = &g;
+    m_fired.resize(g.rows(), g.cols());
+    m_blocked.resize(g.rows(), g.cols());
+    m_hit.resize(g.rows(), g.cols());
+    m_openHit.resize(g.rows(), g.cols());
+    m_unsureHit.resize(g.rows(), g.cols());
+    m_placed.resize(g.rows(), g.cols());
+    m_openHits.clear();
+    m_unsureHits.clear();
+    m_shipSunk.assign(g.nShips(), false);
+    m_pending.clear();
+    m_candidates.clear();
+    m_covers.clear();
+    m_coverWeights.clear();
+    m_coversExact = true;
+    m_shipsAfloat = g.nShips();
+    m_hash = zobristKey(SHAPE, uint64_t(g.rows()) << 32 | uint64_t(g.cols()));
+    for (int i = 0; i < g.nShips(); i++)
+        m_hash = zobristKey(SHAPE, m_hash ^ uint64_t(g.shipLength(i)));
+
+      // Room for every placement the sunk ships could have, so that once
+      // the first game has been played, sinks allocate nothing
+    size_t nCandidates = 0;
+    for (int i = 0; i < g.nShips(); i++)
+        nCandidates += (g.shipLength(i) == 1 ? 1 : 2 * g.shipLength(i));
+    m_pending.reserve(g.nShips());
+    m_path.reserve(g.nShips());
+    m_candidates.reserve(nCandidates);
+    m_cellsOf.reserve(nCandidates);
+    m_used.reserve(nCandidates);
+    m_unsureHits.reserve(MAXUNSUREHITS);
+    m_cells.reserve(MAXUNSUREHITS);
+    m_covers.reserve(MAXCOVERS);
+    m_coverWeights.reserve(MAXCOVERS);
+    m_found.reserve(MAXCOVERS);
+    m_foundWeights.reserve(MAXCOVERS);
+}
+
+void Knowledge::block(Point p, vector<Point>* newlyBlocked)
+{
+    if (m_blocked.test(p.r, p.c))
+        return;
+    m_blocked.set(p.r, p.c);
+    if (newlyBlocked != nullptr)
+        newlyBlocked->push_back(p);
+}
+
+void Knowledge::record(Point p, bool shotHit, bool shipDestroyed, int shipId,
+                       vector<Point>* newlyBlocked)
+{
+    if (!m_game->isValid(p))
+        return;
+    m_fired.set(p.r, p.c);
+    int cell = p.r * m_game->cols() + p.c;
+    if (!shotHit)
+    {
+        if (!m_blocked.test(p.r, p.c))
+            m_hash ^= zobristKey(MISS, cell);
+        block(p, newlyBlocked);
+        return;
+    }
+    if (!m_hit.test(p.r, p.c))
+    {
+        m_hit.set(p.r, p.c);
+        m_openHit.set(p.r, p.c);
+        m_openHits.push_back(p);
+        m_hash ^= zobristKey(OPENHIT, cell);
+    }
+    if (shipDestroyed  &&  shipId >= 0  &&  shipId < m_game->nShips()  &&
+        !m_shipSunk[shipId])
+    {
+        m_shipSunk[shipId] = true;
+        m_shipsAfloat--;
+        m_hash ^= zobristKey(SUNKSHIP, shipId);
+        addSunk(p, shipId, newlyBlocked);
+    }
+}
+
+  // The hash keys of the placements the sunk ships not yet placed could
+  // have
+uint64_t Knowledge::candidateKeys() const
+{
+    uint64_t keys = 0;
+    uint64_t nCells = uint64_t(m_game->rows()) * m_game->cols();
+    for (size_t s = 0; s < m_pending.size(); s++)
+    {
+        for (int i = 0; i < m_pending[s].count; i++)
+        {
+            const Candidate& c = m_candidates[m_pending[s].first + i];
+            uint64_t cell = uint64_t(c.topOrLeft.r) * m_game->cols() + c.topOrLeft.c;
+            keys ^= zobristKey(CANDIDATE, (m_pending[s].shipId * nCells + cell) << 1 | c.dir);
+        }
+    }
+    return keys;
+}
+
+  // The ship just sunk at p lies on a line of hits through p made before
+  // it sank, none of them known to be another sunk ship's cell.  Note every
+  // such line, and settle what that tells.
+void Knowledge::addSunk(Point p, int shipId, vector<Point>* newlyBlocked)
+{
+    m_hash ^= candidateKeys();
+    int length = m_game->shipLength(shipId);
+    SunkShip ship = { shipId, int(m_candidates.size()), 0 };
+    for (int dir = HORIZONTAL; dir <= (length == 1 ? HORIZONTAL : VERTICAL); dir++)
+    {
+        int dr = (dir == VERTICAL ? 1 : 0);
+        int dc = (dir == HORIZONTAL ? 1 : 0);
+        for (int offset = 0; offset < length; offset++)
+        {
+            Point start(p.r - offset*dr, p.c - offset*dc);
+            bool fits = true;
+            for (int i = 0; i < length  &&  fits; i++)
+            {
+                Point q(start.r + i*dr, start.c + i*dc);
+                fits = m_game->isValid(q)  &&  m_hit.test(q.r, q.c)  &&  !m_placed.test(q.r, q.c);
+            }
+            if (fits)
+            {
+                Candidate c = { start, Direction(dir) };
+                m_candidates.push_back(c);
+                ship.count++;
+            }
+        }
+    }
+    if (ship.count == 0)
+        setHit(p, SUNKHIT, newlyBlocked); //can't tell where the ship was; at least p is resolved
+    else
+    {
+        m_pending.push_back(ship);
+        settle(newlyBlocked);
+    }
+    m_hash ^= candidateKeys();
+}
+
+  // Make the hit at q an open, unsure or sunk hit, as what says.  A sunk
+  // ship's cell stays one.
+void Knowledge::setHit(Point q, int what, vector<Point>* newlyBlocked)
+{
+    int old = (m_openHit.test(q.r, q.c) ? OPENHIT : m_unsureHit.test(q.r, q.c) ? UNSUREHIT : SUNKHIT);
+    if (old == what  ||  old == SUNKHIT)
+        return;
+    int cell = q.r * m_game->cols() + q.c;
+    m_hash ^= zobristKey(old, cell) ^ zobristKey(what, cell);
+    if (old == OPENHIT)
+    {
+        m_openHit.reset(q.r, q.c);
+        for (size_t k = 0; k < m_openHits.size(); k++)
+        {
+            if (m_openHits[k].r == q.r  &&  m_openHits[k].c == q.c)
+            {
+                m_openHits.erase(m_openHits.begin() + k);
+                break;
+            }
+        }
+    }
+    else
+        m_unsureHit.reset(q.r, q.c);
+    if (what == OPENHIT)
+    {
+        m_openHit.set(q.r, q.c);
+        m_openHits.push_back(q);
+    }
+    else if (what == UNSUREHIT)
+        m_unsureHit.set(q.r, q.c);
+    else
+        block(q, newlyBlocked);
+}
+
+  // The pending sunk ship has only its first placement left, so its cells
+  // are known
+void Knowledge::place(const SunkShip& ship, vector<Point>* newlyBlocked)
+{
+    const Candidate& c = m_candidates[ship.first];
+    for (int j = 0; j < m_game->shipLength(ship.shipId); j++)
+    {
+        Point q(c.topOrLeft.r + (c.dir == VERTICAL ? j : 0),
+                c.topOrLeft.c + (c.dir == HORIZONTAL ? j : 0));
+        m_placed.set(q.r, q.c);
+        setHit(q, SUNKHIT, newlyBlocked);
+    }
+}
+
+  // Try every placement of the pending sunk ship and of those after it
+  // that overlaps none of the cells used so far, noting the cells each
+  // complete choice covers and how many choices cover them.  False if that
+  // takes too many steps or finds too many sets of cells.
+bool Knowledge::assign(size_t ship, uint64_t used, int& budget)
+{
+    if (ship == m_pending.size())
+    {
+        for (size_t s = 0; s < m_path.size(); s++)
+            m_used[m_path[s]] = 1;
+        for (size_t f = 0; f < m_found.size(); f++)
+        {
+            if (m_found[f] == used)
+            {
+                m_foundWeights[f]++;
+                return true;
+            }
+        }
+        if (int(m_found.size()) == MAXCOVERS)
+            return false;
+        m_found.push_back(used);
+        m_foundWeights.push_back(1);
+        return true;
+    }
+    const SunkShip& s = m_pending[ship];
+    for (int i = s.first; i < s.first + s.count; i++)
+    {
+        if (--budget < 0)
+            return false;
+        if ((m_cellsOf[i] & used) != 0)
+            continue;
+        m_path[ship] = i;
+        if (!assign(ship + 1, used | m_cellsOf[i], budget))
+            return false;
+    }
+    return true;
+}
+
+  // Work out from the placements the sunk ships not yet placed could have
+  // which hits must be sunk ships' cells, which can't be and which might
+  // be, and which sets of the last the sunk ships could cover together.
+  // A sunk ship left with one placement is placed there.  A hit may be a
+  // sunk ship's cell however they lie without being known to be any one
+  // ship's, so only placed ships' cells rule out other ships' placements.
+void Knowledge::settle(vector<Point>* newlyBlocked)
+{
+    for (bool placed = true; placed; )
+    {
+        placed = false;
+        for (size_t s = 0; s < m_pending.size(); )
+        {
+            SunkShip& ship = m_pending[s];
+            int length = m_game->shipLength(ship.shipId);
+            int kept = 0;
+            for (int i = 0; i < ship.count; i++)
+            {
+                Candidate c = m_candidates[ship.first + i];
+                bool free = true;
+                for (int j = 0; j < length  &&  free; j++)
+                    free = !m_placed.test(c.topOrLeft.r + (c.dir == VERTICAL ? j : 0),
+                                          c.topOrLeft.c + (c.dir == HORIZONTAL ? j : 0));
+                if (free)
+                    m_candidates[ship.first + kept++] = c;
+            }
+            ship.count = kept;
+            if (kept > 1)
+            {
+                s++;
+                continue;
+            }
+            if (kept == 1)
+            {
+                place(ship, newlyBlocked);
+                placed = true;
+            }
+            m_pending.erase(m_pending.begin() + s); //none left only if the reports contradict
+        }
+    }
+
+      // Number the hits that were unsure or are on a placement still
+      // possible, giving each placement its set of them
+    m_cells.clear();
+    bool overflow = false;
+    for (size_t i = 0; i < m_unsureHits.size(); i++)
+        if (m_unsureHit.test(m_unsureHits[i].r, m_unsureHits[i].c))
+            m_cells.push_back(m_unsureHits[i]);
+    m_cellsOf.assign(m_candidates.size(), 0);
+    uint64_t onAny = 0;
+    for (size_t s = 0; s < m_pending.size(); s++)
+    {
+        int length = m_game->shipLength(m_pending[s].shipId);
+        for (int i = m_pending[s].first; i < m_pending[s].first + m_pending[s].count; i++)
+        {
+            const Candidate& c = m_candidates[i];
+            for (int j = 0; j < length; j++)
+            {
+                Point q(c.topOrLeft.r + (c.dir == VERTICAL ? j : 0),
+                        c.topOrLeft.c + (c.dir == HORIZONTAL ? j : 0));
+                size_t k = 0;
+                while (k < m_cells.size()  &&  (m_cells[k].r != q.r  ||  m_cells[k].c != q.c))
+                    k++;
+                if (k == m_cells.size())
+                {
+                    if (k == size_t(MAXUNSUREHITS))
+                    {
+                        overflow = true;
+                        setHit(q, UNSUREHIT, newlyBlocked);
+                        continue;
+                    }
+                    m_cells.push_back(q);
+                }
+                m_cellsOf[i] |= uint64_t(1) << k;
+            }
+            onAny |= m_cellsOf[i];
+        }
+    }
+
+      // Try every way of placing them together
+    m_found.clear();
+    m_foundWeights.clear();
+    m_used.assign(m_candidates.size(), 0);
+    m_path.resize(m_pending.size());
+    int budget = MAXASSIGNSTEPS;
+    bool exact = !overflow  &&  assign(0, 0, budget)  &&  !m_found.empty();
+    uint64_t sure = ~uint64_t(0);
+    uint64_t maybe = 0;
+    for (size_t f = 0; f < m_found.size(); f++)
+    {
+        sure &= m_found[f];
+        maybe |= m_found[f];
+    }
+    if (!exact)
+    {
+        sure = 0;
+        maybe = (overflow ? ~uint64_t(0) : onAny);
+    }
+    for (size_t k = 0; k < m_cells.size(); k++)
+    {
+        uint64_t b = uint64_t(1) << k;
+        setHit(m_cells[k], (sure & b) != 0 ? SUNKHIT : (maybe & b) != 0 ? UNSUREHIT : OPENHIT,
+               newlyBlocked);
+    }
+
+      // Drop the placements no way uses, placing a ship left with one
+    if (exact)
+    {
+        size_t next = 0;
+        for (size_t s = 0; s < m_pending.size(); s++)
+        {
+            SunkShip& ship = m_pending[s];
+            int kept = 0;
+            for (int i = ship.first; i < ship.first + ship.count; i++)
+                if (m_used[i])
+                    m_candidates[ship.first + kept++] = m_candidates[i];
+            ship.count = kept;
+            if (kept == 1)
+                place(ship, newlyBlocked);
+            else
+                m_pending[next++] = ship;
+        }
+        m_pending.resize(next);
+    }
+    size_t next = 0;
+    for (size_t s = 0; s < m_pending.size(); s++)
+    {
+        SunkShip& ship = m_pending[s];
+        for (int i = 0; i < ship.count; i++)
+            m_candidates[next + i] = m_candidates[ship.first + i];
+        ship.first = int(next);
+        next += ship.count;
+    }
+    m_candidates.resize(next);
+
+      // List the unsure hits in board order, and the ways of covering them
+    m_unsureHits.clear();
+    if (overflow)
+    {
+        for (int r = 0; r < m_game->rows(); r++)
+            for (int c = 0; c < m_game->cols(); c++)
+                if (m_unsureHit.test(r, c))
+                    m_unsureHits.push_back(Point(r, c));
+    }
+    else
+    {
+        for (size_t k = 0; k < m_cells.size(); k++)
+            if (m_unsureHit.test(m_cells[k].r, m_cells[k].c))
+                m_unsureHits.push_back(m_cells[k]);
+        sort(m_unsureHits.begin(), m_unsureHits.end(), [](const Point& a, const Point& b) {
+            return a.r < b.r  ||  (a.r == b.r  &&  a.c < b.c);
+        });
+    }
+    m_covers.clear();
+    m_coverWeights.clear();
+    m_coversExact = (exact  ||  m_unsureHits.empty());
+    if (!exact  ||  m_unsureHits.empty())
+        return;
+    int cellOf[MAXUNSUREHITS];
+    for (size_t u = 0; u < m_unsureHits.size(); u++)
+    {
+        int k = 0;
+        while (m_cells[k].r != m_unsureHits[u].r  ||  m_cells[k].c != m_unsureHits[u].c)
+            k++;
+        cellOf[u] = k;
+    }
+    for (size_t f = 0; f < m_found.size(); f++)
+    {
+        uint64_t cover = 0;
+        for (size_t u = 0; u < m_unsureHits.size(); u++)
+            if ((m_found[f] >> cellOf[u]) & 1)
+                cover |= uint64_t(1) << u;
+        m_covers.push_back(cover);
+        m_coverWeights.push_back(m_foundWeights[f]);
+    }
+}
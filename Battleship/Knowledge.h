@@ -0,0 +1,132 @@
+#ifndef KNOWLEDGE_INCLUDED
+#define KNOWLEDGE_INCLUDED
+
+#include "globals.h"
+#include "BitGrid.h"
+#include <cstdint>
+#include <vector>
+
+class Game;
+
+  // What an attacking player has learned about the opponent's board from
+  // the results of its own shots: where it has fired, which cells can't
+  // hold a ship that is still afloat (misses and the cells of sunk ships),
+  // which hits don't belong to a sunk ship, and which ships are sunk.
+  //
+  // When a ship sinks, the report says which ship but not which of the
+  // hits were its cells.  Knowledge keeps every placement of each sunk
+  // ship that lies on hits made before it sank, and checks every way of
+  // choosing one for each sunk ship without two overlapping.  A hit that
+  // belongs to a sunk ship however they are chosen can't hold a ship
+  // afloat; one that belongs to none is an open hit, on a ship afloat;
+  // the rest are unsure hits, and sunkCovers lists which of them the sunk
+  // ships could cover together, so that a search can weigh each way as
+  // it should.
+  //
+  // It also keeps a Zobrist hash of all that, updated by record: a random
+  // 64-bit key for the game's shape, XORed with a key for each miss, each
+  // open, unsure and sunk hit, each sunk ship and each placement a sunk
+  // ship could still have.  The keys are the same in every run, so two
+  // Knowledges reached by different orders of shots, in different games of
+  // the same shape or on different threads, have the same hash exactly when
+  // they know the same.  Cells marked fired whose results aren't in don't
+  // count.
+class Knowledge
+{
+  public:
+      // The most unsure hits, and ways the sunk ships can cover them, that
+      // are worked out exactly; past that, sunkCovers is left empty
+    static const int MAXUNSUREHITS = 64;
+    static const int MAXCOVERS = 64;
+
+    Knowledge() : m_game(nullptr) {}
+    explicit Knowledge(const Game& g) { reset(g); }
+    void reset(const Game& g);
+
+      // Record the result of a valid shot at p.  Any cells that this shows
+      // can't hold an unsunk ship are appended to newlyBlocked, if given.
+    void record(Point p, bool shotHit, bool shipDestroyed, int shipId,
+                std::vector<Point>* newlyBlocked = nullptr);
+      // Note a cell as fired at before its result is known
+    void markFired(Point p) { m_fired.set(p.r, p.c); }
+      // Forget that mark, as the shot never landed; a cell whose result is
+      // in stays fired
+    void unmarkFired(Point p)
+    {
+        if (!m_hit.test(p.r, p.c)  &&  !m_blocked.test(p.r, p.c))
+            m_fired.reset(p.r, p.c);
+    }
+
+    bool fired(int r, int c) const { return m_fired.test(r, c); }
+    bool blocked(int r, int c) const { return m_blocked.test(r, c); }
+    bool hit(int r, int c) const { return m_hit.test(r, c); }
+    bool openHit(int r, int c) const { return m_openHit.test(r, c); }
+    bool unsureHit(int r, int c) const { return m_unsureHit.test(r, c); }
+    const BitGrid& firedCells() const { return m_fired; }
+    const BitGrid& blockedCells() const { return m_blocked; }
+    const BitGrid& hitCells() const { return m_hit; }
+    const BitGrid& openHitCells() const { return m_openHit; }
+    const std::vector<Point>& openHits() const { return m_openHits; }
+      // In board order
+    const std::vector<Point>& unsureHits() const { return m_unsureHits; }
+      // The distinct sets of unsure hits the sunk ships could cover, bit i
+      // standing for unsureHits()[i], and how many ways of placing the
+      // sunk ships give each.  Empty if there are no unsure hits, or if
+      // there are too many to list, when sunkCoversExact is false.
+    const std::vector<uint64_t>& sunkCovers() const { return m_covers; }
+    const std::vector<int>& sunkCoverWeights() const { return m_coverWeights; }
+    bool sunkCoversExact() const { return m_coversExact; }
+    bool shipSunk(int shipId) const { return m_shipSunk[shipId]; }
+    int shipsAfloat() const { return m_shipsAfloat; }
+    uint64_t hash() const { return m_hash; }
+
+  private:
+      // A sunk ship whose cells aren't known yet, and the placements it
+      // could have, m_candidates[first] on
+    struct SunkShip
+    {
+        int shipId;
+        int first;
+        int count;
+    };
+    struct Candidate
+    {
+        Point topOrLeft;
+        Direction dir;
+    };
+
+    const Game* m_game;
+    BitGrid m_fired;
+    BitGrid m_blocked;
+    BitGrid m_hit;
+    BitGrid m_openHit;
+    BitGrid m_unsureHit;
+    BitGrid m_placed;               //cells of the sunk ships known to be there
+    std::vector<Point> m_openHits;  //the cells of m_openHit, as a list
+    std::vector<Point> m_unsureHits;
+    std::vector<bool> m_shipSunk;
+    std::vector<SunkShip> m_pending;
+    std::vector<Candidate> m_candidates;
+    std::vector<uint64_t> m_covers;
+    std::vector<int> m_coverWeights;
+    bool m_coversExact;
+    int m_shipsAfloat;
+    uint64_t m_hash;
+      // Scratch space for settle, kept so that a sink allocates nothing
+    std::vector<Point> m_cells;          //hits that may be a sunk ship's
+    std::vector<uint64_t> m_cellsOf;     //per candidate, bits of m_cells
+    std::vector<char> m_used;            //per candidate, in some assignment
+    std::vector<int> m_path;             //a candidate per pending ship
+    std::vector<uint64_t> m_found;       //assignments' cells, distinct
+    std::vector<int> m_foundWeights;
+
+    void addSunk(Point p, int shipId, std::vector<Point>* newlyBlocked);
+    void place(const SunkShip& ship, std::vector<Point>* newlyBlocked);
+    void settle(std::vector<Point>* newlyBlocked);
+    bool assign(size_t ship, uint64_t used, int& budget);
+    void setHit(Point q, int what, std::vector<Point>* newlyBlocked);
+    uint64_t candidateKeys() const;
+    void block(Point p, std::vector<Point>* newlyBlocked);
+};
+
+#endif // KNOWLEDGE_INCLUDED
@@ -0,0 +1,282 @@
+#include "Lockstep.h"
+#include "Game.h"
+#include "globals.h"
+
+#if (defined(__x86_64__)  ||  defined(__i386__))  &&  (defined(__GNUC__)  ||  defined(__clang__))
+#define LOCKSTEP_AVX2 1
+#include <immintrin.h>
+#else
+#define LOCKSTEP_AVX2 0
+#endif
+
+using namespace std;
+
+static const int32_t RUNNING = -2;
+static const int32_t NOBODY = -1;
+
+LockstepSweep::LockstepSweep(const Game& g)
+ : m_nCells(g.rows() * g.cols()), m_nWords((g.rows() * g.cols() + 31) / 32), m_nMatches(0),
+   m_rows(g.rows()), m_cols(g.cols())
+{
+    for (int i = 0; i < g.nShips(); i++)
+        m_shipLength.push_back(uint16_t(g.shipLength(i)));
+}
+
+void LockstepSweep::clear()
+{
+    m_nMatches = 0;
+    for (int p = 0; p < 2; p++)
+    {
+        for (int w = 0; w < MAXWORDS; w++)
+            m_fleet[p][w].clear();
+        m_cells[p].clear();
+        m_remaining[p].clear();
+        m_cursor[p].clear();
+    }
+    m_turns.clear();
+    m_winner.clear();
+}
+
+  // Make room for another group of lanes, all finished
+void LockstepSweep::addGroup()
+{
+    size_t n = m_winner.size() + LANES;
+    for (int p = 0; p < 2; p++)
+    {
+        for (int w = 0; w < m_nWords; w++)
+            m_fleet[p][w].resize(n, 0);
+        m_cells[p].resize(n, 0);
+        m_remaining[p].resize(n, 0);
+        m_cursor[p].resize(n, 0);
+    }
+    m_turns.resize(n, 0);
+    m_winner.resize(n, NOBODY);
+}
+
+bool LockstepSweep::addFleet(int lane, int player, const vector<FleetPlacer::Placement>& fleet)
+{
+    uint32_t bits[MAXWORDS] = {};
+    int cells = 0;
+    for (size_t i = 0; i < fleet.size(); i++)
+    {
+        const FleetPlacer::Placement& pl = fleet[i];
+        if (pl.shipId < 0  ||  pl.shipId >= int(m_shipLength.size()))
+            return false;
+        int dr = (pl.dir == VERTICAL ? 1 : 0);
+        int dc = 1 - dr;
+        for (int k = 0; k < m_shipLength[pl.shipId]; k++)
+        {
+            int r = pl.topOrLeft.r + k * dr;
+            int c = pl.topOrLeft.c + k * dc;
+            if (r < 0  ||  r >= m_rows  ||  c < 0  ||  c >= m_cols)
+                return false;
+            int cell = r * m_cols + c;
+            if (bits[cell / 32] & (1u << (cell % 32)))
+                return false; //ships overlap
+            bits[cell / 32] |= 1u << (cell % 32);
+            cells++;
+        }
+    }
+    for (int w = 0; w < m_nWords; w++)
+        m_fleet[player][w][lane] = bits[w];
+    m_cells[player][lane] = cells;
+    m_remaining[player][lane] = cells;
+    return true;
+}
+
+int LockstepSweep::addMatch(const vector<FleetPlacer::Placement>& fleet1,
+                            const vector<FleetPlacer::Placement>& fleet2)
+{
+    if (m_nCells > MAXCELLS)
+        return -1;
+    int lane = m_nMatches;
+    if (lane == int(m_winner.size()))
+        addGroup();
+    if (!addFleet(lane, 0, fleet1)  ||  !addFleet(lane, 1, fleet2))
+    {
+        for (int p = 0; p < 2; p++) //leave the lane finished
+        {
+            for (int w = 0; w < m_nWords; w++)
+                m_fleet[p][w][lane] = 0;
+            m_cells[p][lane] = m_remaining[p][lane] = 0;
+        }
+        return -1;
+    }
+      // AwfulPlayer starts as if it had last attacked (0,0)
+    m_cursor[0][lane] = m_cursor[1][lane] = 0;
+    m_turns[lane] = 0;
+      // As in runMatch, an empty fleet can't lose, so nobody wins
+    m_winner[lane] = (m_cells[0][lane] == 0  ||  m_cells[1][lane] == 0 ? NOBODY : RUNNING);
+    m_nMatches++;
+    return lane;
+}
+
+int LockstepSweep::shotsFired(int match, int player) const
+{
+    if (m_winner[match] < 0)
+        return 0;
+      // The first player shoots every turn; the second skips the last one
+      // if the first won it
+    return m_turns[match] - (player == 1  &&  m_winner[match] == 0 ? 1 : 0);
+}
+
+int LockstepSweep::hits(int match, int player) const
+{
+    return m_cells[1-player][match] - m_remaining[1-player][match];
+}
+
+//******************** Scalar kernel **********************************
+
+void LockstepSweep::runScalar()
+{
+    int last = m_nCells - 1;
+    for (int lane = 0; lane < m_nMatches; lane++)
+    {
+        if (m_winner[lane] != RUNNING)
+            continue;
+        int cursor[2] = { m_cursor[0][lane], m_cursor[1][lane] };
+        int remaining[2] = { m_remaining[0][lane], m_remaining[1][lane] };
+        int turns = m_turns[lane];
+        int winner = RUNNING;
+        while (winner == RUNNING)
+        {
+            turns++;
+            for (int p = 0; p < 2; p++)
+            {
+                cursor[p] = (cursor[p] == 0 ? last : cursor[p] - 1);
+                int cell = cursor[p];
+                if ((m_fleet[1-p][cell / 32][lane] >> (cell % 32)) & 1)
+                {
+                    if (--remaining[1-p] == 0)
+                    {
+                        winner = p;
+                        break;
+                    }
+                }
+            }
+        }
+        for (int p = 0; p < 2; p++)
+        {
+            m_cursor[p][lane] = cursor[p];
+            m_remaining[p][lane] = remaining[p];
+        }
+        m_turns[lane] = turns;
+        m_winner[lane] = winner;
+    }
+}
+
+//******************** AVX2 kernel ************************************
+
+#if LOCKSTEP_AVX2
+
+#define AVX2 __attribute__((target("avx2")))
+
+  // Each lane's cursor moved back a cell, wrapping from 0 to last
+AVX2 static inline __m256i previousCell(__m256i cursor, __m256i last)
+{
+    __m256i moved = _mm256_sub_epi32(cursor, _mm256_set1_epi32(1));
+    __m256i wrapped = _mm256_cmpgt_epi32(_mm256_setzero_si256(), moved);
+    return _mm256_blendv_epi8(moved, last, wrapped);
+}
+
+  // All ones in each lane whose fleet has a ship at cell
+template <int W>
+AVX2 static inline __m256i occupied(const __m256i fleet[W], __m256i cell)
+{
+    __m256i word = _mm256_srli_epi32(cell, 5);
+    __m256i bit = _mm256_sllv_epi32(_mm256_set1_epi32(1),
+                                    _mm256_and_si256(cell, _mm256_set1_epi32(31)));
+    __m256i bits = _mm256_setzero_si256();
+    for (int w = 0; w < W; w++)
+        bits = _mm256_or_si256(bits, _mm256_and_si256(fleet[w],
+                                  _mm256_cmpeq_epi32(word, _mm256_set1_epi32(w))));
+    __m256i clear = _mm256_cmpeq_epi32(_mm256_and_si256(bits, bit), _mm256_setzero_si256());
+    return _mm256_xor_si256(clear, _mm256_set1_epi32(-1));
+}
+
+  // Play out the group of lanes starting at lane base, with the fleets of
+  // W words
+template <int W>
+AVX2 static void runGroup(const vector<uint32_t> (&fleets)[2][LockstepSweep::MAXWORDS],
+                          int32_t* cursors[2], int32_t* remainings[2], int32_t* turnsOut,
+                          int32_t* winnerOut, int base, int nCells)
+{
+    __m256i fleet[2][W];
+    for (int p = 0; p < 2; p++)
+        for (int w = 0; w < W; w++)
+            fleet[p][w] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&fleets[p][w][base]));
+    __m256i cursor0 = _mm256_loadu_si256(reinterpret_cast<__m256i*>(cursors[0] + base));
+    __m256i cursor1 = _mm256_loadu_si256(reinterpret_cast<__m256i*>(cursors[1] + base));
+    __m256i remaining0 = _mm256_loadu_si256(reinterpret_cast<__m256i*>(remainings[0] + base));
+    __m256i remaining1 = _mm256_loadu_si256(reinterpret_cast<__m256i*>(remainings[1] + base));
+    __m256i turns = _mm256_loadu_si256(reinterpret_cast<__m256i*>(turnsOut + base));
+    __m256i winner = _mm256_loadu_si256(reinterpret_cast<__m256i*>(winnerOut + base));
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i last = _mm256_set1_epi32(nCells - 1);
+    __m256i running = _mm256_cmpeq_epi32(winner, _mm256_set1_epi32(RUNNING));
+
+    while (!_mm256_testz_si256(running, running))
+    {
+        turns = _mm256_sub_epi32(turns, running); //running lanes are -1
+
+        cursor0 = _mm256_blendv_epi8(cursor0, previousCell(cursor0, last), running);
+        __m256i hit = _mm256_and_si256(occupied<W>(fleet[1], cursor0), running);
+        remaining1 = _mm256_add_epi32(remaining1, hit);
+        __m256i sunk = _mm256_and_si256(_mm256_cmpeq_epi32(remaining1, zero), hit);
+        winner = _mm256_blendv_epi8(winner, zero, sunk);
+        running = _mm256_andnot_si256(sunk, running);
+
+        cursor1 = _mm256_blendv_epi8(cursor1, previousCell(cursor1, last), running);
+        hit = _mm256_and_si256(occupied<W>(fleet[0], cursor1), running);
+        remaining0 = _mm256_add_epi32(remaining0, hit);
+        sunk = _mm256_and_si256(_mm256_cmpeq_epi32(remaining0, zero), hit);
+        winner = _mm256_blendv_epi8(winner, one, sunk);
+        running = _mm256_andnot_si256(sunk, running);
+    }
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(cursors[0] + base), cursor0);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(cursors[1] + base), cursor1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(remainings[0] + base), remaining0);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(remainings[1] + base), remaining1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(turnsOut + base), turns);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(winnerOut + base), winner);
+}
+
+#undef AVX2
+
+#endif // LOCKSTEP_AVX2
+
+bool LockstepSweep::vectorized()
+{
+#if LOCKSTEP_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+void LockstepSweep::run()
+{
+    if (m_nMatches == 0)
+        return;
+#if LOCKSTEP_AVX2
+    if (vectorized())
+    {
+        typedef void (*GroupFn)(const vector<uint32_t> (&)[2][MAXWORDS], int32_t*[2],
+                                int32_t*[2], int32_t*, int32_t*, int, int);
+        static const GroupFn RUNGROUP[MAXWORDS] = {
+            runGroup<1>, runGroup<2>, runGroup<3>, runGroup<4>,
+            runGroup<5>, runGroup<6>, runGroup<7>, runGroup<8>
+        };
+        GroupFn fn = RUNGROUP[m_nWords - 1];
+        int32_t* cursors[2] = { m_cursor[0].data(), m_cursor[1].data() };
+        int32_t* remainings[2] = { m_remaining[0].data(), m_remaining[1].data() };
+        for (int base = 0; base < m_nMatches; base += LANES)
+            fn(m_fleet, cursors, remainings, m_turns.data(), m_winner.data(), base, m_nCells);
+        return;
+    }
+#endif
+    runScalar();
+}
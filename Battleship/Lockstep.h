@@ -0,0 +1,74 @@
+#ifndef LOCKSTEP_INCLUDED
+#define LOCKSTEP_INCLUDED
+
+#include "FleetPlacer.h"
+#include <cstdint>
+#include <vector>
+
+class Game;
+
+  // Plays many matches at once between two players that attack as
+  // AwfulPlayer does, sweeping backwards from the last cell attacked, each
+  // match with its own two fleets.  The matches are kept as arrays of
+  // lanes, a fleet as a bit per cell, and they advance one turn at a time,
+  // eight lanes to an AVX2 instruction where the processor has that; a
+  // lane whose match is over is masked off until the rest of its group is
+  // done.  Every match ends exactly as runMatch would end it for two such
+  // players with those fleets, turn for turn.  Boards of at most MAXCELLS
+  // cells only.
+class LockstepSweep
+{
+  public:
+    static const int MAXCELLS = 256;
+
+    explicit LockstepSweep(const Game& g);
+
+      // Add a match between a player with fleet1, who moves first, and one
+      // with fleet2, given as ships of g; returns the match's index, or -1
+      // if a fleet doesn't fit on the board or the board is too big
+    int addMatch(const std::vector<FleetPlacer::Placement>& fleet1,
+                 const std::vector<FleetPlacer::Placement>& fleet2);
+    int nMatches() const { return m_nMatches; }
+    void clear();
+
+      // Play every match added since the last run
+    void run();
+      // The same, one lane at a time, whatever the processor
+    void runScalar();
+
+      // For a match that has been run: the player who won (0 for the one
+      // who moved first), or -1 if it couldn't be played because a fleet
+      // was empty; the turns started, as MatchResult counts them; and for
+      // each player, the shots they fired and how many hit
+    int winner(int match) const { return m_winner[match]; }
+    int turns(int match) const { return m_turns[match]; }
+    int shotsFired(int match, int player) const;
+    int hits(int match, int player) const;
+
+      // Whether run uses AVX2 on this processor
+    static bool vectorized();
+
+    static const int LANES = 8;     //matches per group
+    static const int MAXWORDS = MAXCELLS / 32;
+
+  private:
+    int m_nCells;
+    int m_nWords;                   //32-bit words in a fleet
+    int m_nMatches;
+      // Everything below has a slot per lane, with the lanes past
+      // m_nMatches, up to a whole group, holding finished matches
+    std::vector<uint32_t> m_fleet[2][MAXWORDS]; //bit k for cell k
+    std::vector<int32_t> m_cells[2];      //cells in each fleet
+    std::vector<int32_t> m_remaining[2];  //cells of each fleet not yet hit
+    std::vector<int32_t> m_cursor[2];     //the cell each player last attacked
+    std::vector<int32_t> m_turns;
+    std::vector<int32_t> m_winner;        //RUNNING until the match ends
+    std::vector<uint16_t> m_shipLength;
+    int m_rows;
+    int m_cols;
+
+    bool addFleet(int lane, int player, const std::vector<FleetPlacer::Placement>& fleet);
+    void addGroup();
+};
+
+#endif // LOCKSTEP_INCLUDED
@@ -0,0 +1,204 @@
+#ifndef MATCH_INCLUDED
+#define MATCH_INCLUDED
+
+// The match loop, as a template on the two players' types and the
+// observer's.  Game::simulate instantiates it for Player, so every call
+// goes through Player's virtual functions; code that knows which kinds of
+// player are playing can instantiate it for the classes in Players.h
+// instead, which are final, so the calls are direct and the small ones
+// are inlined.  Both make exactly the same calls in the same order, so
+// with the same seed they play exactly the same match.
+
+#include "Game.h"
+#include "Board.h"
+#include "Player.h"
+#include "globals.h"
+#include "GameObserver.h"
+#include "Instrument.h"
+#include "MoveClock.h"
+
+  // Pass an event on to the observer.  NullObserver gets nothing at
+  // all, not even a timer.
+inline void notifyObserver(NullObserver&, const GameEvent&, const Player*)
+{}
+
+inline void notifyObserver(GameObserver& observer, const GameEvent& e, const Player* p)
+{
+    INSTRUMENT_PHASE(PHASE_RENDER, p);
+    observer.event(e);
+}
+
+  // Have player who place their fleet on their own board; false if
+  // they couldn't
+template <class P, class Observer>
+bool placeFleet(P* player, Board& own, int who, Observer& observer)
+{
+    bool placed;
+    {
+        INSTRUMENT_PHASE(PHASE_PLACE, player);
+        placed = player->placeShips(own);
+    }
+    if (placed)
+    {
+        GameEvent e = { GameEvent::PLACEMENT_DONE, who, Point(), -1 };
+        notifyObserver(observer, e, player);
+    }
+    return placed;
+}
+
+  // Fire the attacker's shot at p on the target board, telling the
+  // observer and tallying the shot in slot who of the result.  Returns
+  // true if that sank the last of the target's ships, after telling the
+  // observer of the win.
+template <class P, class Observer>
+bool resolveShot(P* attacker, Point p, Board& target, int who, Observer& observer,
+                 MatchResult& result)
+{
+    GameEvent e = { GameEvent::MISS, who, p, -1 };
+    bool shotHit;
+    bool shipDestroyed;
+    int shipId;
+    result.shotsFired[who]++;
+    bool valid;
+    bool allSunk;
+    {
+        INSTRUMENT_PHASE(PHASE_BOARD, attacker);
+        valid = target.attack(e.p, shotHit, shipDestroyed, shipId);
+        allSunk = target.allShipsDestroyed();
+    }
+    if (!valid)
+    {
+        result.wastedShots[who]++;
+        e.kind = GameEvent::WASTED_SHOT; //off the board or already attacked
+    }
+    else
+    {
+        {
+            INSTRUMENT_PHASE(PHASE_RECORD, attacker);
+            attacker->recordAttackResult(e.p, true, shotHit, shipDestroyed, shipId);
+        }
+        if (shotHit)
+        {
+            result.hits[who]++;
+        }
+        e.kind = (shipDestroyed ? GameEvent::SINK : shotHit ? GameEvent::HIT : GameEvent::MISS);
+        e.shipId = shipId;
+    }
+    notifyObserver(observer, e, attacker);
+    if (allSunk)
+    {
+        result.winner = attacker;
+        GameEvent win = { GameEvent::WIN, who, Point(), -1 };
+        notifyObserver(observer, win, attacker);
+    }
+    return allSunk;
+}
+
+  // Have the attacker choose a target, asked through clock, and fire at
+  // it, as resolveShot.  A move the clock says came too late is forfeited.
+template <class P, class Observer, class Clock>
+bool takeShot(P* attacker, Board& target, int who, Observer& observer, Clock& clock,
+              MatchResult& result)
+{
+    GameEvent e = { GameEvent::TURN_START, who, Point(), -1 };
+    clock.startTurn();
+    notifyObserver(observer, e, attacker);
+    Point p;
+    bool inTime;
+    {
+        INSTRUMENT_PHASE(PHASE_RECOMMEND, attacker);
+        inTime = clock.recommend(attacker, who, p);
+    }
+    if (!inTime)
+    {
+          // Forfeited: the turn goes on a shot off the board, and the
+          // attacker learns that its own shot never landed
+        {
+            INSTRUMENT_PHASE(PHASE_RECORD, attacker);
+            attacker->recordAttackResult(p, false, false, false, -1);
+        }
+        p = Point(-1, -1);
+    }
+    return resolveShot(attacker, p, target, who, observer, result);
+}
+
+  // The same, with no time limit
+template <class P, class Observer>
+bool takeShot(P* attacker, Board& target, int who, Observer& observer, MatchResult& result)
+{
+    UntimedMoves untimed;
+    return takeShot(attacker, target, who, observer, untimed, result);
+}
+
+  // Play a match between p1, who moves first, and p2 on the boards b1 and
+  // b2, which must be empty, filling in result, which must start zeroed.
+  // Observer is either NullObserver, whose calls compile away, or
+  // GameObserver, which dispatches to whatever sink the caller supplied.
+  // Clock is UntimedMoves, which compiles away too, or MoveClock, which
+  // holds the players to its move time limit.
+template <class P1, class P2, class Observer, class Clock>
+void runMatch(const Game& g, P1* p1, P2* p2, Board& b1, Board& b2,
+              Observer& observer, Clock& clock, MatchResult& result)
+{
+    Player* const players[2] = { p1, p2 };
+    const Board* const constBoards[2] = { &b1, &b2 };
+    observer.matchStarted(g, players, constBoards);
+    if (!placeFleet(p1, b1, 0, observer)  ||  !placeFleet(p2, b2, 1, observer))
+    {
+        observer.matchEnded();
+        return; //a player could not place their ships, so nobody wins
+    }
+    if (b1.allShipsDestroyed() || b2.allShipsDestroyed())
+    {
+        observer.matchEnded();
+        return; //an empty fleet can't lose, so nobody wins
+    }
+      // Only the board just attacked can have become empty
+    for (;;)
+    {
+        result.turns++;
+        if (takeShot(p1, b2, 0, observer, clock, result)  ||
+            takeShot(p2, b1, 1, observer, clock, result))
+        {
+            break;
+        }
+    }
+    observer.matchEnded();
+}
+
+  // The same, with no time limit
+template <class P1, class P2, class Observer>
+void runMatch(const Game& g, P1* p1, P2* p2, Board& b1, Board& b2,
+              Observer& observer, MatchResult& result)
+{
+    UntimedMoves untimed;
+    runMatch(g, p1, p2, b1, b2, observer, untimed, result);
+}
+
+  // Game::simulate for players whose types are known at compile time,
+  // played on boards made for g, which are cleared first.  Recycling the
+  // boards and players (see Player::reset) lets match after match be
+  // played without allocating.
+template <class P1, class P2>
+MatchResult simulateMatch(const Game& g, P1& p1, P2& p2, Board& b1, Board& b2)
+{
+    MatchResult result = { nullptr, 0, { 0, 0 }, { 0, 0 }, { 0, 0 } };
+    if (g.nShips() == 0)
+        return result;
+    b1.clear();
+    b2.clear();
+    NullObserver none;
+    runMatch(g, &p1, &p2, b1, b2, none, result);
+    return result;
+}
+
+  // The same, on boards made just for this match
+template <class P1, class P2>
+MatchResult simulateMatch(const Game& g, P1& p1, P2& p2)
+{
+    Board b1(g);
+    Board b2(g);
+    return simulateMatch(g, p1, p2, b1, b2);
+}
+
+#endif // MATCH_INCLUDED
@@ -0,0 +1,204 @@
+#include "MatchClient.h"
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace Protocol;
+
+#ifdef MSG_NOSIGNAL
+static const int SENDFLAGS = MSG_NOSIGNAL;
+#else
+static const int SENDFLAGS = 0;
+#endif
+
+MatchClient::MatchClient()
+ : m_fd(-1), m_inPos(0)
+{}
+
+MatchClient::~MatchClient()
+{
+    disconnect();
+}
+
+bool MatchClient::connect(const string& path)
+{
+    disconnect();
+    sockaddr_un addr = sockaddr_un();
+    if (path.size() >= sizeof(addr.sun_path))
+        return false;
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+    m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_fd < 0)
+        return false;
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(m_fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    if (::connect(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+void MatchClient::disconnect()
+{
+    if (m_fd >= 0)
+        close(m_fd);
+    m_fd = -1;
+    m_in.clear();
+    m_inPos = 0;
+}
+
+bool MatchClient::newGame(Opponent opponent)
+{
+    m_out.clear();
+    size_t start = beginFrame(m_out, NEW_GAME);
+    m_out.push_back(uint8_t(opponent));
+    endFrame(m_out, start);
+    return send();
+}
+
+bool MatchClient::place(const vector<FleetPlacer::Placement>& fleet)
+{
+    m_out.clear();
+    size_t start = beginFrame(m_out, PLACE);
+    m_out.push_back(uint8_t(fleet.size()));
+    for (size_t i = 0; i < fleet.size(); i++)
+    {
+        m_out.push_back(uint8_t(fleet[i].shipId));
+        put16(m_out, fleet[i].topOrLeft.r);
+        put16(m_out, fleet[i].topOrLeft.c);
+        m_out.push_back(fleet[i].dir == HORIZONTAL ? 0 : 1);
+    }
+    endFrame(m_out, start);
+    return send();
+}
+
+bool MatchClient::fire(Point p)
+{
+    m_out.clear();
+    size_t start = beginFrame(m_out, FIRE);
+    put16(m_out, p.r);
+    put16(m_out, p.c);
+    endFrame(m_out, start);
+    return send();
+}
+
+bool MatchClient::send()
+{
+    size_t sent = 0;
+    while (m_fd >= 0  &&  sent < m_out.size())
+    {
+        ssize_t n = ::send(m_fd, m_out.data() + sent, m_out.size() - sent, SENDFLAGS);
+        if (n > 0)
+            sent += n;
+        else if (n < 0  &&  errno == EINTR)
+            continue;
+        else
+            disconnect();
+    }
+    return m_fd >= 0;
+}
+
+bool MatchClient::receive(ServerMessage& m, bool wait)
+{
+    for (;;)
+    {
+        if (m_fd < 0)
+            return false;
+        size_t have = m_in.size() - m_inPos;
+        if (have >= 2)
+        {
+            int length = get16(&m_in[m_inPos]);
+            if (length < 1  ||  length + 2 > MAXFRAME)
+            {
+                disconnect();
+                return false;
+            }
+            if (have >= size_t(length) + 2)
+            {
+                const uint8_t* frame = &m_in[m_inPos];
+                m_inPos += length + 2;
+                if (!decode(m, frame + 2, length))
+                {
+                    disconnect();
+                    return false;
+                }
+                return true;
+            }
+        }
+
+          // Need more; first move what's left to the front
+        m_in.erase(m_in.begin(), m_in.begin() + m_inPos);
+        m_inPos = 0;
+        uint8_t buffer[4096];
+        ssize_t n = recv(m_fd, buffer, sizeof(buffer), wait ? 0 : MSG_DONTWAIT);
+        if (n > 0)
+            m_in.insert(m_in.end(), buffer, buffer + n);
+        else if (n < 0  &&  errno == EINTR)
+            continue;
+        else if (n < 0  &&  !wait  &&  (errno == EAGAIN  ||  errno == EWOULDBLOCK))
+            return false;
+        else
+        {
+            disconnect();
+            return false;
+        }
+    }
+}
+
+  // frame holds the type byte and then the payload
+bool MatchClient::decode(ServerMessage& m, const uint8_t* frame, int length)
+{
+    const uint8_t* payload = frame + 1;
+    length--;
+    m.type = MessageType(frame[0]);
+    switch (m.type)
+    {
+      case GAME_START:
+      {
+        if (length < 6  ||  length != 6 + 3 * payload[5])
+            return false;
+        m.rows = get16(payload);
+        m.cols = get16(payload + 2);
+        m.value = payload[4];
+        m.shipLengths.clear();
+        m.shipSymbols.clear();
+        for (int i = 0; i < payload[5]; i++)
+        {
+            m.shipLengths.push_back(get16(payload + 6 + 3 * i));
+            m.shipSymbols.push_back(char(payload[8 + 3 * i]));
+        }
+        return true;
+      }
+      case PLACED:
+      case GAME_OVER:
+      case ERROR:
+        if (length != 1)
+            return false;
+        m.value = payload[0];
+        return true;
+      case YOUR_TURN:
+        return length == 0;
+      case SHOT_RESULT:
+        if (length != 6)
+            return false;
+        m.p = Point(get16(payload), get16(payload + 2));
+        m.value = payload[4];
+        m.shipId = (payload[5] == 255 ? -1 : payload[5]);
+        return true;
+      case OPPONENT_SHOT:
+        if (length != 4)
+            return false;
+        m.p = Point(get16(payload), get16(payload + 2));
+        return true;
+      default:
+        return false;
+    }
+}
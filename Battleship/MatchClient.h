@@ -0,0 +1,63 @@
+#ifndef MATCHCLIENT_INCLUDED
+#define MATCHCLIENT_INCLUDED
+
+#include "Protocol.h"
+#include "FleetPlacer.h"
+#include "globals.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+  // A message from a MatchServer, decoded
+struct ServerMessage
+{
+    Protocol::MessageType type;
+    Point p;                        //SHOT_RESULT, OPPONENT_SHOT
+    int value;                      //GAME_START seat, PLACED ok, SHOT_RESULT
+                                    //  flags, GAME_OVER outcome, ERROR code
+    int shipId;                     //SHOT_RESULT, -1 for none
+    int rows;                       //GAME_START
+    int cols;                       //GAME_START
+    std::vector<int> shipLengths;   //GAME_START
+    std::vector<char> shipSymbols;  //GAME_START
+};
+
+  // One connection to a MatchServer.  Sending blocks until the message is
+  // on its way; receiving blocks or not, as asked.
+class MatchClient
+{
+  public:
+    MatchClient();
+    ~MatchClient();
+
+      // Connect to the server listening at path; false if that fails
+    bool connect(const std::string& path);
+    void disconnect();
+    bool connected() const { return m_fd >= 0; }
+    int fd() const { return m_fd; }
+
+    bool newGame(Protocol::Opponent opponent);
+    bool place(const std::vector<FleetPlacer::Placement>& fleet);
+    bool fire(Point p);
+
+      // Decode the next message into m.  If wait is false and no whole
+      // message has arrived, return false at once.  Returns false, and
+      // disconnects, if the connection is lost or the server sends
+      // something that isn't the Protocol.
+    bool receive(ServerMessage& m, bool wait = true);
+
+      // We prevent a MatchClient object from being copied or assigned
+    MatchClient(const MatchClient&) = delete;
+    MatchClient& operator=(const MatchClient&) = delete;
+
+  private:
+    int m_fd;
+    std::vector<uint8_t> m_out;     //the message being sent
+    std::vector<uint8_t> m_in;      //received, not yet decoded
+    size_t m_inPos;                 //where undecoded input starts in m_in
+
+    bool send();
+    bool decode(ServerMessage& m, const uint8_t* payload, int length);
+};
+
+#endif // MATCHCLIENT_INCLUDED
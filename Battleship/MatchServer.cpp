@@ -0,0 +1,832 @@
+#include "MatchServer.h"
+#include "Protocol.h"
+#include "RemotePlayer.h"
+#include "Game.h"
+#include "Board.h"
+#include "Player.h"
+#include "Match.h"
+#include "GameObserver.h"
+#include "Random.h"
+#include "TranspositionTable.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#include <unordered_map>
+#endif
+
+using namespace std;
+using namespace Protocol;
+
+  // The createPlayer type of each computer opponent
+static const char* const COMPUTERTYPES[NOPPONENTS] = {
+    nullptr, "awful", "mediocre", "good"
+};
+
+#ifdef MSG_NOSIGNAL
+static const int SENDFLAGS = MSG_NOSIGNAL;  //a client that hangs up is no reason to die
+#else
+static const int SENDFLAGS = 0;             //SO_NOSIGPIPE is set on each socket instead
+#endif
+
+//******************** Poller *****************************************
+
+  // What happened to one socket
+struct PollEvent
+{
+    void* tag;
+    bool readable;      //or hung up, or failed: reading will tell which
+    bool writable;
+};
+
+  // Watches sockets for input, and for room to write on the ones asked
+  // about.  Each socket is registered with a tag that comes back with its
+  // events.  On Linux this is epoll, so waiting costs nothing per idle
+  // socket; elsewhere it is poll, which is fine for a few thousand.
+class Poller
+{
+  public:
+    Poller();
+    ~Poller();
+    bool ok() const;
+    bool add(int fd, void* tag);
+    void watchWrites(int fd, void* tag, bool on);
+    void remove(int fd);
+      // Wait up to timeoutMs (forever if negative) and set events to what
+      // happened; false if waiting failed
+    bool wait(int timeoutMs, vector<PollEvent>& events);
+
+    Poller(const Poller&) = delete;
+    Poller& operator=(const Poller&) = delete;
+
+  private:
+#ifdef __linux__
+    int m_epoll;
+    vector<epoll_event> m_ready;
+#else
+    vector<pollfd> m_fds;
+    vector<void*> m_tags;                 //parallel to m_fds
+    unordered_map<int, size_t> m_index;   //where each socket is in m_fds
+#endif
+};
+
+#ifdef __linux__
+
+Poller::Poller()
+ : m_epoll(epoll_create1(EPOLL_CLOEXEC)), m_ready(256)
+{}
+
+Poller::~Poller()
+{
+    if (m_epoll >= 0)
+        close(m_epoll);
+}
+
+bool Poller::ok() const
+{
+    return m_epoll >= 0;
+}
+
+bool Poller::add(int fd, void* tag)
+{
+    epoll_event ev = epoll_event();
+    ev.events = EPOLLIN;
+    ev.data.ptr = tag;
+    return epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+void Poller::watchWrites(int fd, void* tag, bool on)
+{
+    epoll_event ev = epoll_event();
+    ev.events = (on ? EPOLLIN | EPOLLOUT : EPOLLIN);
+    ev.data.ptr = tag;
+    epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &ev);
+}
+
+void Poller::remove(int fd)
+{
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+bool Poller::wait(int timeoutMs, vector<PollEvent>& events)
+{
+    events.clear();
+    int n = epoll_wait(m_epoll, m_ready.data(), int(m_ready.size()), timeoutMs);
+    if (n < 0)
+        return errno == EINTR;
+    for (int i = 0; i < n; i++)
+    {
+        PollEvent e = { m_ready[i].data.ptr,
+                        (m_ready[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0,
+                        (m_ready[i].events & EPOLLOUT) != 0 };
+        events.push_back(e);
+    }
+    if (n == int(m_ready.size()))
+        m_ready.resize(2 * m_ready.size()); //busy; take more at a time
+    return true;
+}
+
+#else
+
+Poller::Poller()
+{}
+
+Poller::~Poller()
+{}
+
+bool Poller::ok() const
+{
+    return true;
+}
+
+bool Poller::add(int fd, void* tag)
+{
+    pollfd p = { fd, POLLIN, 0 };
+    m_index[fd] = m_fds.size();
+    m_fds.push_back(p);
+    m_tags.push_back(tag);
+    return true;
+}
+
+void Poller::watchWrites(int fd, void* /* tag */, bool on)
+{
+    m_fds[m_index[fd]].events = short(POLLIN | (on ? POLLOUT : 0));
+}
+
+void Poller::remove(int fd)
+{
+    unordered_map<int, size_t>::iterator it = m_index.find(fd);
+    if (it == m_index.end())
+        return;
+    size_t i = it->second;
+    m_index.erase(it);
+    if (i + 1 != m_fds.size()) //move the last one into the hole
+    {
+        m_fds[i] = m_fds.back();
+        m_tags[i] = m_tags.back();
+        m_index[m_fds[i].fd] = i;
+    }
+    m_fds.pop_back();
+    m_tags.pop_back();
+}
+
+bool Poller::wait(int timeoutMs, vector<PollEvent>& events)
+{
+    events.clear();
+    int n = ::poll(m_fds.data(), nfds_t(m_fds.size()), timeoutMs);
+    if (n < 0)
+        return errno == EINTR;
+    for (size_t i = 0; i < m_fds.size()  &&  n > 0; i++)
+    {
+        short r = m_fds[i].revents;
+        if (r == 0)
+            continue;
+        n--;
+        PollEvent e = { m_tags[i], (r & (POLLIN | POLLHUP | POLLERR | POLLNVAL)) != 0,
+                        (r & POLLOUT) != 0 };
+        events.push_back(e);
+    }
+    return true;
+}
+
+#endif
+
+//******************** Connection and Session *************************
+
+struct Session;
+
+  // A connected client
+struct Connection
+{
+    int fd;
+    vector<uint8_t> in;         //received, not yet a whole frame
+    vector<uint8_t> out;        //to be sent
+    size_t sent = 0;            //bytes at the front of out already sent
+    bool watchingWrites = false;
+    bool dirty = false;         //on the list of connections to flush
+    bool closing = false;
+    Session* session = nullptr;
+    int seat = 0;
+};
+
+  // One match, and the game, boards and players it is played with.  Once
+  // a match is over its session waits to be reused, all of that included,
+  // for a later match against the same kind of opponent.  A session is
+  // the observer of its own match, passing each shot on to the clients.
+struct Session : public GameObserver
+{
+    enum State { PLACING, PLAYING, OVER };
+
+    int opponent;
+    Game game;
+    unique_ptr<Board> boards[2];         //by seat
+    unique_ptr<RemotePlayer> remotes[2]; //the second only against a client
+    unique_ptr<Player> computer;         //only against a computer
+    Player* players[2];                  //by seat
+    RemotePlayer* remoteAt[2];           //by seat, nullptr for the computer
+    Connection* conns[2];                //by seat, nullptr for the computer
+    State state;
+    bool placed[2];
+    int turn;
+    bool prompted;                       //YOUR_TURN has been sent this turn
+    MatchResult result;
+
+    Session(int opp, int nRows, int nCols, bool (*addShips)(Game&),
+            const PlayerOptions& options)
+     : opponent(opp), game(nRows, nCols, 0), state(OVER)
+    {
+        addShips(game);
+        for (int i = 0; i < 2; i++)
+            boards[i].reset(new Board(game)); //only now that game has its fleet
+        remotes[0].reset(new RemotePlayer("remote", game));
+        if (opp == OPPONENT_REMOTE)
+            remotes[1].reset(new RemotePlayer("remote", game));
+        else
+            computer.reset(createPlayer(COMPUTERTYPES[opp], COMPUTERTYPES[opp], game, options));
+    }
+
+    void event(const GameEvent& e) override
+    {
+        switch (e.kind)
+        {
+          case GameEvent::WASTED_SHOT:
+              // takeShot tells the attacker only about valid shots, but a
+              // client needs an answer to every FIRE
+            if (remoteAt[e.player] != nullptr)
+                remoteAt[e.player]->recordAttackResult(e.p, false, false, false, -1);
+            // fall through
+          case GameEvent::MISS:
+          case GameEvent::HIT:
+          case GameEvent::SINK:
+            if (remoteAt[1-e.player] != nullptr)
+                remoteAt[1-e.player]->recordAttackByOpponent(e.p);
+            break;
+          default:
+            break;
+        }
+    }
+};
+
+//******************** MatchServerImpl ********************************
+
+class MatchServerImpl
+{
+  public:
+    MatchServerImpl(int nRows, int nCols, bool (*addShips)(Game&));
+    ~MatchServerImpl();
+    bool listen(const string& path);
+    bool poll(int timeoutMs);
+    void run();
+    void stop();
+    int connections() const { return m_nConnections; }
+    int activeMatches() const { return m_nActive; }
+    long long matchesPlayed() const { return m_nPlayed; }
+
+  private:
+    int m_rows;
+    int m_cols;
+    bool (*m_addShips)(Game&);
+    RandomEngine m_rng;                  //seeds each match
+    TranspositionTable m_table;          //shared by every computer player
+    PlayerOptions m_options;             //for making them
+    Poller m_poller;
+    int m_listener;
+    string m_path;
+    atomic<bool> m_stopping;
+    vector<PollEvent> m_events;
+    vector<Connection*> m_dirty;         //connections with output to flush
+    vector<Connection*> m_closed;        //to delete once the events are done
+    Connection* m_waiting;               //a client waiting for a remote opponent
+    vector<unique_ptr<Session> > m_sessions;
+    vector<Session*> m_free[NOPPONENTS]; //sessions not in use, by opponent
+    int m_nConnections;
+    int m_nActive;
+    long long m_nPlayed;
+
+    void acceptAll();
+    void readFrom(Connection& c);
+    void handle(Connection& c, int type, const uint8_t* payload, int length);
+    void flush(Connection& c);
+    void touch(Connection* c);
+    void closeConnection(Connection& c);
+
+    void startMatch(int opponent, Connection* first, Connection* second);
+    void advance(Session& s);
+    void finish(Session& s, int winner, const Connection* leaving);
+
+    void sendGameStart(Session& s, int seat);
+    void sendByte(Connection& c, MessageType type, int value);
+    void sendEmpty(Connection& c, MessageType type);
+};
+
+MatchServerImpl::MatchServerImpl(int nRows, int nCols, bool (*addShips)(Game&))
+ : m_rows(nRows), m_cols(nCols), m_addShips(addShips), m_rng(freshSeed()),
+   m_listener(-1), m_stopping(false), m_waiting(nullptr),
+   m_nConnections(0), m_nActive(0), m_nPlayed(0)
+{
+    m_options.table = &m_table;
+}
+
+MatchServerImpl::~MatchServerImpl()
+{
+      // Sessions may still point at connections, so close those first
+    vector<Connection*> all;
+    for (size_t i = 0; i < m_sessions.size(); i++)
+        for (int seat = 0; seat < 2; seat++)
+            if (m_sessions[i]->state != Session::OVER  &&  m_sessions[i]->conns[seat] != nullptr)
+                all.push_back(m_sessions[i]->conns[seat]);
+    if (m_waiting != nullptr)
+        all.push_back(m_waiting);
+    for (size_t i = 0; i < all.size(); i++)
+        closeConnection(*all[i]);
+    for (size_t i = 0; i < m_closed.size(); i++)
+        delete m_closed[i];
+    if (m_listener >= 0)
+    {
+        close(m_listener);
+        unlink(m_path.c_str());
+    }
+}
+
+bool MatchServerImpl::listen(const string& path)
+{
+    sockaddr_un addr = sockaddr_un();
+    if (path.size() >= sizeof(addr.sun_path))
+    {
+        cerr << "Socket path " << path << " is too long" << endl;
+        return false;
+    }
+    if (!m_poller.ok())
+    {
+        cerr << "Can't watch sockets: " << strerror(errno) << endl;
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+
+      // Every client is a socket, so allow as many as we may
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0  &&  limit.rlim_cur < limit.rlim_max)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        cerr << "Can't make a socket: " << strerror(errno) << endl;
+        return false;
+    }
+    unlink(path.c_str()); //left over from an earlier run
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0  ||
+        ::listen(fd, SOMAXCONN) != 0  ||
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0  ||
+        !m_poller.add(fd, nullptr))
+    {
+        cerr << "Can't listen at " << path << ": " << strerror(errno) << endl;
+        close(fd);
+        return false;
+    }
+    m_listener = fd;
+    m_path = path;
+    return true;
+}
+
+bool MatchServerImpl::poll(int timeoutMs)
+{
+    if (m_listener < 0  ||  !m_poller.wait(timeoutMs, m_events))
+        return false;
+    for (size_t i = 0; i < m_events.size(); i++)
+    {
+        const PollEvent& e = m_events[i];
+        if (e.tag == nullptr)
+        {
+            acceptAll();
+            continue;
+        }
+        Connection& c = *static_cast<Connection*>(e.tag);
+        if (c.closing)
+            continue; //closed earlier in this batch
+        if (e.writable)
+            flush(c);
+        if (e.readable  &&  !c.closing)
+            readFrom(c);
+    }
+    for (size_t i = 0; i < m_dirty.size(); i++) //may close some
+    {
+        m_dirty[i]->dirty = false;
+        if (!m_dirty[i]->closing)
+            flush(*m_dirty[i]);
+    }
+    m_dirty.clear();
+    for (size_t i = 0; i < m_closed.size(); i++)
+        delete m_closed[i];
+    m_closed.clear();
+    return true;
+}
+
+void MatchServerImpl::run()
+{
+    while (!m_stopping.load())
+        if (!poll(100)) //wake now and then to notice stop
+            break;
+}
+
+void MatchServerImpl::stop()
+{
+    m_stopping.store(true);
+}
+
+void MatchServerImpl::acceptAll()
+{
+    for (;;)
+    {
+        int fd = accept(m_listener, nullptr, nullptr);
+        if (fd < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return; //EAGAIN once there are no more, or out of descriptors
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+        Connection* c = new Connection;
+        c->fd = fd;
+        if (!m_poller.add(fd, c))
+        {
+            close(fd);
+            delete c;
+            continue;
+        }
+        m_nConnections++;
+    }
+}
+
+void MatchServerImpl::readFrom(Connection& c)
+{
+    uint8_t buffer[16384];
+    for (;;)
+    {
+        ssize_t n = read(c.fd, buffer, sizeof(buffer));
+        if (n > 0)
+        {
+            c.in.insert(c.in.end(), buffer, buffer + n);
+            if (size_t(n) < sizeof(buffer))
+                break;
+        }
+        else if (n < 0  &&  errno == EINTR)
+            continue;
+        else if (n < 0  &&  (errno == EAGAIN  ||  errno == EWOULDBLOCK))
+            break;
+        else
+        {
+            closeConnection(c); //hung up, or failed
+            return;
+        }
+    }
+
+    size_t pos = 0;
+    while (!c.closing  &&  c.in.size() - pos >= 2)
+    {
+        int length = get16(&c.in[pos]);
+        if (length < 1  ||  length + 2 > MAXFRAME)
+        {
+            closeConnection(c); //not speaking the protocol
+            return;
+        }
+        if (c.in.size() - pos < size_t(length) + 2)
+            break; //the rest hasn't arrived yet
+        handle(c, c.in[pos+2], &c.in[pos+3], length - 1);
+        pos += length + 2;
+    }
+    c.in.erase(c.in.begin(), c.in.begin() + pos);
+}
+
+void MatchServerImpl::handle(Connection& c, int type, const uint8_t* payload, int length)
+{
+    Session* s = c.session;
+    switch (type)
+    {
+      case NEW_GAME:
+        if (length != 1)
+            sendByte(c, ERROR, ERROR_UNKNOWN_MESSAGE);
+        else if (s != nullptr  ||  m_waiting == &c)
+            sendByte(c, ERROR, ERROR_NOT_NOW);
+        else if (payload[0] >= NOPPONENTS)
+            sendByte(c, ERROR, ERROR_BAD_OPPONENT);
+        else if (payload[0] != OPPONENT_REMOTE)
+            startMatch(payload[0], &c, nullptr);
+        else if (m_waiting == nullptr)
+            m_waiting = &c;
+        else
+        {
+            Connection* first = m_waiting;
+            m_waiting = nullptr;
+            startMatch(OPPONENT_REMOTE, first, &c);
+        }
+        break;
+      case PLACE:
+        if (s == nullptr  ||  s->state != Session::PLACING  ||  s->placed[c.seat])
+            sendByte(c, ERROR, ERROR_NOT_NOW);
+        else if (!s->remoteAt[c.seat]->setFleet(payload, length))
+            sendByte(c, ERROR, ERROR_UNKNOWN_MESSAGE);
+        else
+        {
+            Board& own = *s->boards[c.seat];
+            own.clear();
+            s->placed[c.seat] = placeFleet(s->players[c.seat], own, c.seat, *s);
+            if (!s->placed[c.seat])
+                own.clear(); //ready for another try
+            sendByte(c, PLACED, s->placed[c.seat] ? 1 : 0);
+            advance(*s);
+        }
+        break;
+      case FIRE:
+        if (length != 4)
+            sendByte(c, ERROR, ERROR_UNKNOWN_MESSAGE);
+        else if (s == nullptr  ||  s->state != Session::PLAYING  ||  s->turn != c.seat  ||
+                 s->remoteAt[c.seat]->hasMove())
+            sendByte(c, ERROR, ERROR_NOT_NOW);
+        else
+        {
+            s->remoteAt[c.seat]->setMove(Point(get16(payload), get16(payload + 2)));
+            advance(*s);
+        }
+        break;
+      default:
+        sendByte(c, ERROR, ERROR_UNKNOWN_MESSAGE);
+        break;
+    }
+}
+
+void MatchServerImpl::flush(Connection& c)
+{
+    while (c.sent < c.out.size())
+    {
+        ssize_t n = send(c.fd, c.out.data() + c.sent, c.out.size() - c.sent, SENDFLAGS);
+        if (n > 0)
+            c.sent += n;
+        else if (n < 0  &&  errno == EINTR)
+            continue;
+        else if (n < 0  &&  (errno == EAGAIN  ||  errno == EWOULDBLOCK))
+        {
+            if (!c.watchingWrites) //finish when the client has read some
+            {
+                m_poller.watchWrites(c.fd, &c, true);
+                c.watchingWrites = true;
+            }
+            return;
+        }
+        else
+        {
+            closeConnection(c);
+            return;
+        }
+    }
+    c.out.clear();
+    c.sent = 0;
+    if (c.watchingWrites)
+    {
+        m_poller.watchWrites(c.fd, &c, false);
+        c.watchingWrites = false;
+    }
+}
+
+  // Note that c may have output to flush before the next wait
+void MatchServerImpl::touch(Connection* c)
+{
+    if (c != nullptr  &&  !c->dirty  &&  !c->closing)
+    {
+        c->dirty = true;
+        m_dirty.push_back(c);
+    }
+}
+
+void MatchServerImpl::closeConnection(Connection& c)
+{
+    if (c.closing)
+        return;
+    c.closing = true;
+    if (m_waiting == &c)
+        m_waiting = nullptr;
+    if (c.session != nullptr)
+        finish(*c.session, -1, &c);
+    m_poller.remove(c.fd);
+    close(c.fd);
+    m_nConnections--;
+    m_closed.push_back(&c);
+}
+
+  // Start a match for one client against a computer, or for two clients
+void MatchServerImpl::startMatch(int opponent, Connection* first, Connection* second)
+{
+    Session* s;
+    if (m_free[opponent].empty())
+    {
+        m_sessions.push_back(unique_ptr<Session>(new Session(opponent, m_rows, m_cols, m_addShips, m_options)));
+        s = m_sessions.back().get();
+    }
+    else
+    {
+        s = m_free[opponent].back();
+        m_free[opponent].pop_back();
+    }
+
+    s->game.reseed(m_rng.next());
+    s->remotes[0]->reset();
+    if (s->remotes[1] != nullptr)
+        s->remotes[1]->reset();
+    if (s->computer != nullptr)
+        s->computer->reset();
+      // Against a computer, the client moves first in half the matches
+    int clientSeat = (second != nullptr ? 0 : s->game.rng().nextInt(2));
+    Connection* conns[2] = { first, second };
+    for (int i = 0; i < 2; i++)
+    {
+        int seat = (i == 0 ? clientSeat : 1 - clientSeat);
+        if (conns[i] != nullptr)
+        {
+            s->players[seat] = s->remoteAt[seat] = s->remotes[i].get();
+            s->remoteAt[seat]->attach(&conns[i]->out);
+            conns[i]->session = s;
+            conns[i]->seat = seat;
+        }
+        else
+        {
+            s->players[seat] = s->computer.get();
+            s->remoteAt[seat] = nullptr;
+        }
+        s->conns[seat] = conns[i];
+        s->boards[seat]->clear();
+        s->placed[seat] = false;
+    }
+    s->state = Session::PLACING;
+    s->turn = 0;
+    s->prompted = false;
+    MatchResult none = { nullptr, 0, { 0, 0 }, { 0, 0 }, { 0, 0 } };
+    s->result = none;
+    m_nActive++;
+
+    for (int seat = 0; seat < 2; seat++)
+    {
+        if (s->conns[seat] != nullptr)
+            sendGameStart(*s, seat);
+        else
+            s->placed[seat] = placeFleet(s->players[seat], *s->boards[seat], seat, *s);
+    }
+    if (s->computer != nullptr  &&  !s->placed[1 - clientSeat])
+        finish(*s, -1, nullptr); //the fleet doesn't fit, so nobody can play
+}
+
+  // Play as much of the match as can be played without waiting for a client
+void MatchServerImpl::advance(Session& s)
+{
+    if (s.state == Session::PLACING)
+    {
+        if (!s.placed[0]  ||  !s.placed[1])
+            return;
+        s.state = Session::PLAYING;
+    }
+    while (s.state == Session::PLAYING)
+    {
+        int who = s.turn;
+        if (s.remoteAt[who] != nullptr  &&  !s.remoteAt[who]->hasMove())
+        {
+            if (!s.prompted)
+            {
+                sendEmpty(*s.conns[who], YOUR_TURN);
+                s.prompted = true;
+            }
+            return;
+        }
+        if (who == 0)
+            s.result.turns++;
+        bool won = takeShot(s.players[who], *s.boards[1-who], who, s, s.result);
+        touch(s.conns[0]); //for the results the players wrote
+        touch(s.conns[1]);
+        if (won)
+        {
+            finish(s, who, nullptr);
+            return;
+        }
+        s.turn = 1 - who;
+        s.prompted = false;
+    }
+}
+
+  // End the match, won by seat winner or, if that's -1, abandoned by the
+  // client leaving (or because it couldn't be played), and put the
+  // session up for reuse
+void MatchServerImpl::finish(Session& s, int winner, const Connection* leaving)
+{
+    for (int seat = 0; seat < 2; seat++)
+    {
+        Connection* c = s.conns[seat];
+        if (c == nullptr)
+            continue;
+        if (c != leaving)
+            sendByte(*c, GAME_OVER, winner < 0 ? OUTCOME_ABANDONED :
+                                    winner == seat ? OUTCOME_WON : OUTCOME_LOST);
+        c->session = nullptr;
+        s.remoteAt[seat]->attach(nullptr);
+        s.conns[seat] = nullptr;
+    }
+    s.state = Session::OVER;
+    m_free[s.opponent].push_back(&s);
+    m_nActive--;
+    m_nPlayed++;
+}
+
+void MatchServerImpl::sendGameStart(Session& s, int seat)
+{
+    Connection& c = *s.conns[seat];
+    size_t start = beginFrame(c.out, GAME_START);
+    put16(c.out, s.game.rows());
+    put16(c.out, s.game.cols());
+    c.out.push_back(uint8_t(seat));
+    c.out.push_back(uint8_t(s.game.nShips()));
+    for (int i = 0; i < s.game.nShips(); i++)
+    {
+        put16(c.out, s.game.shipLength(i));
+        c.out.push_back(uint8_t(s.game.shipSymbol(i)));
+    }
+    endFrame(c.out, start);
+    touch(&c);
+}
+
+void MatchServerImpl::sendByte(Connection& c, MessageType type, int value)
+{
+    size_t start = beginFrame(c.out, type);
+    c.out.push_back(uint8_t(value));
+    endFrame(c.out, start);
+    touch(&c);
+}
+
+void MatchServerImpl::sendEmpty(Connection& c, MessageType type)
+{
+    size_t start = beginFrame(c.out, type);
+    endFrame(c.out, start);
+    touch(&c);
+}
+
+//******************** MatchServer functions **************************
+
+MatchServer::MatchServer(int nRows, int nCols, bool (*addShips)(Game&))
+ : m_impl(new MatchServerImpl(nRows, nCols, addShips))
+{}
+
+MatchServer::~MatchServer()
+{
+    delete m_impl;
+}
+
+bool MatchServer::listen(const string& path)
+{
+    return m_impl->listen(path);
+}
+
+bool MatchServer::poll(int timeoutMs)
+{
+    return m_impl->poll(timeoutMs);
+}
+
+void MatchServer::run()
+{
+    m_impl->run();
+}
+
+void MatchServer::stop()
+{
+    m_impl->stop();
+}
+
+int MatchServer::connections() const
+{
+    return m_impl->connections();
+}
+
+int MatchServer::activeMatches() const
+{
+    return m_impl->activeMatches();
+}
+
+long long MatchServer::matchesPlayed() const
+{
+    return m_impl->matchesPlayed();
+}
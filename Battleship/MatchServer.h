@@ -0,0 +1,51 @@
+#ifndef MATCHSERVER_INCLUDED
+#define MATCHSERVER_INCLUDED
+
+#include <string>
+
+class Game;
+class MatchServerImpl;
+
+  // Hosts matches for clients connecting over a Unix domain socket and
+  // speaking the Protocol.  Each client plays one game at a time, against
+  // a computer player or another client, as a RemotePlayer.  Everything
+  // runs on one thread around one event loop (epoll on Linux, poll
+  // elsewhere), so a match costs no thread: just its Game, two Boards and
+  // the players, which are recycled for later matches once it is over.
+  // The computer players all cache what they work out in one table.
+  // All matches use an nRows x nCols board with the fleet set up by
+  // addShips.
+class MatchServer
+{
+  public:
+    MatchServer(int nRows, int nCols, bool (*addShips)(Game&));
+    ~MatchServer();
+
+      // Listen at path, replacing any socket already there; false, with a
+      // message on cerr, if that can't be done
+    bool listen(const std::string& path);
+
+      // Wait up to timeoutMs (or forever if negative) for something to
+      // happen, and deal with all of it; false if the server isn't
+      // listening or the wait failed
+    bool poll(int timeoutMs);
+
+      // Serve until stop is called
+    void run();
+
+      // Make run return soon; may be called from any thread
+    void stop();
+
+    int connections() const;
+    int activeMatches() const;
+    long long matchesPlayed() const;     //finished, abandoned ones included
+
+      // We prevent a MatchServer object from being copied or assigned
+    MatchServer(const MatchServer&) = delete;
+    MatchServer& operator=(const MatchServer&) = delete;
+
+  private:
+    MatchServerImpl* m_impl;
+};
+
+#endif // MATCHSERVER_INCLUDED
@@ -0,0 +1,83 @@
+#include "MoveClock.h"
+#include <algorithm>
+
+using namespace std;
+
+MoveClock::MoveClock(int limitMs, int movesPerPlayer)
+ : m_limit(chrono::milliseconds(limitMs > 0 ? limitMs : 0)),
+   m_armed(Player::Deadline::max()), m_stopping(false)
+{
+    for (int who = 0; who < 2; who++)
+    {
+        m_ns[who].reserve(max(movesPerPlayer, 0));
+        m_overruns[who] = 0;
+    }
+}
+
+MoveClock::~MoveClock()
+{
+    if (m_watchdog.joinable())
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_one();
+        m_watchdog.join();
+    }
+}
+
+  // Have the watchdog call off the move being chosen at deadline, or, if
+  // that is max, not at all.  Only the match's thread calls this, so only
+  // it starts the watchdog.
+void MoveClock::arm(Player::Deadline deadline)
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_armed = deadline;
+    }
+    if (!m_watchdog.joinable())
+    {
+        if (deadline != Player::Deadline::max())
+            m_watchdog = thread(&MoveClock::watch, this);
+        return;
+    }
+    m_wake.notify_one();
+}
+
+void MoveClock::watch()
+{
+    unique_lock<mutex> lock(m_mutex);
+    while (!m_stopping)
+    {
+        if (m_armed == Player::Deadline::max())
+            m_wake.wait(lock);
+        else if (chrono::steady_clock::now() < m_armed)
+            m_wake.wait_until(lock, m_armed);
+        else
+        {
+            m_cancel.cancel(); //the move is still being chosen at its deadline
+            m_armed = Player::Deadline::max();
+        }
+    }
+}
+
+  // The move at fraction q of the way through the sorted latencies, in ms
+static double percentile(const vector<long long>& sorted, double q)
+{
+    size_t i = size_t(q * (sorted.size() - 1) + 0.5);
+    return sorted[i] / 1e6;
+}
+
+MoveLatency MoveClock::latency(int who) const
+{
+    MoveLatency l = { int(m_ns[who].size()), 0, 0, 0, m_overruns[who] };
+    if (m_ns[who].empty())
+        return l;
+    vector<long long> sorted(m_ns[who]);
+    sort(sorted.begin(), sorted.end());
+    l.p50Ms = percentile(sorted, 0.50);
+    l.p99Ms = percentile(sorted, 0.99);
+    l.maxMs = sorted.back() / 1e6;
+    return l;
+}
@@ -0,0 +1,107 @@
+#ifndef MOVECLOCK_INCLUDED
+#define MOVECLOCK_INCLUDED
+
+#include "Game.h"
+#include "Player.h"
+#include "globals.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+  // How the match loop asks a player for its target.  UntimedMoves just
+  // calls recommendAttack, so a batch run pays nothing for it.
+
+struct UntimedMoves
+{
+    void startTurn() {}
+    template <class P>
+    bool recommend(P* player, int /* who */, Point& p)
+    {
+        p = player->recommendAttack();
+        return true;
+    }
+};
+
+  // MoveClock gives each computer player a deadline a fixed time after its
+  // turn starts, through Player::recommendAttackBy, lets anyone call the
+  // move being chosen off, and records how long every move took, so the
+  // latencies of each player can be read off after the match.  For a
+  // player that watches its CancelToken (see Player::isCancellable), a
+  // watchdog thread calls the move off at its deadline, so it stops then
+  // even if it ignores the deadline; the thread is started for the first
+  // such move, so a match between players that don't costs no thread.  A
+  // move that still ends after its deadline is an overrun, and is
+  // forfeited: the match loop spends the turn on a shot off the board
+  // instead.  Humans take as long as they like.
+
+class MoveClock
+{
+  public:
+      // limitMs <= 0 means no deadline.  Room for movesPerPlayer latencies
+      // of each player is made up front, so a match of no more moves than
+      // that records them without allocating.
+    MoveClock(int limitMs, int movesPerPlayer);
+    ~MoveClock();
+
+      // A turn is starting.  A move called off before this is forgotten;
+      // one called off from now on stays called off until the next turn.
+    void startTurn() { m_cancel.clear(); }
+
+      // Set p to the target player who chooses; false if the move came
+      // after its deadline, and so is forfeited
+    template <class P>
+    bool recommend(P* player, int who, Point& p);
+
+      // Call off the move being chosen now, from any thread
+    void cancelMove() { m_cancel.cancel(); }
+
+      // The latencies of player who (0 for the one who moved first)
+    MoveLatency latency(int who) const;
+
+      // We prevent a MoveClock object from being copied or assigned
+    MoveClock(const MoveClock&) = delete;
+    MoveClock& operator=(const MoveClock&) = delete;
+
+  private:
+    std::chrono::nanoseconds m_limit;
+    CancelToken m_cancel;
+    std::vector<long long> m_ns[2];     //of each move, by player
+    int m_overruns[2];
+      // The watchdog, started by the first arm with a deadline
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    Player::Deadline m_armed;           //of the move being chosen, or max
+    bool m_stopping;
+    std::thread m_watchdog;
+
+    void arm(Player::Deadline deadline);
+    void watch();
+};
+
+template <class P>
+bool MoveClock::recommend(P* player, int who, Point& p)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Player::Deadline deadline = Player::Deadline::max();
+    bool watched = false;
+    if (m_limit.count() > 0  &&  !player->isHuman())
+    {
+        deadline = start + m_limit;
+        watched = player->isCancellable();
+        if (watched)
+            arm(deadline);
+    }
+    p = player->recommendAttackBy(deadline, m_cancel);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    if (watched)
+        arm(Player::Deadline::max());
+    m_ns[who].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    if (end <= deadline)
+        return true;
+    m_overruns[who]++;
+    return false;
+}
+
+#endif // MOVECLOCK_INCLUDED
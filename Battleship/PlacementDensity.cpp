@@ -0,0 +1,220 @@
+#include "PlacementDensity.h"
+#include <algorithm>
+
+using namespace std;
+
+void PlacementDensity::reset(int nRows, int nCols, const vector<int>& shipLengths)
+{
+    m_rows = nRows;
+    m_cols = nCols;
+    m_blocked.resize(nRows, nCols);
+    m_fired.resize(nRows, nCols);
+    m_total.assign(nRows * nCols, 0);
+    m_rowBest.assign(nRows, 0);
+    m_rowTies.assign(nRows, 0);
+    m_rowDirty.assign(nRows, true);
+
+      // Ships of the same length share one set of counts.  The classes of
+      // the last reset are reused, so that resetting for the same fleet
+      // allocates nothing.
+    size_t nClasses = 0;
+    for (size_t i = 0; i < shipLengths.size(); i++)
+    {
+        size_t k = 0;
+        while (k < nClasses  &&  m_classes[k].length != shipLengths[i])
+            k++;
+        if (k == nClasses)
+        {
+            if (nClasses == m_classes.size())
+                m_classes.push_back(LengthClass());
+            m_classes[k].length = shipLengths[i];
+            m_classes[k].nShips = 0;
+            nClasses++;
+        }
+        m_classes[k].nShips++;
+    }
+    m_classes.resize(nClasses);
+
+      // On an empty board, the placements covering (r,c) horizontally start
+      // anywhere from column c-length+1 to c that keeps the ship on the board
+    for (size_t k = 0; k < m_classes.size(); k++)
+    {
+        LengthClass& lc = m_classes[k];
+        int len = lc.length;
+        lc.count.assign(nRows * nCols, 0);
+        for (int r = 0; r < nRows; r++)
+        {
+            int vertical = min(r, nRows - len) - max(0, r - len + 1) + 1;
+            for (int c = 0; c < nCols; c++)
+            {
+                int horizontal = min(c, nCols - len) - max(0, c - len + 1) + 1;
+                int n = max(horizontal, 0) + max(vertical, 0);
+                lc.count[r * nCols + c] = n;
+                m_total[r * nCols + c] += lc.nShips * n;
+            }
+        }
+    }
+}
+
+void PlacementDensity::block(int r, int c)
+{
+    if (m_blocked.test(r, c))
+        return;
+    for (size_t k = 0; k < m_classes.size(); k++)
+    {
+        LengthClass& lc = m_classes[k];
+        if (lc.nShips == 0)
+            continue;
+        int len = lc.length;
+
+        int first = max(c - len + 1, 0);
+        int last = min(c, m_cols - len);
+        for (int s = first; s <= last; s++)
+        {
+            if (!horizontalFits(r, s, len))
+                continue; //already dropped
+            for (int j = 0; j < len; j++)
+            {
+                lc.count[r * m_cols + s + j]--;
+                m_total[r * m_cols + s + j] -= lc.nShips;
+            }
+        }
+        if (first <= last)
+            m_rowDirty[r] = true;
+
+        first = max(r - len + 1, 0);
+        last = min(r, m_rows - len);
+        for (int s = first; s <= last; s++)
+        {
+            if (!verticalFits(s, c, len))
+                continue; //already dropped
+            for (int j = 0; j < len; j++)
+            {
+                lc.count[(s + j) * m_cols + c]--;
+                m_total[(s + j) * m_cols + c] -= lc.nShips;
+                m_rowDirty[s + j] = true;
+            }
+        }
+    }
+    m_blocked.set(r, c);
+}
+
+void PlacementDensity::markFired(int r, int c)
+{
+    m_fired.set(r, c);
+    m_rowDirty[r] = true;
+}
+
+void PlacementDensity::unmarkFired(int r, int c)
+{
+    m_fired.reset(r, c);
+    m_rowDirty[r] = true;
+}
+
+void PlacementDensity::removeShip(int length)
+{
+    for (size_t k = 0; k < m_classes.size(); k++)
+    {
+        LengthClass& lc = m_classes[k];
+        if (lc.length != length  ||  lc.nShips == 0)
+            continue;
+          // Happens once per ship, so touching every cell here is fine
+        for (size_t i = 0; i < m_total.size(); i++)
+            m_total[i] -= lc.count[i];
+        lc.nShips--;
+        for (int r = 0; r < m_rows; r++)
+            m_rowDirty[r] = true;
+        return;
+    }
+}
+
+void PlacementDensity::rescanRow(int r)
+{
+    int best = -1;
+    int ties = 0;
+    for (int c = 0; c < m_cols; c++)
+    {
+        if (m_fired.test(r, c))
+            continue;
+        int n = m_total[r * m_cols + c];
+        if (n > best)
+        {
+            best = n;
+            ties = 1;
+        }
+        else if (n == best)
+            ties++;
+    }
+    m_rowBest[r] = best;
+    m_rowTies[r] = ties;
+    m_rowDirty[r] = false;
+}
+
+bool PlacementDensity::best(RandomEngine& rng, Point& p)
+{
+    int best = -1;
+    int ties = 0;
+    for (int r = 0; r < m_rows; r++)
+    {
+        if (m_rowDirty[r])
+            rescanRow(r);
+        if (m_rowBest[r] > best)
+        {
+            best = m_rowBest[r];
+            ties = m_rowTies[r];
+        }
+        else if (m_rowBest[r] == best)
+            ties += m_rowTies[r];
+    }
+    if (best < 0)
+        return false; //every cell has been fired at
+
+      // Find the pick-th of the tied cells
+    int pick = rng.nextInt(ties);
+    for (int r = 0; r < m_rows; r++)
+    {
+        if (m_rowBest[r] != best)
+            continue;
+        if (pick >= m_rowTies[r])
+        {
+            pick -= m_rowTies[r];
+            continue;
+        }
+        for (int c = 0; c < m_cols; c++)
+        {
+            if (!m_fired.test(r, c)  &&  m_total[r * m_cols + c] == best  &&
+                pick-- == 0)
+            {
+                p = Point(r, c);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool PlacementDensity::bestCells(vector<int>& cells)
+{
+    int best = -1;
+    for (int r = 0; r < m_rows; r++)
+    {
+        if (m_rowDirty[r])
+            rescanRow(r);
+        if (m_rowBest[r] > best)
+            best = m_rowBest[r];
+    }
+    if (best < 0)
+        return false; //every cell has been fired at
+
+    for (int r = 0; r < m_rows; r++)
+    {
+        if (m_rowBest[r] != best)
+            continue;
+        for (int c = 0; c < m_cols; c++)
+        {
+            if (!m_fired.test(r, c)  &&  m_total[r * m_cols + c] == best)
+                cells.push_back(r * m_cols + c);
+        }
+    }
+    return true;
+}
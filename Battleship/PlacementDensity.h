@@ -0,0 +1,106 @@
+#ifndef PLACEMENTDENSITY_INCLUDED
+#define PLACEMENTDENSITY_INCLUDED
+
+#include "globals.h"
+#include "BitGrid.h"
+#include <vector>
+
+  // For every cell of the opponent's board, the number of placements of the
+  // ships not yet sunk that cover the cell and avoid every cell known to be
+  // empty of them.  The counts are kept up to date as cells are ruled out
+  // and ships are sunk, touching only the placements affected, so the cost
+  // of a move doesn't grow as the game goes on.
+class PlacementDensity
+{
+  public:
+    PlacementDensity() : m_rows(0), m_cols(0) {}
+
+      // Start over with every placement of every listed ship possible
+    void reset(int nRows, int nCols, const std::vector<int>& shipLengths);
+
+      // The cell holds none of the unsunk ships (a miss or part of a sunk
+      // ship): drop every placement that covered it
+    void block(int r, int c);
+      // The cell has been fired at, so it is no longer a candidate target
+    void markFired(int r, int c);
+      // The shot at the cell never landed, so it is a candidate again
+    void unmarkFired(int r, int c);
+      // One ship of this length has been sunk: drop all of its placements
+    void removeShip(int length);
+
+    bool isBlocked(int r, int c) const { return m_blocked.test(r, c); }
+    bool isFired(int r, int c) const { return m_fired.test(r, c); }
+    int count(int r, int c) const { return m_total[r * m_cols + c]; }
+
+      // Choose, at random among ties, an unfired cell with the highest
+      // count.  Returns false if every cell has been fired at.
+    bool best(RandomEngine& rng, Point& p);
+      // Append to cells every cell best chooses among, as r * cols + c in
+      // increasing order, so that cells[rng.nextInt(n)] is what best would
+      // have picked.  Returns false if every cell has been fired at.
+    bool bestCells(std::vector<int>& cells);
+
+      // Call f(topOrLeft, dir, length, nShips) for every possible placement
+      // covering (r,c), where nShips is how many unsunk ships have that
+      // length
+    template <typename F>
+    void forEachPlacementThrough(int r, int c, F f) const;
+
+  private:
+    struct LengthClass
+    {
+        int length;
+        int nShips;                  //unsunk ships of this length
+        std::vector<int> count;      //placements of one such ship per cell
+    };
+
+    int m_rows;
+    int m_cols;
+    std::vector<LengthClass> m_classes;
+    std::vector<int> m_total;        //sum over classes of nShips * count
+    BitGrid m_blocked;
+    BitGrid m_fired;
+
+      // Best unfired count in each row and how many cells share it; a row
+      // is rescanned only after something in it changes
+    std::vector<int> m_rowBest;
+    std::vector<int> m_rowTies;
+    std::vector<bool> m_rowDirty;
+
+    bool horizontalFits(int r, int c, int length) const
+    {
+        return !m_blocked.anyInRun(r, c, length);
+    }
+    bool verticalFits(int r, int c, int length) const
+    {
+        for (int i = 0; i < length; i++)
+            if (m_blocked.test(r+i, c))
+                return false;
+        return true;
+    }
+    void rescanRow(int r);
+};
+
+template <typename F>
+void PlacementDensity::forEachPlacementThrough(int r, int c, F f) const
+{
+    for (std::size_t k = 0; k < m_classes.size(); k++)
+    {
+        const LengthClass& lc = m_classes[k];
+        if (lc.nShips == 0)
+            continue;
+        int len = lc.length;
+        int first = (c - len + 1 > 0 ? c - len + 1 : 0);
+        int last = (c < m_cols - len ? c : m_cols - len);
+        for (int s = first; s <= last; s++)
+            if (horizontalFits(r, s, len))
+                f(Point(r, s), HORIZONTAL, len, lc.nShips);
+        first = (r - len + 1 > 0 ? r - len + 1 : 0);
+        last = (r < m_rows - len ? r : m_rows - len);
+        for (int s = first; s <= last; s++)
+            if (verticalFits(s, c, len))
+                f(Point(s, c), VERTICAL, len, lc.nShips);
+    }
+}
+
+#endif // PLACEMENTDENSITY_INCLUDED
@@ -1,31 +1,38 @@
 #include "Player.h"
+#include "Players.h"
 #include "Board.h"
 #include "Game.h"
 #include "globals.h"
+#include "BitGrid.h"
+#include "Knowledge.h"
+#include "PlacementDensity.h"
+#include "FleetSampler.h"
+#include "FleetPlacer.h"
+#include "WorkStealingPool.h"
 #include <iostream>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 
 using namespace std;
 
 //*********************************************************************
-//  AwfulPlayer
+//  Player
 //*********************************************************************
 
-class AwfulPlayer : public Player
+Point Player::recommendAttackBy(Deadline /* deadline */, const CancelToken& /* cancel */)
 {
-  public:
-    AwfulPlayer(string nm, const Game& g);
-    virtual bool placeShips(Board& b);
-    virtual Point recommendAttack();
-    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
-                                                bool shipDestroyed, int shipId);
-    virtual void recordAttackByOpponent(Point p);
-  private:
-    Point m_lastCellAttacked;
-};
+    return recommendAttack();
+}
+
+//*********************************************************************
+//  AwfulPlayer
+//*********************************************************************
 
 AwfulPlayer::AwfulPlayer(string nm, const Game& g)
- : Player(nm, g), m_lastCellAttacked(0, 0)
+ : Player(nm, g), m_lastCellAttacked(0, 0), m_rows(g.rows()), m_cols(g.cols())
 {}
 
 bool AwfulPlayer::placeShips(Board& b)
@@ -37,33 +44,6 @@ bool AwfulPlayer::placeShips(Board& b)
     return true;
 }
 
-Point AwfulPlayer::recommendAttack()
-{
-    if (m_lastCellAttacked.c > 0)
-        m_lastCellAttacked.c--;
-    else
-    {
-        m_lastCellAttacked.c = game().cols() - 1;
-        if (m_lastCellAttacked.r > 0)
-            m_lastCellAttacked.r--;
-        else
-            m_lastCellAttacked.r = game().rows() - 1;
-    }
-    return m_lastCellAttacked;
-}
-
-void AwfulPlayer::recordAttackResult(Point /* p */, bool /* validShot */,
-                                     bool /* shotHit */, bool /* shipDestroyed */,
-                                     int /* shipId */)
-{
-      // AwfulPlayer completely ignores the result of any attack
-}
-
-void AwfulPlayer::recordAttackByOpponent(Point /* p */)
-{
-      // AwfulPlayer completely ignores what the opponent does
-}
-
 //*********************************************************************
 //  HumanPlayer
 //*********************************************************************
@@ -81,17 +61,6 @@ bool getLineWithTwoIntegers(int& r, int& c)
     return result;
 }
 
-class HumanPlayer : public Player {
-public:
-    HumanPlayer(string nm, const Game &g);
-    virtual bool isHuman() const;
-    virtual bool placeShips(Board &b);
-    virtual Point recommendAttack();
-    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
-                                    bool shipDestroyed, int shipId);
-    virtual void recordAttackByOpponent(Point p);
-};
-
 HumanPlayer::HumanPlayer(string nm, const Game &g)
 :Player(nm, g)
 {
@@ -195,117 +164,31 @@ void HumanPlayer::recordAttackByOpponent(Point p)
     //does nothing for a human player
 }
 
+void HumanPlayer::reset()
+{
+    //a human remembers what they like
+}
+
 //*********************************************************************
 //  MediocrePlayer
 //*********************************************************************
 
-// Remember that Mediocre::placeShips(Board& b) must start by calling
-// b.block(), and must call b.unblock() just before returning.
-
-class MediocrePlayer: public Player
-{
-public:
-    MediocrePlayer(string nm, const Game &g);
-    virtual bool placeShips(Board &b);
-    virtual Point recommendAttack();
-    virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
-    virtual void recordAttackByOpponent(Point p);
-    bool placeRecursive(Board &b, int shipId, Point p1);
-    
-    int m_state; //mediocre is initially in state 1
-    char m_local [MAXROWS][MAXCOLS];
-    Point previous;
-};
-
 MediocrePlayer::MediocrePlayer(string nm, const Game &g)
-:Player(nm, g)
+:Player(nm, g), m_placer(g)
 {
-    m_state = 1;
-    //constructor using initialization list
-    for(int i = 0; i < g.rows(); i++)
-    {
-        for (int j = 0; j < g.cols(); j++)
-        {
-            m_local[i][j] = 'o'; //set local board to empty
-        }
-    }
+    reset();
 }
 
-bool MediocrePlayer::placeShips(Board &b)
+void MediocrePlayer::reset()
 {
-    bool placed = false;
-    for (int i = 0; i < 50; i++)
-    {
-        b.block(); //block half of the positions on the board
-        int startShip = 0;
-        Point start(0,0);
-        placed = placeRecursive(b, startShip, start); //start in upper left corner with first ship and move from there
-        if (placed)
-        {
-            b.unblock(); //if successfully placed, unblock board and return true immediately
-            return true;
-        }
-        b.unblock();
-    }
-    return false; //if it got to this point then it could not place the ships
+    m_state = 1;
+    m_fired.resize(game().rows(), game().cols()); //nothing has been fired at yet
+    previous = Point();
 }
 
-bool MediocrePlayer::placeRecursive(Board &b, int shipId, Point p1)
+bool MediocrePlayer::placeShips(Board &b)
 {
-
-    if (shipId >= game().nShips())
-    {
-        return true; //we went through all the ships
-    }
-    if (!(game().isValid(p1)))
-    {
-        return false;    //point is outside of range so go back
-    }
-    if (b.placeShip(p1, shipId, HORIZONTAL))
-    {
-        if(placeRecursive(b, shipId+1, p1))
-        {
-            return true; //was able to place ship properly so place the next ship
-        }
-        else {
-            b.unplaceShip(p1, shipId, HORIZONTAL); //ship could not be placed later so remove them
-        }
-    }
-    if (b.placeShip(p1, shipId, VERTICAL)) //if horizontal doesnt work try vertical
-    {
-        if(placeRecursive(b, shipId+1, p1))
-        {
-            return true; //was able to place ship properly so place the next ship
-        }
-        else {
-            b.unplaceShip(p1, shipId, VERTICAL); //ship could not be placed later so remove them
-        }
-    }
-    //move one point at a time if point is taken
-    if(p1.r == game().rows()-1)
-    {
-        Point p2(0, p1.c+1); //if can move down move down
-        if(placeRecursive(b, shipId, p2))
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-    }
-    else {
-        Point p2(p1.r+1, p1.c); //otherwise move to the right
-        if(placeRecursive(b, shipId, p2))
-        {
-            return true;
-        }
-        else
-        {
-            return false;
-        }
-    }
-     
+    return m_placer.place(b, game().rng()); //any layout at all, each equally likely
 }
 
 Point MediocrePlayer::recommendAttack()
@@ -317,13 +200,13 @@ Point MediocrePlayer::recommendAttack()
         {
             Point temp = game().randomPoint();
             validShot = game().isValid(temp); //keep getting a random point if it is not valid
-            if (m_local[temp.r][temp.c] == 'X')
+            if (m_fired.test(temp.r, temp.c))
             {
                 validShot = false; //if already fired there pick again
             }
             else
             {
-                m_local[temp.r][temp.c] = 'X';
+                m_fired.set(temp.r, temp.c);
                 return temp;
             }
         }
@@ -337,10 +220,10 @@ Point MediocrePlayer::recommendAttack()
         while (invalid)//handle row 4 to -4
         {
             Point temp = Point(previous.r+x, previous.c);
-            if ((m_local[temp.r][temp.c] == 'o') && (game().isValid(temp)))
+            if (game().isValid(temp) && !m_fired.test(temp.r, temp.c))
             {
                 invalid = false;
-                m_local[temp.r][temp.c] = 'X'; //mark as used now
+                m_fired.set(temp.r, temp.c); //mark as used now
                 return temp;
             }
             else if (x >= -4)
@@ -356,10 +239,10 @@ Point MediocrePlayer::recommendAttack()
         while (invalidCol)
         {
             Point temp = Point(previous.r, previous.c+y);
-            if ((m_local[temp.r][temp.c] == 'o') && (game().isValid(temp)))
+            if (game().isValid(temp) && !m_fired.test(temp.r, temp.c))
             {
                 invalidCol = false;
-                m_local[temp.r][temp.c] = 'X';
+                m_fired.set(temp.r, temp.c);
                 return temp;
             }
             else if (y >= -4)
@@ -379,6 +262,14 @@ Point MediocrePlayer::recommendAttack()
 
 void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
 {
+    if (!validShot)
+    {
+        if (game().isValid(p))
+        {
+            m_fired.reset(p.r, p.c); //it never landed, so it may be chosen again
+        }
+        return;
+    }
     if (m_state == 1)
     {
         if (shotHit)
@@ -406,51 +297,513 @@ void MediocrePlayer::recordAttackByOpponent(Point p)
 //  GoodPlayer
 //*********************************************************************
 
-// TODO:  You need to replace this with a real class declaration and
-//        implementation.
-typedef MediocrePlayer GoodPlayer;
+  // A table entry holds up to MAXCACHEDTIES cells of 15 bits each above a
+  // 4-bit count
+static const size_t MAXCACHEDTIES = 4;
+static const int CACHEDCELLBITS = 15;
 
-/*
-class GoodPlayer: public Player
+GoodPlayer::GoodPlayer(string nm, const Game &g, TranspositionTable* table)
+:Player(nm, g), m_placer(g), m_weight(g.rows() * g.cols(), 0),
+ m_table(g.rows() * g.cols() <= (1 << CACHEDCELLBITS) ? table : nullptr), m_endgame(g, table)
 {
-public:
-    virtual bool placeShips(Board &b);
-    virtual Point reccomendAttack();
-    virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
-    virtual void recordAttackByOpponent(Point p);
-};
+    for (int i = 0; i < g.nShips(); i++)
+    {
+        m_lengths.push_back(g.shipLength(i));
+    }
+    m_ties.reserve(g.rows() * g.cols());
+    reset();
+}
+
+void GoodPlayer::reset()
+{
+    m_knowledge.reset(game());
+    m_density.reset(game().rows(), game().cols(), m_lengths);
+}
 
 bool GoodPlayer::placeShips(Board &b)
 {
-    
-    return true; //THIS IS NOT CORRECT MUST DELETE THIS
+      // Ships that touch are found together, so keep them apart
+    return m_placer.place(b, game().rng(), FleetPlacer::APART);
 }
 
-Point GoodPlayer::reccomendAttack()
+  // Weigh every unfired cell on a possible placement through an unresolved
+  // hit by how many such placements cover it (a placement through two hits
+  // counts twice), and put the heaviest in m_ties.  Only the placements
+  // around the hits are visited.  The ties are in order of r * cols + c.
+void GoodPlayer::weighTargets()
 {
-    Point temp;
-    return temp; //THIS IS NOT CORRECT MUST DELETE THIS
+    int cols = game().cols();
+    const vector<Point>& openHits = m_knowledge.openHits();
+    for (size_t i = 0; i < openHits.size(); i++)
+    {
+        m_density.forEachPlacementThrough(openHits[i].r, openHits[i].c,
+            [&](Point topOrLeft, Direction dir, int length, int nShips)
+            {
+                for (int j = 0; j < length; j++)
+                {
+                    int r = topOrLeft.r + (dir == VERTICAL ? j : 0);
+                    int c = topOrLeft.c + (dir == HORIZONTAL ? j : 0);
+                    if (!m_density.isFired(r, c))
+                    {
+                        int cell = r * cols + c;
+                        if (m_weight[cell] == 0)
+                        {
+                            m_weighted.push_back(cell);
+                        }
+                        m_weight[cell] += nShips;
+                    }
+                }
+            });
+    }
+    sort(m_weighted.begin(), m_weighted.end());
+
+    int best = 0;
+    for (size_t i = 0; i < m_weighted.size(); i++)
+    {
+        best = max(best, m_weight[m_weighted[i]]);
+    }
+    for (size_t i = 0; i < m_weighted.size(); i++)
+    {
+        if (m_weight[m_weighted[i]] == best)
+        {
+            m_ties.push_back(m_weighted[i]);
+        }
+        m_weight[m_weighted[i]] = 0; //ready for the next move
+    }
+    m_weighted.clear(); //none in m_ties if no placement fits through the hits
+}
+
+  // One of m_ties at random
+Point GoodPlayer::pickTarget()
+{
+    int cell = m_ties[game().rng().nextInt(int(m_ties.size()))];
+    Point p(cell / game().cols(), cell % game().cols());
+    m_density.markFired(p.r, p.c);
+    return p;
+}
+
+Point GoodPlayer::recommendAttack()
+{
+    Point p;
+    if (m_endgame.solve(m_knowledge, p))
+    {
+        m_density.markFired(p.r, p.c);
+        return p;
+    }
+    m_ties.clear();
+    uint64_t cached;
+    if (m_table != nullptr  &&  m_table->probe(m_knowledge.hash(), cached))
+    {
+        for (uint64_t i = 0, n = cached & 0xF; i < n; i++)
+        {
+            m_ties.push_back(int((cached >> (4 + CACHEDCELLBITS * i)) & ((1 << CACHEDCELLBITS) - 1)));
+        }
+        return pickTarget();
+    }
+
+    if (!m_knowledge.openHits().empty())
+    {
+        weighTargets();
+    }
+    if (m_ties.empty())
+    {
+        if (m_table == nullptr)
+        {
+            if (!m_density.best(game().rng(), p))
+            {
+                return game().randomPoint(); //we have fired everywhere
+            }
+            m_density.markFired(p.r, p.c);
+            return p;
+        }
+        if (!m_density.bestCells(m_ties))
+        {
+            return game().randomPoint(); //we have fired everywhere
+        }
+    }
+    if (m_table != nullptr  &&  m_ties.size() <= MAXCACHEDTIES)
+    {
+        uint64_t entry = m_ties.size();
+        for (size_t i = 0; i < m_ties.size(); i++)
+        {
+            entry |= uint64_t(m_ties[i]) << (4 + CACHEDCELLBITS * i);
+        }
+        m_table->store(m_knowledge.hash(), entry);
+    }
+    return pickTarget();
 }
 
 void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
 {
-    
+    if (!game().isValid(p))
+    {
+        return;
+    }
+    if (!validShot)
+    {
+        if (!m_knowledge.fired(p.r, p.c))
+        {
+            m_density.unmarkFired(p.r, p.c); //it never landed, so it may be chosen again
+        }
+        return;
+    }
+    m_density.markFired(p.r, p.c);
+    if (shipDestroyed  &&  shipId >= 0  &&  shipId < game().nShips())
+    {
+        m_density.removeShip(game().shipLength(shipId)); //before blocking its cells, to save work
+    }
+    m_blocked.clear();
+    m_knowledge.record(p, shotHit, shipDestroyed, shipId, &m_blocked);
+    for (size_t i = 0; i < m_blocked.size(); i++)
+    {
+        m_density.block(m_blocked[i].r, m_blocked[i].c);
+    }
 }
 
 void GoodPlayer::recordAttackByOpponent(Point p)
 {
-    //does nothing for a mediocre player
+    //does nothing for a good player
 }
-*/
  
+//*********************************************************************
+//  MonteCarloPlayer
+//*********************************************************************
+
+  // An unfired cell next to an unresolved hit, or else any unfired cell,
+  // marked fired in k; for a search player that found nothing in time
+static Point fallbackTarget(const Game& g, Knowledge& k)
+{
+    const vector<Point>& hits = k.openHits();
+    for (size_t i = 0; i < hits.size(); i++)
+    {
+        Point next[4] = { Point(hits[i].r-1, hits[i].c), Point(hits[i].r+1, hits[i].c),
+                          Point(hits[i].r, hits[i].c-1), Point(hits[i].r, hits[i].c+1) };
+        for (int j = 0; j < 4; j++)
+        {
+            if (g.isValid(next[j])  &&  !k.fired(next[j].r, next[j].c))
+            {
+                k.markFired(next[j]);
+                return next[j];
+            }
+        }
+    }
+    for (int r = 0; r < g.rows(); r++)
+    {
+        for (int c = 0; c < g.cols(); c++)
+        {
+            if (!k.fired(r, c))
+            {
+                k.markFired(Point(r, c));
+                return Point(r, c);
+            }
+        }
+    }
+    return g.randomPoint(); //we have fired everywhere
+}
+
+  // When a search started at start should stop: after its budget, if it
+  // has one, or a little before the deadline, leaving time to choose from
+  // what it found
+static Player::Deadline searchEnd(Player::Deadline start, chrono::milliseconds budget,
+                                  Player::Deadline deadline)
+{
+    const chrono::microseconds MARGIN(250);
+    Player::Deadline end = (budget.count() > 0 ? start + budget : Player::Deadline::max());
+    if (deadline - MARGIN < end)
+        end = max(start, deadline - MARGIN);
+    return end;
+}
+
+  // How many of a move's playouts worker should run, or -1 for as many as
+  // it can in the time if the move isn't searched by playouts
+static long long playoutQuota(int playoutsPerMove, int worker, int nWorkers)
+{
+    if (playoutsPerMove <= 0)
+        return -1;
+    return playoutsPerMove / nWorkers + (worker < playoutsPerMove % nWorkers ? 1 : 0);
+}
+
+MonteCarloPlayer::MonteCarloPlayer(string nm, const Game &g, int nThreads, int msPerMove,
+                                   int playoutsPerMove, TranspositionTable* table)
+:Player(nm, g), m_placer(g), m_pool(nThreads), m_rngs(m_pool.size()),
+ m_workerCounts(m_pool.size()), m_workerCells(m_pool.size()),
+ m_counts(g.rows() * g.cols()), m_budget(playoutsPerMove > 0 ? 0 : msPerMove),
+ m_playoutsPerMove(max(playoutsPerMove, 0)), m_endgame(g, table)
+{
+    for (int w = 0; w < m_pool.size(); w++)
+    {
+        m_samplers.push_back(FleetSampler(g));
+    }
+    reset();
+}
+
+void MonteCarloPlayer::reset()
+{
+    m_knowledge.reset(game());
+    for (int w = 0; w < m_pool.size(); w++)
+    {
+        m_rngs[w].reseed(game().rng().next()); //seeded from the game, so each differs
+    }
+}
+
+bool MonteCarloPlayer::placeShips(Board &b)
+{
+    return m_placer.place(b, game().rng(), FleetPlacer::APART);
+}
+
+Point MonteCarloPlayer::recommendAttack()
+{
+    CancelToken never;
+    return recommendAttackBy(Deadline::max(), never);
+}
+
+Point MonteCarloPlayer::recommendAttackBy(Deadline deadline, const CancelToken& cancel)
+{
+    Point p;
+    if (m_endgame.solve(m_knowledge, p))
+    {
+        m_knowledge.markFired(p);
+        return p;
+    }
+    int nCells = game().rows() * game().cols();
+    for (int i = 0; i < nCells; i++)
+    {
+        m_counts[i].store(0, memory_order_relaxed);
+    }
+
+    Deadline stop = searchEnd(chrono::steady_clock::now(), m_budget, deadline);
+    m_pool.parallelFor(m_pool.size(), 1,
+        [&](int worker, uint32_t, uint32_t)
+        {
+            vector<int>& counts = m_workerCounts[worker];
+            counts.assign(nCells, 0);
+            vector<int>& cells = m_workerCells[worker];
+            long long quota = playoutQuota(m_playoutsPerMove, worker, m_pool.size());
+            long long tried = 0;
+            do
+            {
+                for (int batch = 0; batch < 16  &&  tried != quota; batch++, tried++) //check the clock now and then
+                {
+                    if (m_samplers[worker].sample(m_knowledge, m_rngs[worker], cells))
+                    {
+                        for (size_t i = 0; i < cells.size(); i++)
+                        {
+                            counts[cells[i]]++;
+                        }
+                    }
+                }
+            } while (tried != quota  &&  chrono::steady_clock::now() < stop  &&  !cancel.cancelled());
+              // Fold this worker's counts in without taking any lock
+            for (int i = 0; i < nCells; i++)
+            {
+                if (counts[i] != 0)
+                {
+                    m_counts[i].fetch_add(counts[i], memory_order_relaxed);
+                }
+            }
+        });
+
+    int cols = game().cols();
+    int best = 0;
+    int ties = 0;
+    for (int i = 0; i < nCells; i++)
+    {
+        int n = m_counts[i].load(memory_order_relaxed);
+        if (m_knowledge.fired(i / cols, i % cols)  ||  n < best  ||  n == 0)
+        {
+            continue;
+        }
+        if (n > best)
+        {
+            best = n;
+            ties = 0;
+        }
+        ties++;
+    }
+    if (ties == 0)
+    {
+        return fallbackTarget(game(), m_knowledge); //no fleet could be drawn in time
+    }
+    int pick = game().rng().nextInt(ties);
+    for (int i = 0; i < nCells; i++)
+    {
+        if (!m_knowledge.fired(i / cols, i % cols)  &&
+            m_counts[i].load(memory_order_relaxed) == best  &&  pick-- == 0)
+        {
+            p = Point(i / cols, i % cols);
+            m_knowledge.markFired(p);
+            return p;
+        }
+    }
+    return fallbackTarget(game(), m_knowledge);
+}
+
+void MonteCarloPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+    if (validShot)
+    {
+        m_knowledge.record(p, shotHit, shipDestroyed, shipId);
+    }
+    else if (game().isValid(p))
+    {
+        m_knowledge.unmarkFired(p);
+    }
+}
+
+void MonteCarloPlayer::recordAttackByOpponent(Point p)
+{
+    //does nothing for a Monte Carlo player
+}
+
+//*********************************************************************
+//  MctsPlayer
+//*********************************************************************
+
+MctsPlayer::MctsPlayer(string nm, const Game &g, int nThreads, int msPerMove, int maxNodes,
+                       int playoutsPerMove, TranspositionTable* table)
+:Player(nm, g), m_placer(g), m_pool(nThreads), m_rngs(m_pool.size()),
+ m_playouts(m_pool.size(), 0), m_visits(g.rows() * g.cols()), m_misses(g.rows() * g.cols()),
+ m_budget(playoutsPerMove > 0 ? 0 : msPerMove), m_playoutsPerMove(max(playoutsPerMove, 0)),
+ m_endgame(g, table)
+{
+    for (int w = 0; w < m_pool.size(); w++)
+    {
+        m_samplers.push_back(FleetSampler(g));
+        m_trees.push_back(SearchTree(g, maxNodes / m_pool.size()));
+    }
+    m_stats.playouts = 0;
+    m_stats.seconds = 0;
+    m_stats.nodes = 0;
+    reset();
+}
+
+void MctsPlayer::reset()
+{
+    m_knowledge.reset(game());
+    for (int w = 0; w < m_pool.size(); w++)
+    {
+        m_rngs[w].reseed(game().rng().next()); //seeded from the game, so each differs
+        m_trees[w].clear();
+    }
+}
+
+bool MctsPlayer::placeShips(Board &b)
+{
+    return m_placer.place(b, game().rng(), FleetPlacer::APART);
+}
+
+Point MctsPlayer::recommendAttack()
+{
+    CancelToken never;
+    return recommendAttackBy(Deadline::max(), never);
+}
+
+Point MctsPlayer::recommendAttackBy(Deadline deadline, const CancelToken& cancel)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    Point p;
+    if (m_endgame.solve(m_knowledge, p))
+    {
+        m_stats.playouts = 0;
+        m_stats.nodes = 0;
+        for (int w = 0; w < m_pool.size(); w++)
+        {
+            m_stats.nodes += m_trees[w].nodesInUse();
+        }
+        m_stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        m_knowledge.markFired(p);
+        return p;
+    }
+    Deadline stop = searchEnd(start, m_budget, deadline);
+    m_pool.parallelFor(m_pool.size(), 1,
+        [&](int worker, uint32_t, uint32_t)
+        {
+            SearchTree& tree = m_trees[worker];
+            tree.prepare(m_knowledge);
+            long long quota = playoutQuota(m_playoutsPerMove, worker, m_pool.size());
+            long long tried = 0;
+            long long playouts = 0;
+            do
+            {
+                for (int batch = 0; batch < 16  &&  tried != quota; batch++, tried++) //check the clock now and then
+                {
+                    if (tree.iterate(m_knowledge, m_samplers[worker], m_rngs[worker]))
+                    {
+                        playouts++;
+                    }
+                }
+            } while (tried != quota  &&  chrono::steady_clock::now() < stop  &&  !cancel.cancelled());
+            m_playouts[worker] = playouts;
+        });
+
+    int nCells = game().rows() * game().cols();
+    fill(m_visits.begin(), m_visits.end(), 0);
+    fill(m_misses.begin(), m_misses.end(), 0);
+    m_stats.playouts = 0;
+    m_stats.nodes = 0;
+    for (int w = 0; w < m_pool.size(); w++)
+    {
+        m_trees[w].addRootStats(m_visits, m_misses);
+        m_stats.playouts += m_playouts[w];
+        m_stats.nodes += m_trees[w].nodesInUse();
+    }
+    m_stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+      // The shot tried most often, and of those the one followed by the
+      // fewest misses on average
+    int cols = game().cols();
+    int best = -1;
+    for (int i = 0; i < nCells; i++)
+    {
+        if (m_visits[i] == 0  ||  m_knowledge.fired(i / cols, i % cols))
+        {
+            continue;
+        }
+        if (best < 0  ||  m_visits[i] > m_visits[best]  ||
+            (m_visits[i] == m_visits[best]  &&  m_misses[i] < m_misses[best]))
+        {
+            best = i;
+        }
+    }
+    if (best < 0)
+    {
+        return fallbackTarget(game(), m_knowledge); //no fleet could be drawn in time
+    }
+    p = Point(best / cols, best % cols);
+    m_knowledge.markFired(p);
+    return p;
+}
+
+void MctsPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+    if (validShot)
+    {
+        m_knowledge.record(p, shotHit, shipDestroyed, shipId);
+        int result = SearchTree::outcome(shotHit, shipDestroyed, shipId);
+        for (int w = 0; w < m_pool.size(); w++)
+        {
+            m_trees[w].advance(p.r * game().cols() + p.c, result);
+        }
+    }
+    else if (game().isValid(p))
+    {
+        m_knowledge.unmarkFired(p);
+    }
+}
+
+void MctsPlayer::recordAttackByOpponent(Point p)
+{
+    //does nothing for an MCTS player
+}
+
 //*********************************************************************
 //  createPlayer
 //*********************************************************************
 
-Player* createPlayer(string type, string nm, const Game& g)
+Player* createPlayer(string type, string nm, const Game& g, const PlayerOptions& options)
 {
     static string types[] = {
-        "human", "awful", "mediocre", "good"
+        "human", "awful", "mediocre", "good", "montecarlo", "mcts"
     };
     
     int pos;
@@ -462,7 +815,12 @@ Player* createPlayer(string type, string nm, const Game& g)
       case 0:  return new HumanPlayer(nm, g);
       case 1:  return new AwfulPlayer(nm, g);
       case 2:  return new MediocrePlayer(nm, g);
-      case 3:  return new GoodPlayer(nm, g);
+      case 3:  return new GoodPlayer(nm, g, options.table);
+      case 4:  return new MonteCarloPlayer(nm, g, options.threads, options.msPerMove,
+                                           options.playoutsPerMove, options.table);
+      case 5:  return new MctsPlayer(nm, g, options.threads, options.msPerMove,
+                                     MctsPlayer::MAXNODES,
+                                     options.playoutsPerMove, options.table);
       default: return nullptr;
     }
 }
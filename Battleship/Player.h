@@ -1,15 +1,38 @@
 #ifndef PLAYER_INCLUDED
 #define PLAYER_INCLUDED
 
+#include <atomic>
+#include <chrono>
 #include <string>
 
 class Point;
 class Board;
 class Game;
+class TranspositionTable;
+
+  // Lets whoever asked for a move call it off before its deadline, from any
+  // thread.  A player that thinks for a while looks at it now and then and,
+  // once it is cancelled, answers at once with the best target it has.
+class CancelToken
+{
+  public:
+    CancelToken() : m_cancelled(false) {}
+    void cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+    void clear() { m_cancelled.store(false, std::memory_order_relaxed); }
+    bool cancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+      // We prevent a CancelToken object from being copied or assigned
+    CancelToken(const CancelToken&) = delete;
+    CancelToken& operator=(const CancelToken&) = delete;
+
+  private:
+    std::atomic<bool> m_cancelled;
+};
 
 class Player
 {
   public:
+    typedef std::chrono::steady_clock::time_point Deadline;
+
     Player(std::string nm, const Game& g)
      : m_name(nm), m_game(g)
     {}
@@ -23,9 +46,28 @@ class Player
 
     virtual bool placeShips(Board& b) = 0;
     virtual Point recommendAttack() = 0;
+      // Recommend an attack by deadline, or as soon as cancel is cancelled,
+      // with the best target found by then.  Players that think for a while
+      // override this, and their recommendAttack takes as long as they
+      // like; the rest are quick enough that they needn't watch the clock,
+      // and keep this adapter, which just asks recommendAttack.
+    virtual Point recommendAttackBy(Deadline deadline, const CancelToken& cancel);
+      // Whether recommendAttackBy answers at once when cancel is cancelled,
+      // as those that override it do; the adapter never looks
+    virtual bool isCancellable() const { return false; }
+      // If validShot is false, the shot at p never landed: it was off the
+      // board, at a cell already attacked, or forfeited for coming after
+      // its deadline (see MoveClock), so p may be chosen again.
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
                                         bool shipDestroyed, int shipId) = 0;
     virtual void recordAttackByOpponent(Point p) = 0;
+      // Forget everything about the last match, leaving the player as if
+      // it had just been made for the same Game.  If the game's random
+      // numbers are to start over (Game::reseed), do that first; a player
+      // that draws from them on construction draws the same on reset.
+      // Recycling players this way lets a long run of matches go without
+      // allocating.
+    virtual void reset() = 0;
       // We prevent any kind of Player object from being copied or assigned
     Player(const Player&) = delete;
     Player& operator=(const Player&) = delete;
@@ -35,6 +77,24 @@ class Player
     const Game& m_game;
 };
 
-Player* createPlayer(std::string type, std::string nm, const Game& g);
+  // How createPlayer sets up the players that search (see Players.h).  By
+  // default each gets a worker thread per hardware thread and a fixed time
+  // for each move, so it plays as well as the machine allows.  A caller
+  // that runs many games at once should give each player one thread, and
+  // one whose games must play out the same every time, whatever the load,
+  // should have each move search a fixed number of playouts instead.
+  // Players given the same table share what they cache in it (positions
+  // and the shots chosen there), which never changes how they play; a
+  // process or tournament should make one and give it to all its players.
+struct PlayerOptions
+{
+    int threads = 0;            //per player; 0 means one per hardware thread
+    int msPerMove = 5;
+    int playoutsPerMove = 0;    //if > 0, search this many a move, however long it takes
+    TranspositionTable* table = nullptr; //if null, each player caches alone
+};
+
+Player* createPlayer(std::string type, std::string nm, const Game& g,
+                     const PlayerOptions& options = PlayerOptions());
 
 #endif // PLAYER_INCLUDED
@@ -0,0 +1,249 @@
+#ifndef PLAYERS_INCLUDED
+#define PLAYERS_INCLUDED
+
+// The concrete kinds of player that createPlayer makes.  They are declared
+// here, and final, so that code that knows at compile time which kinds
+// are playing (see runMatch in Match.h) can call them directly instead of
+// through Player's virtual functions, and inline the simplest of them.
+
+#include "Player.h"
+#include "globals.h"
+#include "BitGrid.h"
+#include "Knowledge.h"
+#include "PlacementDensity.h"
+#include "FleetSampler.h"
+#include "FleetPlacer.h"
+#include "WorkStealingPool.h"
+#include "TranspositionTable.h"
+#include "EndgameSolver.h"
+#include "SearchTree.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// AwfulPlayer clusters its fleet in the top left corner and fires at every
+// cell in turn, from the bottom right.  Its moves are defined here so they
+// can be inlined.
+
+class AwfulPlayer final : public Player
+{
+  public:
+    AwfulPlayer(std::string nm, const Game& g);
+    virtual bool placeShips(Board& b);
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+                                                bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+    virtual void reset();
+  private:
+    Point m_lastCellAttacked;
+    int m_rows;
+    int m_cols;
+};
+
+class HumanPlayer final : public Player {
+public:
+    HumanPlayer(std::string nm, const Game &g);
+    virtual bool isHuman() const;
+    virtual bool placeShips(Board &b);
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+                                    bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+    virtual void reset();
+};
+
+// MediocrePlayer places its fleet uniformly at random and then hunts in a
+// fixed pattern.
+
+class MediocrePlayer final : public Player
+{
+public:
+    MediocrePlayer(std::string nm, const Game &g);
+    virtual bool placeShips(Board &b);
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+    virtual void reset();
+    
+    FleetPlacer m_placer;
+    int m_state; //mediocre is initially in state 1
+    BitGrid m_fired; //cells already chosen as targets
+    Point previous;
+};
+
+// GoodPlayer keeps, for every cell of the opponent's board, the number of
+// placements of the ships not yet sunk that would cover it and are still
+// possible given what it has seen, and fires at the cell covered by the
+// most placements.  The counts are updated as each result comes in rather
+// than recomputed for every move.  Once it has hit a ship it hasn't sunk,
+// it only considers placements through such hits.  Given a table, which
+// any number of GoodPlayers and threads may share, it caches the few cells
+// it would choose among under the hash of what it knows, so a position met
+// before, in any game of the same shape, costs a probe; it still breaks
+// the tie at random, so its play is exactly as without the table.  Once
+// few enough ships and cells are left, it hands the endgame to an
+// EndgameSolver (see setEndgameLimits), which caches its positions in the
+// same table.
+
+class GoodPlayer final : public Player
+{
+public:
+    GoodPlayer(std::string nm, const Game &g, TranspositionTable* table = nullptr);
+    void setEndgameLimits(const EndgameSolver::Limits& limits) { m_endgame.setLimits(limits); }
+    virtual bool placeShips(Board &b);
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+    virtual void reset();
+
+private:
+    FleetPlacer m_placer;
+    Knowledge m_knowledge;
+    PlacementDensity m_density;
+    std::vector<int> m_lengths;       //of each ship, by id
+      // Scratch space kept between moves so that a move allocates nothing
+    std::vector<int> m_weight;        //by r * cols + c, for chooseTarget
+    std::vector<int> m_weighted;      //cells with a nonzero m_weight
+    std::vector<Point> m_blocked;     //cells ruled out by the last result
+    std::vector<int> m_ties;          //the cells to choose among this move
+    TranspositionTable* m_table;      //shared cache of m_ties, or null
+    EndgameSolver m_endgame;
+
+    void weighTargets();
+    Point pickTarget();
+};
+
+// MonteCarloPlayer estimates how likely each cell is to hold a ship by
+// drawing as many random fleets as it can that agree with everything it
+// has seen, and counting how often each cell is covered.  The drawing is
+// spread over a pool of worker threads, each with its own generator and
+// counts, for a fixed time per move (or less, if its deadline comes
+// first), so more cores mean more samples and better estimates without
+// slower moves.  Given playoutsPerMove, it instead draws that many fleets
+// a move, split evenly over the workers, so that with the same number of
+// threads the same game is always played the same way.  Once few enough
+// ships and cells are left for an EndgameSolver to play exactly, well
+// inside that time, it does so instead of sampling, caching the
+// positions it searches in table if given one.
+
+class MonteCarloPlayer final : public Player
+{
+public:
+    MonteCarloPlayer(std::string nm, const Game &g, int nThreads = 0, int msPerMove = 5,
+                     int playoutsPerMove = 0, TranspositionTable* table = nullptr);
+    void setEndgameLimits(const EndgameSolver::Limits& limits) { m_endgame.setLimits(limits); }
+    virtual bool placeShips(Board &b);
+    virtual Point recommendAttack();
+    virtual Point recommendAttackBy(Deadline deadline, const CancelToken& cancel);
+    virtual bool isCancellable() const { return true; }
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+    virtual void reset();
+
+private:
+    FleetPlacer m_placer;
+    Knowledge m_knowledge;
+    WorkStealingPool m_pool;
+    std::vector<RandomEngine> m_rngs;         //one per worker
+    std::vector<FleetSampler> m_samplers;     //one per worker
+    std::vector<std::vector<int> > m_workerCounts; //one per worker
+    std::vector<std::vector<int> > m_workerCells;  //one per worker
+    std::vector<std::atomic<int> > m_counts;       //all workers' counts, merged
+    std::chrono::milliseconds m_budget;       //0 if searching by playouts
+    int m_playoutsPerMove;                    //0 if searching by time
+    EndgameSolver m_endgame;
+};
+
+// MctsPlayer runs an information-set Monte Carlo tree search (see
+// SearchTree) for a fixed time per move, or less if its deadline comes
+// first, or, given playoutsPerMove, for that many playouts split evenly
+// over its workers.  The search uses root
+// parallelism: each worker of its pool grows a tree of its own, from
+// fleets of its own drawing, and the move is the shot tried most often
+// from the roots of all of them.  After each result every tree keeps the
+// subtree for that result, so the search for the next move starts from
+// what was learned about it already.  The trees share maxNodes nodes
+// between them (though each has at least its root), which bounds the
+// player's memory however long it thinks.  Within the limits of its
+// EndgameSolver it plays the endgame exactly instead, caching the
+// positions it searches in table if given one.
+
+class MctsPlayer final : public Player
+{
+public:
+    static const int MAXNODES = 1 << 18;      //the default cap
+
+    MctsPlayer(std::string nm, const Game &g, int nThreads = 0, int msPerMove = 5,
+               int maxNodes = MAXNODES, int playoutsPerMove = 0,
+               TranspositionTable* table = nullptr);
+    void setEndgameLimits(const EndgameSolver::Limits& limits) { m_endgame.setLimits(limits); }
+    virtual bool placeShips(Board &b);
+    virtual Point recommendAttack();
+    virtual Point recommendAttackBy(Deadline deadline, const CancelToken& cancel);
+    virtual bool isCancellable() const { return true; }
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+    virtual void reset();
+
+      // What the last call of recommendAttack did
+    struct Stats
+    {
+        long long playouts;         //over all workers
+        double seconds;             //spent searching
+        int nodes;                  //in use afterwards, over all trees
+    };
+    const Stats& lastSearch() const { return m_stats; }
+
+private:
+    FleetPlacer m_placer;
+    Knowledge m_knowledge;
+    WorkStealingPool m_pool;
+    std::vector<RandomEngine> m_rngs;         //one per worker
+    std::vector<FleetSampler> m_samplers;     //one per worker
+    std::vector<SearchTree> m_trees;          //one per worker
+    std::vector<long long> m_playouts;        //one per worker
+    std::vector<long long> m_visits;          //per cell, over all roots
+    std::vector<double> m_misses;             //per cell, over all roots
+    std::chrono::milliseconds m_budget;       //0 if searching by playouts
+    int m_playoutsPerMove;                    //0 if searching by time
+    EndgameSolver m_endgame;
+    Stats m_stats;
+};
+
+//******************** AwfulPlayer inline functions *********************
+
+inline Point AwfulPlayer::recommendAttack()
+{
+    if (m_lastCellAttacked.c > 0)
+        m_lastCellAttacked.c--;
+    else
+    {
+        m_lastCellAttacked.c = m_cols - 1;
+        if (m_lastCellAttacked.r > 0)
+            m_lastCellAttacked.r--;
+        else
+            m_lastCellAttacked.r = m_rows - 1;
+    }
+    return m_lastCellAttacked;
+}
+
+inline void AwfulPlayer::recordAttackResult(Point /* p */, bool /* validShot */,
+                                            bool /* shotHit */, bool /* shipDestroyed */,
+                                            int /* shipId */)
+{
+      // AwfulPlayer completely ignores the result of any attack
+}
+
+inline void AwfulPlayer::recordAttackByOpponent(Point /* p */)
+{
+      // AwfulPlayer completely ignores what the opponent does
+}
+
+inline void AwfulPlayer::reset()
+{
+    m_lastCellAttacked = Point(0, 0);
+}
+
+#endif // PLAYERS_INCLUDED
@@ -0,0 +1,121 @@
+#ifndef PROTOCOL_INCLUDED
+#define PROTOCOL_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The messages MatchServer and its clients exchange over a stream socket.
+// Every message is a frame: a u16 giving the number of bytes that follow,
+// a u8 message type, then the payload for that type.  All integers are
+// little-endian.
+//
+// From a client:
+//
+//     NEW_GAME       u8 opponent: OPPONENT_REMOTE to be paired with the
+//                    next client asking for the same, or one of the
+//                    computer players OPPONENT_AWFUL to OPPONENT_GOOD
+//     PLACE          u8 count, then per ship: u8 ship id, u16 r, u16 c,
+//                    u8 direction (0 horizontal, 1 vertical); the whole
+//                    fleet at once
+//     FIRE           u16 r, u16 c
+//
+// From the server:
+//
+//     GAME_START     u16 rows, u16 cols, u8 seat (0 moves first),
+//                    u8 number of ships, then per ship: u16 length,
+//                    u8 symbol
+//     PLACED         u8 1 if the fleet was accepted, 0 if not (send
+//                    another PLACE)
+//     YOUR_TURN      nothing; the server is waiting for a FIRE
+//     SHOT_RESULT    u16 r, u16 c, u8 RESULT_ flags, u8 ship id hit
+//                    (255 for none)
+//     OPPONENT_SHOT  u16 r, u16 c
+//     GAME_OVER      u8 OUTCOME_ value; another NEW_GAME may follow
+//     ERROR          u8 ERROR_ code; the message that caused it is ignored
+//
+// A game goes GAME_START, PLACE until PLACED 1, then for each of your
+// turns YOUR_TURN, FIRE and SHOT_RESULT, with an OPPONENT_SHOT for each of
+// theirs, and finally GAME_OVER.  A shot off the board or at a cell
+// already attacked is wasted, as in Game::play.
+
+namespace Protocol
+{
+    enum MessageType
+    {
+        NEW_GAME = 1,
+        PLACE = 2,
+        FIRE = 3,
+
+        GAME_START = 0x81,
+        PLACED = 0x82,
+        YOUR_TURN = 0x83,
+        SHOT_RESULT = 0x84,
+        OPPONENT_SHOT = 0x85,
+        GAME_OVER = 0x86,
+        ERROR = 0x8f
+    };
+
+    enum Opponent
+    {
+        OPPONENT_REMOTE,
+        OPPONENT_AWFUL,
+        OPPONENT_MEDIOCRE,
+        OPPONENT_GOOD,
+        NOPPONENTS
+    };
+
+    enum ResultFlags
+    {
+        RESULT_VALID = 1,
+        RESULT_HIT = 2,
+        RESULT_DESTROYED = 4
+    };
+
+    enum Outcome
+    {
+        OUTCOME_LOST,
+        OUTCOME_WON,
+        OUTCOME_ABANDONED      //the opponent disconnected
+    };
+
+    enum ErrorCode
+    {
+        ERROR_UNKNOWN_MESSAGE = 1,  //bad type or wrong length
+        ERROR_NOT_NOW,              //not expected at this point of the game
+        ERROR_BAD_OPPONENT
+    };
+
+      // No frame, length included, is longer than this
+    const int MAXFRAME = 1024;
+
+    inline void put16(std::vector<uint8_t>& v, int x)
+    {
+        v.push_back(uint8_t(x));
+        v.push_back(uint8_t(x >> 8));
+    }
+
+    inline int get16(const uint8_t* p)
+    {
+        return p[0] | (p[1] << 8);
+    }
+
+      // Start a frame of the given type at the end of v; the length is
+      // filled in by endFrame, given what beginFrame returned
+    inline size_t beginFrame(std::vector<uint8_t>& v, MessageType type)
+    {
+        size_t start = v.size();
+        put16(v, 0);
+        v.push_back(uint8_t(type));
+        return start;
+    }
+
+    inline void endFrame(std::vector<uint8_t>& v, size_t start)
+    {
+        size_t length = v.size() - start - 2;
+        v[start] = uint8_t(length);
+        v[start+1] = uint8_t(length >> 8);
+    }
+}
+
+#endif // PROTOCOL_INCLUDED
@@ -0,0 +1,88 @@
+#ifndef RANDOM_INCLUDED
+#define RANDOM_INCLUDED
+
+#include <cstdint>
+#include <random>
+
+  // A small, fast pseudo-random generator (xoshiro256**).  Two engines
+  // given the same seed produce the same sequence on every platform, so
+  // anything driven by one engine can be replayed from its seed.  An engine
+  // is not safe to share between threads; give each game or thread its own.
+class RandomEngine
+{
+  public:
+    explicit RandomEngine(uint64_t seed = 0) { reseed(seed); }
+
+    void reseed(uint64_t seed)
+    {
+        m_seed = seed;
+          // Expand the seed with splitmix64 so that similar seeds (such as
+          // consecutive game numbers) still give unrelated states
+        for (int i = 0; i < 4; i++)
+            m_s[i] = splitmix64(seed);
+    }
+
+    uint64_t seed() const { return m_seed; }
+
+    uint64_t next()
+    {
+        uint64_t result = rotl(m_s[1] * 5, 7) * 9;
+        uint64_t t = m_s[1] << 17;
+        m_s[2] ^= m_s[0];
+        m_s[3] ^= m_s[1];
+        m_s[1] ^= m_s[2];
+        m_s[0] ^= m_s[3];
+        m_s[2] ^= t;
+        m_s[3] = rotl(m_s[3], 45);
+        return result;
+    }
+
+      // Return a uniformly distributed int from 0 to limit-1.  This uses
+      // Lemire's multiply-and-shift method: the common path is a single
+      // multiplication, and the modulo needed to reject the few biased
+      // products is only computed in the rare case that one might occur.
+    int nextInt(int limit)
+    {
+        uint32_t range = uint32_t(limit);
+        uint64_t m = (next() >> 32) * range;
+        uint32_t low = uint32_t(m);
+        if (low < range)
+        {
+            uint32_t threshold = uint32_t(-range) % range;
+            while (low < threshold)
+            {
+                m = (next() >> 32) * range;
+                low = uint32_t(m);
+            }
+        }
+        return int(m >> 32);
+    }
+
+      // Mix a value into a well-scrambled 64-bit one; also useful for
+      // deriving a family of seeds from one seed
+    static uint64_t splitmix64(uint64_t& state)
+    {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+  private:
+    uint64_t m_s[4];
+    uint64_t m_seed;
+
+    static uint64_t rotl(uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+  // A seed that differs from run to run
+inline uint64_t freshSeed()
+{
+    std::random_device rd;
+    return (uint64_t(rd()) << 32) ^ rd();
+}
+
+#endif // RANDOM_INCLUDED
@@ -0,0 +1,73 @@
+#include "RemotePlayer.h"
+#include "Protocol.h"
+#include "Board.h"
+#include "Game.h"
+
+using namespace std;
+using namespace Protocol;
+
+RemotePlayer::RemotePlayer(string nm, const Game& g)
+ : Player(nm, g), m_outbox(nullptr), m_hasMove(false)
+{}
+
+bool RemotePlayer::setFleet(const uint8_t* payload, int length)
+{
+    if (length < 1  ||  length != 1 + 6 * payload[0])
+        return false;
+    m_fleet.clear();
+    for (int i = 0; i < payload[0]; i++)
+    {
+        const uint8_t* p = payload + 1 + 6 * i;
+        Placement pl = { p[0], Point(get16(p + 1), get16(p + 3)),
+                         (p[5] == 0 ? HORIZONTAL : VERTICAL) };
+        m_fleet.push_back(pl);
+    }
+    return true;
+}
+
+bool RemotePlayer::placeShips(Board& b)
+{
+    if (int(m_fleet.size()) != game().nShips())
+        return false; //every ship must be placed
+    for (size_t i = 0; i < m_fleet.size(); i++)
+        if (!b.placeShip(m_fleet[i].topOrLeft, m_fleet[i].shipId, m_fleet[i].dir))
+            return false;
+    return true;
+}
+
+Point RemotePlayer::recommendAttack()
+{
+    m_hasMove = false;
+    return m_move;
+}
+
+void RemotePlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
+                                      bool shipDestroyed, int shipId)
+{
+    if (m_outbox == nullptr)
+        return;
+    size_t start = beginFrame(*m_outbox, SHOT_RESULT);
+    put16(*m_outbox, p.r);
+    put16(*m_outbox, p.c);
+    m_outbox->push_back(uint8_t((validShot ? RESULT_VALID : 0) |
+                                (shotHit ? RESULT_HIT : 0) |
+                                (shipDestroyed ? RESULT_DESTROYED : 0)));
+    m_outbox->push_back(uint8_t(shipId < 0 ? 255 : shipId));
+    endFrame(*m_outbox, start);
+}
+
+void RemotePlayer::recordAttackByOpponent(Point p)
+{
+    if (m_outbox == nullptr)
+        return;
+    size_t start = beginFrame(*m_outbox, OPPONENT_SHOT);
+    put16(*m_outbox, p.r);
+    put16(*m_outbox, p.c);
+    endFrame(*m_outbox, start);
+}
+
+void RemotePlayer::reset()
+{
+    m_fleet.clear();
+    m_hasMove = false;
+}
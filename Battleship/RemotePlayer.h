@@ -0,0 +1,50 @@
+#ifndef REMOTEPLAYER_INCLUDED
+#define REMOTEPLAYER_INCLUDED
+
+#include "Player.h"
+#include "globals.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+  // A player whose decisions arrive from a client of MatchServer.  The
+  // server hands it the client's fleet and shots as they come in and only
+  // asks it to place or to attack once it has them; what happens to it is
+  // written, as Protocol messages, to the outbox it was given.
+class RemotePlayer final : public Player
+{
+  public:
+    RemotePlayer(std::string nm, const Game& g);
+
+      // Where this player's messages to its client go, or nullptr to drop
+      // them
+    void attach(std::vector<uint8_t>* outbox) { m_outbox = outbox; }
+
+      // Take the fleet from the payload of a PLACE message (after its
+      // type byte); false if the payload is malformed
+    bool setFleet(const uint8_t* payload, int length);
+    void setMove(Point p) { m_move = p; m_hasMove = true; }
+    bool hasMove() const { return m_hasMove; }
+
+    virtual bool placeShips(Board& b);
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+                                    bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+    virtual void reset();
+
+  private:
+    struct Placement
+    {
+        int shipId;
+        Point topOrLeft;
+        Direction dir;
+    };
+
+    std::vector<uint8_t>* m_outbox;
+    std::vector<Placement> m_fleet;
+    Point m_move;
+    bool m_hasMove;
+};
+
+#endif // REMOTEPLAYER_INCLUDED
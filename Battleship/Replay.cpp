@@ -0,0 +1,252 @@
+#include "Replay.h"
+#include "Game.h"
+#include "Board.h"
+#include <cstring>
+#include <ostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char MAGIC[4] = { 'B', 'S', 'R', 'P' };
+static const uint32_t UNPLACED = 0xffffffff;
+
+static void put16(vector<uint8_t>& v, int x)
+{
+    v.push_back(uint8_t(x));
+    v.push_back(uint8_t(x >> 8));
+}
+
+static void put32(vector<uint8_t>& v, uint32_t x)
+{
+    for (int i = 0; i < 4; i++)
+        v.push_back(uint8_t(x >> (8*i)));
+}
+
+//******************** ReplayWriter ***********************************
+
+ReplayWriter::ReplayWriter(ostream& out)
+ : m_out(out), m_game(nullptr), m_shotBytes(1), m_winner(-1)
+{
+    m_boards[0] = m_boards[1] = nullptr;
+    if (m_out.tellp() > 0)
+        return; //the file has its header
+    vector<uint8_t> header(MAGIC, MAGIC + 4);
+    put32(header, VERSION);
+    m_out.write(reinterpret_cast<const char*>(header.data()), header.size());
+}
+
+void ReplayWriter::matchStarted(const Game& g, Player* const players[2],
+                                const Board* const boards[2])
+{
+    m_game = &g;
+    m_boards[0] = boards[0];
+    m_boards[1] = boards[1];
+    int cells = g.rows() * g.cols();
+    m_shotBytes = (cells < 0x100 ? 1 : cells < 0x10000 ? 2 : 3); //room for cells itself too
+    m_winner = -1;
+    m_placements.assign(2 * g.nShips(), UNPLACED);
+    m_shots.clear();
+}
+
+void ReplayWriter::event(const GameEvent& e)
+{
+    switch (e.kind)
+    {
+      case GameEvent::PLACEMENT_DONE:
+        for (int i = 0; i < m_game->nShips(); i++)
+        {
+            Point p;
+            Direction dir;
+            if (m_boards[e.player]->shipPlacement(i, p, dir))
+                m_placements[e.player * m_game->nShips() + i] =
+                                uint32_t(p.r * m_game->cols() + p.c) * 2 + dir;
+        }
+        break;
+      case GameEvent::MISS:
+      case GameEvent::HIT:
+      case GameEvent::SINK:
+      case GameEvent::WASTED_SHOT:
+        {
+            uint32_t cell = (m_game->isValid(e.p) ? e.p.r * m_game->cols() + e.p.c
+                                                  : m_game->rows() * m_game->cols());
+            for (int i = 0; i < m_shotBytes; i++)
+                m_shots.push_back(uint8_t(cell >> (8*i)));
+        }
+        break;
+      case GameEvent::WIN:
+        m_winner = e.player;
+        break;
+      case GameEvent::TURN_START:
+        break;
+    }
+}
+
+void ReplayWriter::matchEnded()
+{
+    const Game& g = *m_game;
+    m_record.clear();
+    put32(m_record, 0); //size, filled in below
+    put16(m_record, g.rows());
+    put16(m_record, g.cols());
+    put16(m_record, g.nShips());
+    m_record.push_back(uint8_t(m_winner < 0 ? 255 : m_winner));
+    m_record.push_back(uint8_t(m_shotBytes));
+    for (int i = 0; i < g.nShips(); i++)
+    {
+        put16(m_record, g.shipLength(i));
+        m_record.push_back(uint8_t(g.shipSymbol(i)));
+        m_record.push_back(uint8_t(min<size_t>(g.shipName(i).size(), 255)));
+    }
+    for (int i = 0; i < g.nShips(); i++)
+    {
+        const string& name = g.shipName(i);
+        m_record.insert(m_record.end(), name.begin(),
+                        name.begin() + min<size_t>(name.size(), 255));
+    }
+    for (size_t i = 0; i < m_placements.size(); i++)
+        put32(m_record, m_placements[i]);
+    put32(m_record, uint32_t(m_shots.size() / m_shotBytes));
+    m_record.insert(m_record.end(), m_shots.begin(), m_shots.end());
+
+    uint32_t size = uint32_t(m_record.size());
+    for (int i = 0; i < 4; i++)
+        m_record[i] = uint8_t(size >> (8*i));
+    m_out.write(reinterpret_cast<const char*>(m_record.data()), m_record.size());
+    m_game = nullptr;
+}
+
+//******************** ReplayGame *************************************
+
+string ReplayGame::shipName(int shipId) const
+{
+    size_t at = 12 + 4 * nShips();
+    for (int i = 0; i < shipId; i++)
+        at += m_rec[12 + 4*i + 3];
+    return string(reinterpret_cast<const char*>(m_rec + at), m_rec[12 + 4*shipId + 3]);
+}
+
+bool ReplayGame::placement(int player, int shipId, Point& topOrLeft, Direction& dir) const
+{
+    uint32_t v = u32(m_placementsAt + 4 * (player * nShips() + shipId));
+    if (v == UNPLACED)
+        return false;
+    int cell = int(v >> 1);
+    topOrLeft = Point(cell / cols(), cell % cols());
+    dir = ((v & 1) ? VERTICAL : HORIZONTAL);
+    return true;
+}
+
+Point ReplayGame::shot(int k) const
+{
+    int bytes = m_rec[11];
+    const uint8_t* s = m_rec + m_shotsAt + size_t(k) * bytes;
+    int cell = 0;
+    for (int i = bytes-1; i >= 0; i--)
+        cell = (cell << 8) | s[i];
+    if (cell >= rows() * cols())
+        return Point(-1, -1); //off the board
+    return Point(cell / cols(), cell % cols());
+}
+
+bool ReplayGame::addFleetTo(Game& g) const
+{
+    if (g.rows() != rows()  ||  g.cols() != cols()  ||  g.nShips() != 0)
+        return false;
+    for (int i = 0; i < nShips(); i++)
+        if (!g.addShip(shipLength(i), shipSymbol(i), shipName(i)))
+            return false;
+    return true;
+}
+
+bool ReplayGame::boardAt(Board& b, int player, int nShots) const
+{
+    b.clear();
+    for (int i = 0; i < nShips(); i++)
+    {
+        Point p;
+        Direction dir;
+        if (placement(player, i, p, dir)  &&  !b.placeShip(p, i, dir))
+            return false;
+    }
+      // The other player's shots are the ones at this player's board
+    for (int k = 1 - player; k < nShots  &&  k < m_nShots; k += 2)
+    {
+        Point p = shot(k);
+        bool shotHit;
+        bool shipDestroyed;
+        int shipId;
+        if (p.r >= 0)
+            b.attack(p, shotHit, shipDestroyed, shipId); //a repeat is just wasted
+    }
+    return true;
+}
+
+//******************** ReplayReader ***********************************
+
+bool ReplayReader::open(const string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0  ||  size_t(st.st_size) < HEADERSIZE)
+    {
+        ::close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); //the mapping keeps the file's contents available
+    if (p == MAP_FAILED)
+        return false;
+    m_data = static_cast<const uint8_t*>(p);
+    m_size = st.st_size;
+    uint32_t version = m_data[4] | (m_data[5] << 8) | (m_data[6] << 16) |
+                       (uint32_t(m_data[7]) << 24);
+    if (memcmp(m_data, MAGIC, 4) != 0  ||  version != ReplayWriter::VERSION)
+    {
+        close();
+        return false;
+    }
+    rewind();
+    return true;
+}
+
+void ReplayReader::close()
+{
+    if (m_data != nullptr)
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    m_data = nullptr;
+    m_size = 0;
+    m_next = 0;
+}
+
+bool ReplayReader::next(ReplayGame& game)
+{
+    if (m_data == nullptr  ||  m_next + 12 > m_size)
+        return false;
+    ReplayGame g;
+    g.m_rec = m_data + m_next;
+    size_t size = g.u32(0);
+    if (size < 12  ||  size > m_size - m_next)
+        return false; //damaged or cut short
+    size_t at = 12 + 4 * size_t(g.nShips());
+    if (at > size)
+        return false;
+    for (int i = 0; i < g.nShips(); i++)
+        at += g.m_rec[12 + 4*i + 3];
+    g.m_placementsAt = at;
+    at += 8 * size_t(g.nShips());
+    if (at + 4 > size)
+        return false;
+    g.m_nShots = int(g.u32(at));
+    g.m_shotsAt = at + 4;
+    if (g.m_shotsAt + size_t(g.m_nShots) * g.m_rec[11] > size)
+        return false;
+    game = g;
+    m_next += size;
+    return true;
+}
@@ -0,0 +1,136 @@
+#ifndef REPLAY_INCLUDED
+#define REPLAY_INCLUDED
+
+#include "globals.h"
+#include "GameObserver.h"
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class Game;
+class Board;
+
+  // A replay file is an 8-byte header ("BSRP" and a 32-bit version) followed
+  // by one record per match.  All integers are little-endian.  A record is
+  //
+  //     u32 size of the whole record, in bytes
+  //     u16 rows, u16 cols
+  //     u16 number of ships
+  //     u8  winner: 0 for the player who moved first, 1 for the other,
+  //         255 for none
+  //     u8  bytes per shot
+  //     per ship: u16 length, u8 symbol, u8 name length
+  //     the ship names, one after another
+  //     per player, per ship: u32 placement, (top or left cell) * 2 + dir,
+  //         or 0xffffffff if the ship was never placed
+  //     u32 number of shots
+  //     the shots, alternating between the players starting with player 0
+  //
+  // A shot is the cell attacked, r * cols + c, in as few bytes as hold every
+  // cell plus one: a single byte on boards of up to 255 cells, two on up to
+  // 65535, three beyond that.  The value rows * cols marks a shot off the
+  // board.
+
+  // Records every match it observes, appending each to a stream once the
+  // match is over.  The file header is written when the writer is made,
+  // unless the stream is already past its start, as it is when appending
+  // to an existing replay file opened with ios::app | ios::ate.
+class ReplayWriter : public GameObserver
+{
+  public:
+    static const uint32_t VERSION = 1;
+
+    explicit ReplayWriter(std::ostream& out);
+    void matchStarted(const Game& g, Player* const players[2],
+                      const Board* const boards[2]) override;
+    void event(const GameEvent& e) override;
+    void matchEnded() override;
+
+  private:
+    std::ostream& m_out;
+    const Game* m_game;
+    const Board* m_boards[2];
+    int m_shotBytes;
+    int m_winner;
+    std::vector<uint32_t> m_placements;  //player 0's ships, then player 1's
+    std::vector<uint8_t> m_shots;
+    std::vector<uint8_t> m_record;
+};
+
+  // One match as stored in a mapped replay file.  Nothing is copied out of
+  // the file; the accessors decode the bytes in place, so a ReplayGame is
+  // only good while the ReplayReader it came from keeps the file open.
+class ReplayGame
+{
+  public:
+    ReplayGame() : m_rec(nullptr) {}
+
+    int rows() const { return u16(4); }
+    int cols() const { return u16(6); }
+    int nShips() const { return u16(8); }
+    int winner() const { return m_rec[10] == 255 ? -1 : m_rec[10]; }
+    int shipLength(int shipId) const { return u16(12 + 4*shipId); }
+    char shipSymbol(int shipId) const { return char(m_rec[12 + 4*shipId + 2]); }
+    std::string shipName(int shipId) const;
+
+      // Where one of a player's ships went; false if it was never placed
+    bool placement(int player, int shipId, Point& topOrLeft, Direction& dir) const;
+
+    int nShots() const { return m_nShots; }
+      // The k-th shot of the match, fired by player k % 2.  A shot off the
+      // board comes back as (-1,-1).
+    Point shot(int k) const;
+
+      // Add this match's fleet to g, which must be an empty game of the
+      // same size
+    bool addFleetTo(Game& g) const;
+      // Make b, a board for a game set up by addFleetTo, hold player's
+      // fleet as it stood after the first nShots shots of the match.
+      // Returns false if the record doesn't replay cleanly.
+    bool boardAt(Board& b, int player, int nShots) const;
+
+  private:
+    friend class ReplayReader;
+    const uint8_t* m_rec;
+    std::size_t m_placementsAt;     //offsets within the record
+    std::size_t m_shotsAt;
+    int m_nShots;
+
+    int u16(std::size_t at) const { return m_rec[at] | (m_rec[at+1] << 8); }
+    uint32_t u32(std::size_t at) const
+    {
+        return uint32_t(m_rec[at]) | (uint32_t(m_rec[at+1]) << 8) |
+               (uint32_t(m_rec[at+2]) << 16) | (uint32_t(m_rec[at+3]) << 24);
+    }
+};
+
+  // Maps a replay file into memory and steps through its matches
+class ReplayReader
+{
+  public:
+    ReplayReader() : m_data(nullptr), m_size(0), m_next(0) {}
+    ~ReplayReader() { close(); }
+
+      // Map the file; returns false if it can't be read or isn't a replay
+    bool open(const std::string& path);
+    void close();
+
+      // Go back to the first match
+    void rewind() { m_next = HEADERSIZE; }
+      // Point game at the next match; returns false after the last one or
+      // at a damaged record
+    bool next(ReplayGame& game);
+
+    ReplayReader(const ReplayReader&) = delete;
+    ReplayReader& operator=(const ReplayReader&) = delete;
+
+  private:
+    static const std::size_t HEADERSIZE = 8;
+    const uint8_t* m_data;
+    std::size_t m_size;
+    std::size_t m_next;
+};
+
+#endif // REPLAY_INCLUDED
@@ -0,0 +1,380 @@
+#include "SearchTree.h"
+#include "Game.h"
+#include "Knowledge.h"
+#include "FleetSampler.h"
+#include <cmath>
+
+using namespace std;
+
+  // What a cell of a position holds, as far as the attacker knows
+static const uint8_t UNFIRED = 0;
+static const uint8_t SPENT = 1;   //a miss, or a hit on a sunk ship
+static const uint8_t OPENHIT = 2; //a hit on a ship still afloat
+
+  // The weight of the UCB1 exploration term, against a shot's value, which
+  // is a fraction between 0 and 1
+static const double EXPLORATION = 0.1;
+
+  // How many visits of a shot its own results count as much as the hit
+  // rate of its cell in every fleet drawn at its parent
+static const double RAVEVISITS = 3000;
+
+SearchTree::SearchTree(const Game& g, int maxNodes)
+ : m_game(g), m_nCells(g.rows() * g.cols()), m_maxNodes(maxNodes < 1 ? 1 : maxNodes),
+   m_free(NONE), m_inUse(0), m_root(NONE), m_rootState(m_nCells, UNFIRED),
+   m_shipAt(m_nCells, -1), m_health(g.nShips(), 0), m_afloat(0),
+   m_state(m_nCells, UNFIRED), m_slot(m_nCells, 0)
+{
+    clear();
+}
+
+void SearchTree::clear()
+{
+    m_nodes.clear();
+    m_free = NONE;
+    m_inUse = 0;
+    m_root = newNode(0);
+}
+
+int32_t SearchTree::newNode(int32_t move)
+{
+    int32_t n;
+    if (m_free != NONE)
+    {
+        n = m_free;
+        m_free = m_nodes[n].sibling;
+    }
+    else if (int(m_nodes.size()) < m_maxNodes)
+    {
+        n = int32_t(m_nodes.size());
+        m_nodes.push_back(Node());
+    }
+    else
+        return NONE;
+    Node& node = m_nodes[n];
+    node.child = node.sibling = NONE;
+    node.move = move;
+    node.visits = 0;
+    node.shots = 0;
+    node.misses = 0;
+    node.fleets = 0;
+    node.fleetHits = 0;
+    m_inUse++;
+    return n;
+}
+
+int32_t SearchTree::findChild(int32_t parent, int32_t move) const
+{
+    int32_t n = m_nodes[parent].child;
+    while (n != NONE  &&  m_nodes[n].move != move)
+        n = m_nodes[n].sibling;
+    return n;
+}
+
+  // Return n and everything below it to the pool, except the subtree at keep
+void SearchTree::freeSubtree(int32_t n, int32_t keep)
+{
+    m_stack.clear();
+    m_stack.push_back(n);
+    while (!m_stack.empty())
+    {
+        int32_t m = m_stack.back();
+        m_stack.pop_back();
+        for (int32_t child = m_nodes[m].child; child != NONE; child = m_nodes[child].sibling)
+            if (child != keep)
+                m_stack.push_back(child);
+        m_nodes[m].sibling = m_free;
+        m_free = m;
+        m_inUse--;
+    }
+}
+
+void SearchTree::advance(int cell, int result)
+{
+    int32_t shot = findChild(m_root, cell);
+    int32_t next = (shot == NONE ? NONE : findChild(shot, result));
+    freeSubtree(m_root, next);
+    if (next != NONE)
+    {
+        m_nodes[next].sibling = NONE;
+        m_root = next;
+    }
+    else
+        m_root = newNode(result);
+}
+
+void SearchTree::prepare(const Knowledge& k)
+{
+    int cols = m_game.cols();
+    m_rootUnfired.clear();
+    for (int i = 0; i < m_nCells; i++)
+    {
+        int r = i / cols;
+        int c = i % cols;
+        if (!k.fired(r, c))
+        {
+            m_rootState[i] = UNFIRED;
+            m_rootUnfired.push_back(i);
+        }
+        else
+            m_rootState[i] = (k.openHit(r, c) ? OPENHIT : SPENT); //unsure as drawn
+    }
+    m_rootOpen.clear();
+    const vector<Point>& hits = k.openHits();
+    for (size_t i = 0; i < hits.size(); i++)
+        m_rootOpen.push_back(hits[i].r * cols + hits[i].c);
+    m_rootUnsure.clear();
+    const vector<Point>& unsure = k.unsureHits();
+    for (size_t i = 0; i < unsure.size(); i++)
+        m_rootUnsure.push_back(unsure[i].r * cols + unsure[i].c);
+}
+
+  // Lay a fleet drawn by sampler on the iteration's position
+bool SearchTree::drawFleet(const Knowledge& k, FleetSampler& sampler, RandomEngine& rng)
+{
+    if (!sampler.sample(k, rng, m_sample))
+        return false;
+    const vector<FleetSampler::Placement>& fleet = sampler.lastFleet();
+    size_t next = 0;
+    for (size_t i = 0; i < fleet.size(); i++)
+    {
+        int id = fleet[i].shipId;
+        int health = 0;
+        for (int j = m_game.shipLength(id); j > 0; j--)
+        {
+            int cell = m_sample[next++];
+            m_shipAt[cell] = int16_t(id);
+            if (m_rootState[cell] == UNFIRED)
+                health++;
+        }
+        m_health[id] = health;
+    }
+    m_afloat = int(fleet.size());
+    for (size_t i = 0; i < fleet.size(); i++)
+    {
+        if (m_health[fleet[i].shipId] == 0) //laid wholly on hits, so it would be sunk
+        {
+            for (size_t j = 0; j < m_sample.size(); j++)
+                m_shipAt[m_sample[j]] = -1;
+            return false;
+        }
+    }
+    return true;
+}
+
+  // Fire at an unfired cell of the iteration's position, setting result to
+  // its outcome; return whether it hit
+bool SearchTree::fire(int cell, int& result)
+{
+    int last = m_unfired.back();
+    m_unfired[m_slot[cell]] = last;
+    m_slot[last] = m_slot[cell];
+    m_unfired.pop_back();
+
+    int id = m_shipAt[cell];
+    if (id < 0)
+    {
+        m_state[cell] = SPENT;
+        result = 0;
+        return false;
+    }
+    if (--m_health[id] > 0)
+    {
+        m_state[cell] = OPENHIT;
+        m_open.push_back(cell);
+        result = 1;
+        return true;
+    }
+    m_state[cell] = SPENT;
+    m_afloat--;
+    for (size_t i = 0; i < m_open.size(); )
+    {
+        if (m_shipAt[m_open[i]] == id)
+        {
+            m_state[m_open[i]] = SPENT;
+            m_open[i] = m_open.back();
+            m_open.pop_back();
+        }
+        else
+            i++;
+    }
+    result = 2 + id;
+    return true;
+}
+
+  // The playout policy: next to an unresolved hit, preferring to carry on
+  // along a line of hits, or else a random unfired cell, preferring one
+  // cell of each checkerboard pair
+int SearchTree::policyShot(RandomEngine& rng)
+{
+    int rows = m_game.rows();
+    int cols = m_game.cols();
+    m_candidates.clear();
+    bool inLine = false;
+    for (size_t i = 0; i < m_open.size(); i++)
+    {
+        int r = m_open[i] / cols;
+        int c = m_open[i] % cols;
+        static const int DR[4] = { -1, 1, 0, 0 };
+        static const int DC[4] = { 0, 0, -1, 1 };
+        for (int d = 0; d < 4; d++)
+        {
+            int nr = r + DR[d];
+            int nc = c + DC[d];
+            if (nr < 0  ||  nr >= rows  ||  nc < 0  ||  nc >= cols  ||
+                m_state[nr * cols + nc] != UNFIRED)
+                continue;
+            int br = r - DR[d];
+            int bc = c - DC[d];
+            bool line = (br >= 0  &&  br < rows  &&  bc >= 0  &&  bc < cols  &&
+                         m_state[br * cols + bc] == OPENHIT);
+            if (line  &&  !inLine)
+            {
+                m_candidates.clear();
+                inLine = true;
+            }
+            if (line == inLine)
+                m_candidates.push_back(nr * cols + nc);
+        }
+    }
+    if (!m_candidates.empty())
+        return m_candidates[rng.nextInt(int(m_candidates.size()))];
+
+    int cell = m_unfired[rng.nextInt(int(m_unfired.size()))];
+    for (int tries = 0; tries < 4  &&  (cell / cols + cell % cols) % 2 != 0; tries++)
+        cell = m_unfired[rng.nextInt(int(m_unfired.size()))];
+    return cell;
+}
+
+  // The shot to take from a decision node: the one the playout policy
+  // suggests, added to the tree if it isn't there yet and there is room,
+  // or else the best of the node's shots by UCB1.  NONE if it has none.
+int32_t SearchTree::selectShot(int32_t node, RandomEngine& rng, bool& added)
+{
+    added = false;
+    int suggested = policyShot(rng);
+    if (findChild(node, suggested) == NONE)
+    {
+        int32_t shot = newNode(suggested);
+        if (shot != NONE)
+        {
+            m_nodes[shot].sibling = m_nodes[node].child;
+            m_nodes[node].child = shot;
+            added = true;
+            return shot;
+        }
+    }
+
+    double logN = log(double(m_nodes[node].visits) + 1);
+    int32_t best = NONE;
+    double bestValue = -1;
+    for (int32_t n = m_nodes[node].child; n != NONE; n = m_nodes[n].sibling)
+    {
+        Node& shot = m_nodes[n];
+        shot.fleets++;
+        if (m_shipAt[shot.move] >= 0)
+            shot.fleetHits++;
+        double hitRate = double(shot.fleetHits) / shot.fleets;
+        double value = hitRate;
+        if (shot.visits > 0)
+        {
+            double beta = sqrt(RAVEVISITS / (3.0 * shot.visits + RAVEVISITS));
+            value = beta * hitRate + (1 - beta) * (1 - shot.misses / shot.shots) +
+                    EXPLORATION * sqrt(logN / shot.visits);
+        }
+        else
+            value += EXPLORATION * sqrt(logN);
+        if (value > bestValue)
+        {
+            bestValue = value;
+            best = n;
+        }
+    }
+    return best;
+}
+
+bool SearchTree::iterate(const Knowledge& k, FleetSampler& sampler, RandomEngine& rng)
+{
+    if (!drawFleet(k, sampler, rng))
+        return false;
+    m_state = m_rootState;
+    m_unfired = m_rootUnfired;
+    for (size_t i = 0; i < m_unfired.size(); i++)
+        m_slot[m_unfired[i]] = int(i);
+    m_open = m_rootOpen;
+    for (size_t i = 0; i < m_rootUnsure.size(); i++)
+    {
+        int cell = m_rootUnsure[i];
+        if (m_shipAt[cell] >= 0) //the fleet drawn puts a ship afloat there
+        {
+            m_state[cell] = OPENHIT;
+            m_open.push_back(cell);
+        }
+    }
+    m_path.clear();
+    m_missesBefore.clear();
+    m_decisions.clear();
+
+      // Down the tree
+    int misses = 0;
+    int shots = 0;
+    int32_t node = m_root;
+    while (m_afloat > 0)
+    {
+        m_decisions.push_back(node);
+        bool added;
+        int32_t shot = selectShot(node, rng, added);
+        if (shot == NONE)
+            break;
+        m_path.push_back(shot);
+        m_missesBefore.push_back(misses);
+        int result;
+        shots++;
+        if (!fire(m_nodes[shot].move, result))
+            misses++;
+        if (added)
+            break;
+        int32_t next = findChild(shot, result);
+        if (next == NONE)
+        {
+            next = newNode(result);
+            if (next == NONE)
+                break;
+            m_nodes[next].sibling = m_nodes[shot].child;
+            m_nodes[shot].child = next;
+        }
+        node = next;
+    }
+
+      // The rest of the game by the playout policy
+    while (m_afloat > 0)
+    {
+        int result;
+        shots++;
+        if (!fire(policyShot(rng), result))
+            misses++;
+    }
+
+    for (size_t i = 0; i < m_path.size(); i++)
+    {
+        Node& shot = m_nodes[m_path[i]];
+        shot.visits++;
+        shot.shots += float(shots - int(i));
+        shot.misses += float(misses - m_missesBefore[i]);
+    }
+    for (size_t i = 0; i < m_decisions.size(); i++)
+        m_nodes[m_decisions[i]].visits++;
+
+    for (size_t i = 0; i < m_sample.size(); i++)
+        m_shipAt[m_sample[i]] = -1;
+    return true;
+}
+
+void SearchTree::addRootStats(vector<long long>& visits, vector<double>& misses) const
+{
+    for (int32_t n = m_nodes[m_root].child; n != NONE; n = m_nodes[n].sibling)
+    {
+        visits[m_nodes[n].move] += m_nodes[n].visits;
+        misses[m_nodes[n].move] += m_nodes[n].misses;
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef SEARCHTREE_INCLUDED
+#define SEARCHTREE_INCLUDED
+
+#include "globals.h"
+#include <cstdint>
+#include <vector>
+
+class Game;
+class Knowledge;
+class FleetSampler;
+
+  // The tree of an information-set Monte Carlo tree search over the
+  // opponent's hidden fleet.  A decision node stands for what the attacker
+  // knows after a sequence of shots; its children are the shots it has
+  // tried from there, and a shot's children are the decision nodes for the
+  // results seen after it (a miss, a hit, or the sinking of a given ship).
+  // Each iteration draws a fleet that agrees with the root's knowledge, so
+  // the result of every shot is settled, walks down the tree choosing shots
+  // by UCB1, adds a shot, plays the game out with a quick hunt-and-target
+  // policy, and credits each shot on the way with the misses that followed
+  // it.  Since every cell of a ship must be hit anyway, fewer misses means
+  // fewer shots.  A playout says little about any one shot, so until a shot
+  // has had a few thousand, its value leans on how often its cell held a
+  // ship in all the fleets drawn at its parent (as in RAVE), which every
+  // iteration through the parent adds to.  A hit that may or may not be a
+  // sunk ship's (see Knowledge::unsureHits) is open in an iteration whose
+  // fleet puts a ship afloat there, and spent in the rest.
+  //
+  // The nodes come from a pool that never holds more than maxNodes; once
+  // it is full the tree stops growing and the iterations just play out from
+  // where they leave it.  After a shot, advance keeps the subtree for its
+  // result as the new root and returns the rest of the tree to the pool.
+  // A tree holds scratch space, so give each thread its own.
+class SearchTree
+{
+  public:
+    SearchTree(const Game& g, int maxNodes);
+
+      // Drop everything but an empty root
+    void clear();
+
+      // Take the positions of the shots fired so far from k, which must be
+      // what the root stands for; call before iterating on a new move
+    void prepare(const Knowledge& k);
+
+      // Run one iteration from a fleet drawn by sampler; false if no fleet
+      // agreeing with k could be drawn
+    bool iterate(const Knowledge& k, FleetSampler& sampler, RandomEngine& rng);
+
+      // Add to visits (by r * cols + c) how often each shot from the root
+      // was tried, and to misses the misses that followed those tries
+    void addRootStats(std::vector<long long>& visits, std::vector<double>& misses) const;
+
+      // The shot at cell got the given result (see outcome); make the node
+      // for that the root
+    void advance(int cell, int result);
+
+      // The code for a result in the tree: 0 for a miss, 1 for a hit that
+      // sank nothing, and 2 + shipId for a hit that sank that ship
+    static int outcome(bool shotHit, bool shipDestroyed, int shipId)
+    {
+        return !shotHit ? 0 : !shipDestroyed ? 1 : 2 + shipId;
+    }
+
+    int nodesInUse() const { return m_inUse; }
+    int maxNodes() const { return m_maxNodes; }
+
+  private:
+    static const int32_t NONE = -1;
+
+    struct Node
+    {
+        int32_t child;              //first child, or NONE
+        int32_t sibling;            //next child of the same parent, or NONE
+        int32_t move;               //cell of a shot, outcome of a decision
+        uint32_t visits;
+        float shots;                //over all visits, from this shot on
+        float misses;               //of those shots
+        uint32_t fleets;            //fleets drawn at the parent since it was added
+        uint32_t fleetHits;         //of those, how many had a ship on its cell
+    };
+
+    const Game& m_game;
+    int m_nCells;
+    int m_maxNodes;
+    std::vector<Node> m_nodes;      //grows up to m_maxNodes
+    int32_t m_free;                 //first free node, chained by sibling
+    int m_inUse;
+    int32_t m_root;
+
+      // The root's position, from prepare
+    std::vector<uint8_t> m_rootState;    //per cell: UNFIRED, SPENT or OPENHIT
+    std::vector<int> m_rootUnfired;      //unfired cells, in any order
+    std::vector<int> m_rootOpen;         //unresolved hits
+    std::vector<int> m_rootUnsure;       //hits that may be a sunk ship's
+
+      // The position of the current iteration
+    std::vector<int16_t> m_shipAt;       //per cell, -1 for water
+    std::vector<int> m_health;           //unhit cells left, per ship
+    int m_afloat;
+    std::vector<uint8_t> m_state;        //per cell, as m_rootState
+    std::vector<int> m_unfired;          //unfired cells, in any order
+    std::vector<int> m_slot;             //per cell, its index in m_unfired
+    std::vector<int> m_open;             //unresolved hits
+    std::vector<int> m_sample;           //cells of the drawn fleet
+    std::vector<int32_t> m_path;         //shots taken in the tree
+    std::vector<int> m_missesBefore;     //misses before each of those
+    std::vector<int32_t> m_decisions;    //decision nodes passed through
+    std::vector<int> m_candidates;
+    std::vector<int32_t> m_stack;
+
+    int32_t newNode(int32_t move);
+    int32_t findChild(int32_t parent, int32_t move) const;
+    void freeSubtree(int32_t n, int32_t keep);
+    bool drawFleet(const Knowledge& k, FleetSampler& sampler, RandomEngine& rng);
+    bool fire(int cell, int& result);
+    int policyShot(RandomEngine& rng);
+    int32_t selectShot(int32_t node, RandomEngine& rng, bool& added);
+};
+
+#endif // SEARCHTREE_INCLUDED
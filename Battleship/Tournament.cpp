@@ -0,0 +1,232 @@
+#include "Tournament.h"
+#include "WorkStealingPool.h"
+#include "Game.h"
+#include "Board.h"
+#include "Player.h"
+#include "Players.h"
+#include "Match.h"
+#include "Random.h"
+#include <chrono>
+#include <vector>
+
+using namespace std;
+
+  // Each worker adds its games into its own tally.  Tallies are aligned to
+  // a cache line so that two workers never write to the same line.
+struct alignas(64) WorkerTally
+{
+    long long games = 0;
+    long long wins[2] = { 0, 0 };
+    long long noResult = 0;
+    long long turns = 0;
+    long long shotsFired[2] = { 0, 0 };
+    long long hits[2] = { 0, 0 };
+    long long wastedShots[2] = { 0, 0 };
+};
+
+  // What a worker needs to play a game: made for its first game and then
+  // recycled, with the game reseeded and the players reset, for the rest,
+  // so that once a worker is going its games allocate nothing
+struct WorkerTable
+{
+    Game* game = nullptr;
+    Board* boards[2] = { nullptr, nullptr };
+    Player* players[2] = { nullptr, nullptr };
+
+    WorkerTable() {}
+    ~WorkerTable()
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            delete players[i];
+            delete boards[i];
+        }
+        delete game;
+    }
+    WorkerTable(const WorkerTable&) = delete;
+    WorkerTable& operator=(const WorkerTable&) = delete;
+};
+
+  // The rules of a tournament, which every game follows
+struct TournamentSpec
+{
+    string type1;
+    string type2;
+    int nRows;
+    int nCols;
+    bool (*addShips)(Game&);
+    uint64_t seed;
+    PlayerOptions players;
+};
+
+  // The playouts a searching player runs for each move, about what one
+  // core gets through in the time it takes by default
+static const int PLAYOUTSPERMOVE = 2000;
+
+  // Games are handed to workers in batches of this many, and no single
+  // parallelFor covers more than MAXBATCH games.
+static const uint32_t GRAIN = 64;
+static const long long MAXBATCH = 1LL << 30;
+
+  // Add the result of a game between p1 and p2 into the tally
+static void tallyGame(const MatchResult& result, const Player* p1, const Player* p2,
+                      bool p1First, WorkerTally& tally)
+{
+    int slot1 = (p1First ? 0 : 1); //where p1's numbers are in result
+
+    tally.games++;
+    if (result.winner == p1)
+        tally.wins[0]++;
+    else if (result.winner == p2)
+        tally.wins[1]++;
+    else
+        tally.noResult++;
+    tally.turns += result.turns;
+    for (int i = 0; i < 2; i++)
+    {
+        int from = (i == 0 ? slot1 : 1 - slot1);
+        tally.shotsFired[i] += result.shotsFired[from];
+        tally.hits[i] += result.hits[from];
+        tally.wastedShots[i] += result.wastedShots[from];
+    }
+}
+
+  // Set the table up for game k, exactly as if its game and players had
+  // just been made for it
+static void setTable(const TournamentSpec& spec, long long k, WorkerTable& table)
+{
+    if (table.game == nullptr)
+    {
+        table.game = new Game(spec.nRows, spec.nCols, gameSeed(spec.seed, k));
+        spec.addShips(*table.game);
+        table.players[0] = createPlayer(spec.type1, spec.type1, *table.game, spec.players);
+        table.players[1] = createPlayer(spec.type2, spec.type2, *table.game, spec.players);
+        for (int i = 0; i < 2; i++)
+            table.boards[i] = new Board(*table.game);
+    }
+    else
+    {
+        table.game->reseed(gameSeed(spec.seed, k));
+        for (int i = 0; i < 2; i++)
+            if (table.players[i] != nullptr)
+                table.players[i]->reset();
+    }
+}
+
+  // Play game k of the tournament at the worker's table, with players of
+  // types T1 and T2.  For Player this goes through the virtual functions
+  // and works for any types; for the classes in Players.h the players are
+  // called directly.  Either way the game is the same.
+template <class T1, class T2>
+static void playGame(const TournamentSpec& spec, long long k, WorkerTable& table,
+                     WorkerTally& tally)
+{
+    setTable(spec, k, table);
+    const Game& g = *table.game;
+    T1* p1 = static_cast<T1*>(table.players[0]);
+    T2* p2 = static_cast<T2*>(table.players[1]);
+    Board& b1 = *table.boards[0];
+    Board& b2 = *table.boards[1];
+    bool p1First = (k % 2 == 0);
+    MatchResult result = { nullptr, 0, { 0, 0 }, { 0, 0 }, { 0, 0 } };
+    if (p1 != nullptr  &&  p2 != nullptr) //else createPlayer didn't know a type
+        result = (p1First ? simulateMatch(g, *p1, *p2, b1, b2)
+                          : simulateMatch(g, *p2, *p1, b1, b2));
+    tallyGame(result, p1, p2, p1First, tally);
+}
+
+typedef void (*PlayFn)(const TournamentSpec& spec, long long k, WorkerTable& table,
+                       WorkerTally& tally);
+
+template <class T1>
+static PlayFn typedPlayFor(const string& type2)
+{
+    if (type2 == "awful")
+        return playGame<T1, AwfulPlayer>;
+    if (type2 == "mediocre")
+        return playGame<T1, MediocrePlayer>;
+    if (type2 == "good")
+        return playGame<T1, GoodPlayer>;
+    if (type2 == "montecarlo")
+        return playGame<T1, MonteCarloPlayer>;
+    if (type2 == "mcts")
+        return playGame<T1, MctsPlayer>;
+    return playGame<Player, Player>;
+}
+
+  // The fastest way to play games between the two types.  Humans, and
+  // types createPlayer doesn't know, go through Player.
+static PlayFn playFor(const string& type1, const string& type2)
+{
+    if (type1 == "awful")
+        return typedPlayFor<AwfulPlayer>(type2);
+    if (type1 == "mediocre")
+        return typedPlayFor<MediocrePlayer>(type2);
+    if (type1 == "good")
+        return typedPlayFor<GoodPlayer>(type2);
+    if (type1 == "montecarlo")
+        return typedPlayFor<MonteCarloPlayer>(type2);
+    if (type1 == "mcts")
+        return typedPlayFor<MctsPlayer>(type2);
+    return playGame<Player, Player>;
+}
+
+uint64_t gameSeed(uint64_t tournamentSeed, long long k)
+{
+    uint64_t state = tournamentSeed + uint64_t(k);
+    return RandomEngine::splitmix64(state);
+}
+
+TournamentResult runTournament(string type1, string type2,
+                               int nRows, int nCols, bool (*addShips)(Game&),
+                               long long nGames, int nThreads, uint64_t seed)
+{
+    if (seed == 0)
+        seed = freshSeed();
+    WorkStealingPool pool(nThreads);
+    vector<WorkerTally> tallies(pool.size());
+    vector<WorkerTable> tables(pool.size());
+    TranspositionTable table;
+    TournamentSpec spec = { type1, type2, nRows, nCols, addShips, seed, PlayerOptions() };
+      // The games already keep every worker busy, and a search by the
+      // clock would make the totals depend on the load
+    spec.players.threads = 1;
+    spec.players.playoutsPerMove = PLAYOUTSPERMOVE;
+    spec.players.table = &table;
+    PlayFn play = playFor(type1, type2);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (long long done = 0; done < nGames; )
+    {
+        long long batch = (nGames - done < MAXBATCH ? nGames - done : MAXBATCH);
+        pool.parallelFor(uint32_t(batch), GRAIN,
+            [&](int worker, uint32_t begin, uint32_t end)
+            {
+                for (uint32_t i = begin; i < end; i++)
+                    play(spec, done + i, tables[worker], tallies[worker]);
+            });
+        done += batch;
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+      // Merge in worker order so the totals don't depend on timing
+    TournamentResult result = TournamentResult();
+    for (size_t w = 0; w < tallies.size(); w++)
+    {
+        const WorkerTally& t = tallies[w];
+        result.games += t.games;
+        result.noResult += t.noResult;
+        result.turns += t.turns;
+        for (int i = 0; i < 2; i++)
+        {
+            result.wins[i] += t.wins[i];
+            result.shotsFired[i] += t.shotsFired[i];
+            result.hits[i] += t.hits[i];
+            result.wastedShots[i] += t.wastedShots[i];
+        }
+    }
+    result.seed = seed;
+    result.threads = pool.size();
+    result.seconds = elapsed.count();
+    return result;
+}
@@ -0,0 +1,50 @@
+#ifndef TOURNAMENT_INCLUDED
+#define TOURNAMENT_INCLUDED
+
+#include <string>
+#include <cstdint>
+
+class Game;
+
+  // Totals for a tournament.  Index 0 of each array is for the first player
+  // type passed to runTournament, index 1 for the second, no matter which of
+  // them moved first in a given game.
+struct TournamentResult
+{
+    long long games;
+    long long wins[2];
+    long long noResult;    // games in which a player couldn't place ships
+    long long turns;
+    long long shotsFired[2];
+    long long hits[2];
+    long long wastedShots[2];
+    uint64_t seed;
+    int threads;
+    double seconds;
+
+    double gamesPerSecond() const
+    {
+        return seconds > 0 ? games / seconds : 0;
+    }
+};
+
+  // Play nGames silent games between a player of type1 and a player of
+  // type2 on an nRows x nCols board whose fleet is set up by addShips,
+  // alternating which player moves first.  The games are spread over
+  // nThreads worker threads (nThreads <= 0 means one per hardware thread).
+  // Game k is played with the seed gameSeed(seed, k), so the totals depend
+  // only on the seed and not on the number of threads; a seed of 0 means
+  // pick a fresh one, which is reported in the result.  So that this holds
+  // for the players that search too, each of them searches on the worker
+  // that plays its game, for a fixed number of playouts a move rather
+  // than a fixed time.  All the players share one TranspositionTable, so
+  // what one of them works out is cached for the rest (see PlayerOptions).
+TournamentResult runTournament(std::string type1, std::string type2,
+                               int nRows, int nCols, bool (*addShips)(Game&),
+                               long long nGames, int nThreads = 0,
+                               uint64_t seed = 0);
+
+  // The seed of game k (counting from 0) of a tournament with that seed
+uint64_t gameSeed(uint64_t tournamentSeed, long long k);
+
+#endif // TOURNAMENT_INCLUDED
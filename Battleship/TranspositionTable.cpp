@@ -0,0 +1,22 @@
+#include "TranspositionTable.h"
+
+using namespace std;
+
+TranspositionTable::TranspositionTable(size_t nEntries)
+{
+    size_t n = 1;
+    while (n < nEntries)
+        n *= 2;
+    m_entries.reset(new Entry[n]);
+    m_mask = n - 1;
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i <= m_mask; i++)
+    {
+        m_entries[i].check.store(0, memory_order_relaxed);
+        m_entries[i].value.store(0, memory_order_relaxed);
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef TRANSPOSITIONTABLE_INCLUDED
+#define TRANSPOSITIONTABLE_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+  // A fixed-size cache of 64-bit values keyed by 64-bit hashes, such as
+  // Knowledge::hash, that any number of threads may probe and store into at
+  // once without locking.  Each key has one slot, chosen by its low bits,
+  // and a store always replaces what was there.  A slot holds the value
+  // and the key XORed with the value, each written with a single atomic
+  // store; a probe that reads the two halves of different stores sees a
+  // key that doesn't match and misses, so a torn entry is never returned.
+  // A value of 0 can't be stored, since it marks an empty slot.
+class TranspositionTable
+{
+  public:
+      // Room for at least nEntries entries, rounded up to a power of two
+    explicit TranspositionTable(std::size_t nEntries = std::size_t(1) << 16);
+    std::size_t size() const { return m_mask + 1; }
+
+      // Set value to what was stored for key; false if nothing was, or it
+      // has since been replaced
+    bool probe(uint64_t key, uint64_t& value) const
+    {
+        const Entry& e = m_entries[key & m_mask];
+        uint64_t v = e.value.load(std::memory_order_relaxed);
+        if (v == 0  ||  (e.check.load(std::memory_order_relaxed) ^ v) != key)
+            return false;
+        value = v;
+        return true;
+    }
+
+    void store(uint64_t key, uint64_t value)
+    {
+        Entry& e = m_entries[key & m_mask];
+        e.check.store(key ^ value, std::memory_order_relaxed);
+        e.value.store(value, std::memory_order_relaxed);
+    }
+
+      // Empty every slot; not to be called while other threads use the table
+    void clear();
+
+      // We prevent a TranspositionTable object from being copied or assigned
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+  private:
+    struct Entry
+    {
+        std::atomic<uint64_t> check;   //key ^ value
+        std::atomic<uint64_t> value;
+    };
+
+    std::unique_ptr<Entry[]> m_entries;
+    std::size_t m_mask;
+};
+
+#endif // TRANSPOSITIONTABLE_INCLUDED
@@ -0,0 +1,150 @@
+#include "WorkStealingPool.h"
+
+using namespace std;
+
+static uint64_t pack(uint32_t begin, uint32_t end)
+{
+    return (uint64_t(begin) << 32) | end;
+}
+
+static uint32_t beginOf(uint64_t bounds) { return uint32_t(bounds >> 32); }
+static uint32_t endOf(uint64_t bounds)   { return uint32_t(bounds); }
+
+WorkStealingPool::WorkStealingPool(int nThreads)
+ : m_generation(0), m_busy(0), m_stopping(false), m_task(nullptr), m_grain(1)
+{
+    if (nThreads <= 0)
+    {
+        nThreads = thread::hardware_concurrency();
+        if (nThreads <= 0)
+            nThreads = 1; //the count isn't always computable
+    }
+    m_nWorkers = nThreads;
+    m_slices = vector<Slice>(m_nWorkers);
+    for (int w = 0; w < m_nWorkers; w++)
+        m_slices[w].bounds.store(0);
+    for (int w = 1; w < m_nWorkers; w++)
+        m_threads.push_back(thread(&WorkStealingPool::workerLoop, this, w));
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (size_t i = 0; i < m_threads.size(); i++)
+        m_threads[i].join();
+}
+
+void WorkStealingPool::parallelFor(uint32_t n, uint32_t grain,
+                          const function<void(int, uint32_t, uint32_t)>& task)
+{
+    if (n == 0)
+        return;
+    if (grain == 0)
+        grain = 1;
+
+      // Deal the range out in equal slices before anyone starts
+    for (int w = 0; w < m_nWorkers; w++)
+    {
+        uint32_t begin = uint32_t(uint64_t(n) * w / m_nWorkers);
+        uint32_t end = uint32_t(uint64_t(n) * (w+1) / m_nWorkers);
+        m_slices[w].bounds.store(pack(begin, end), memory_order_relaxed);
+    }
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_task = &task;
+        m_grain = grain;
+        m_busy = m_nWorkers - 1;
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    runTasks(0); //the caller is worker 0
+
+    unique_lock<mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_task = nullptr;
+}
+
+void WorkStealingPool::workerLoop(int worker)
+{
+    unsigned long seen = 0;
+    for (;;)
+    {
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stopping || m_generation != seen; });
+            if (m_stopping)
+                return;
+            seen = m_generation;
+        }
+        runTasks(worker);
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_busy--;
+        }
+        m_done.notify_one();
+    }
+}
+
+void WorkStealingPool::runTasks(int worker)
+{
+    uint32_t begin;
+    uint32_t end;
+    for (;;)
+    {
+        while (claim(worker, begin, end))
+            (*m_task)(worker, begin, end);
+        if (!steal(worker))
+            return; //every slice is empty, so nothing is left to claim
+    }
+}
+
+  // Take up to m_grain tasks from the front of the worker's own slice
+bool WorkStealingPool::claim(int worker, uint32_t& begin, uint32_t& end)
+{
+    atomic<uint64_t>& bounds = m_slices[worker].bounds;
+    uint64_t old = bounds.load(memory_order_acquire);
+    for (;;)
+    {
+        uint32_t b = beginOf(old);
+        uint32_t e = endOf(old);
+        if (b >= e)
+            return false;
+        uint32_t mid = (e - b > m_grain ? b + m_grain : e);
+        if (bounds.compare_exchange_weak(old, pack(mid, e), memory_order_acq_rel))
+        {
+            begin = b;
+            end = mid;
+            return true;
+        }
+    }
+}
+
+  // Move the back half of some other worker's slice into the thief's own
+  // (empty) slice.  Returns false if every other slice was empty.
+bool WorkStealingPool::steal(int thief)
+{
+    for (int k = 1; k < m_nWorkers; k++)
+    {
+        atomic<uint64_t>& bounds = m_slices[(thief + k) % m_nWorkers].bounds;
+        uint64_t old = bounds.load(memory_order_acquire);
+        for (;;)
+        {
+            uint32_t b = beginOf(old);
+            uint32_t e = endOf(old);
+            if (b >= e)
+                break;
+            uint32_t mid = b + (e - b) / 2;
+            if (bounds.compare_exchange_weak(old, pack(b, mid), memory_order_acq_rel))
+            {
+                m_slices[thief].bounds.store(pack(mid, e), memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,64 @@
+#ifndef WORKSTEALINGPOOL_INCLUDED
+#define WORKSTEALINGPOOL_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+  // A fixed set of worker threads that split a range of task indices among
+  // themselves.  Each worker starts with an equal slice of the range and
+  // takes tasks from the front of its own slice; a worker whose slice runs
+  // dry steals the back half of another worker's slice.  The calling thread
+  // takes part as worker 0, so a pool of size 1 starts no threads at all.
+class WorkStealingPool
+{
+  public:
+      // nThreads <= 0 means one worker per hardware thread
+    explicit WorkStealingPool(int nThreads = 0);
+    ~WorkStealingPool();
+    int size() const { return m_nWorkers; }
+
+      // Call task(worker, begin, end) over disjoint ranges that together
+      // cover [0, n), each at most grain long, and return when all of them
+      // are done.  worker is in [0, size()) and no two ranges given to the
+      // same worker run concurrently, so per-worker state needs no locking.
+    void parallelFor(uint32_t n, uint32_t grain,
+                     const std::function<void(int, uint32_t, uint32_t)>& task);
+
+      // We prevent a WorkStealingPool object from being copied or assigned
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  private:
+      // A worker's unclaimed tasks [begin, end), packed as begin << 32 | end
+      // so the owner and thieves can both claim work with a single CAS.  One
+      // per cache line so that workers don't contend on each other's slices.
+    struct alignas(64) Slice
+    {
+        std::atomic<uint64_t> bounds;
+    };
+
+    int m_nWorkers;
+    std::vector<Slice> m_slices;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    unsigned long m_generation;
+    int m_busy;
+    bool m_stopping;
+    const std::function<void(int, uint32_t, uint32_t)>* m_task;
+    uint32_t m_grain;
+
+    void workerLoop(int worker);
+    void runTasks(int worker);
+    bool claim(int worker, uint32_t& begin, uint32_t& end);
+    bool steal(int thief);
+};
+
+#endif // WORKSTEALINGPOOL_INCLUDED
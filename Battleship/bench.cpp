@@ -0,0 +1,2087 @@
+#include "Game.h"
+#include "Board.h"
+#include "Player.h"
+#include "Players.h"
+#include "Match.h"
+#include "MoveClock.h"
+#include "globals.h"
+#include "FleetPlacer.h"
+#include "Replay.h"
+#include "Tournament.h"
+#include "MatchServer.h"
+#include "MatchClient.h"
+#include "AsyncMatch.h"
+#include "Lockstep.h"
+#include "Knowledge.h"
+#include "TranspositionTable.h"
+#include "EndgameSolver.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+// Usage: bench [--quick] [--json file] [filter ...]
+//
+// Runs every case whose name contains one of the filters (all of them if
+// there are none).  Each case is run a few times unmeasured to warm caches
+// and branch predictors, then timed over several repetitions; the report
+// gives the mean cost per operation with a 95% confidence interval.  A
+// human-readable line per case goes to stderr and the whole report goes to
+// stdout (or the --json file) as JSON.  Every game is seeded, so runs are
+// repeatable.  --quick cuts the repetitions for a fast smoke test.
+//
+// Some cases also check that what they ran behaved: that replays and the
+// typed match loop agree with Game::simulate, that matches played with a
+// replay file set are recorded there, that knowledge hashes don't
+// depend on the order of the shots and a shared table never returns another
+// key's value, that the endgame solver answers consistently, that the tree
+// search stays within its node cap, that a board answers the same after
+// shots are taken back and that a copy of it answers alike, that a
+// tournament's games allocate nothing once its workers are going and its
+// totals don't depend on how many there are, that every match on the local
+// match server runs to its end, and that searching players held to a move
+// time limit keep to it and stop when a move is called off.  The tree
+// search is also timed with one worker thread up to one per hardware
+// thread.
+// A build with C++20 coroutines also times the coroutine match loop and
+// checks it against the typed one.  Any failure is reported on stderr and
+// makes the exit status 1.
+
+//******************** Measurement ************************************
+
+struct BenchResult
+{
+    string name;
+    int rows;
+    int cols;
+    int ships;
+    int reps;
+    long long opsPerRep;        //mean over the repetitions
+    double mean;                //ns per operation
+    double ci95;                //half-width of the 95% confidence interval
+    double stddev;
+    double min;
+    double median;
+    vector<double> profile;     //case-specific breakdown, may be empty
+};
+
+struct BenchOptions
+{
+    bool quick = false;
+    vector<string> filters;
+};
+
+static BenchOptions g_options;
+static vector<BenchResult> g_results;
+static int g_failures = 0;
+
+//******************** Allocation counting ****************************
+
+  // Every allocation made through operator new, in the whole program,
+  // counts here, by form.  Every form is replaced, nothrow ones included,
+  // so that none can go around the count, and each has its delete.
+enum AllocationForm { PLAINNEW, ARRAYNEW, ALIGNEDNEW, ALIGNEDARRAYNEW, NALLOCATIONFORMS };
+static const char* const ALLOCATIONFORMNAMES[NALLOCATIONFORMS] = {
+    "new", "new[]", "aligned new", "aligned new[]"
+};
+static atomic<long long> g_allocations[NALLOCATIONFORMS];
+
+  // Null if there is no room
+static void* allocate(size_t size, size_t alignment, AllocationForm form) noexcept
+{
+    g_allocations[form].fetch_add(1, memory_order_relaxed);
+    if (size == 0)
+        size = 1;
+    if (alignment <= alignof(max_align_t))
+        return malloc(size);
+    void* p;
+    return posix_memalign(&p, alignment, size) == 0 ? p : nullptr;
+}
+
+static void* allocateOrThrow(size_t size, size_t alignment, AllocationForm form)
+{
+    void* p = allocate(size, alignment, form);
+    if (p == nullptr)
+        throw bad_alloc();
+    return p;
+}
+
+  // Out of line, so the compiler never sees free meet a pointer from new
+__attribute__((noinline)) static void release(void* p) noexcept
+{
+    free(p);
+}
+
+void* operator new(size_t size)
+{
+    return allocateOrThrow(size, 0, PLAINNEW);
+}
+
+void* operator new[](size_t size)
+{
+    return allocateOrThrow(size, 0, ARRAYNEW);
+}
+
+void* operator new(size_t size, align_val_t alignment)
+{
+    return allocateOrThrow(size, size_t(alignment), ALIGNEDNEW);
+}
+
+void* operator new[](size_t size, align_val_t alignment)
+{
+    return allocateOrThrow(size, size_t(alignment), ALIGNEDARRAYNEW);
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept
+{
+    return allocate(size, 0, PLAINNEW);
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept
+{
+    return allocate(size, 0, ARRAYNEW);
+}
+
+void* operator new(size_t size, align_val_t alignment, const nothrow_t&) noexcept
+{
+    return allocate(size, size_t(alignment), ALIGNEDNEW);
+}
+
+void* operator new[](size_t size, align_val_t alignment, const nothrow_t&) noexcept
+{
+    return allocate(size, size_t(alignment), ALIGNEDARRAYNEW);
+}
+
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, size_t) noexcept { release(p); }
+void operator delete[](void* p, size_t) noexcept { release(p); }
+void operator delete(void* p, align_val_t) noexcept { release(p); }
+void operator delete[](void* p, align_val_t) noexcept { release(p); }
+void operator delete(void* p, size_t, align_val_t) noexcept { release(p); }
+void operator delete[](void* p, size_t, align_val_t) noexcept { release(p); }
+void operator delete(void* p, const nothrow_t&) noexcept { release(p); }
+void operator delete[](void* p, const nothrow_t&) noexcept { release(p); }
+void operator delete(void* p, align_val_t, const nothrow_t&) noexcept { release(p); }
+void operator delete[](void* p, align_val_t, const nothrow_t&) noexcept { release(p); }
+
+  // Two-sided 95% Student t quantiles for 1 to 30 degrees of freedom
+static double tQuantile(int df)
+{
+    static const double T[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (df < 1)
+        return 0;
+    return df <= 30 ? T[df-1] : 1.96;
+}
+
+static bool selected(const string& name)
+{
+    if (g_options.filters.empty())
+        return true;
+    for (size_t i = 0; i < g_options.filters.size(); i++)
+        if (name.find(g_options.filters[i]) != string::npos)
+            return true;
+    return false;
+}
+
+  // Run rep() warmups times untimed and then reps times timed; each call
+  // returns how many operations it performed.  The result is recorded and
+  // returned so a case can attach a profile; the pointer is good until the
+  // next call.
+template <typename F>
+static BenchResult* measure(const string& name, int rows, int cols, int ships,
+                            int warmups, int reps, F rep)
+{
+    if (!selected(name))
+        return nullptr;
+    if (g_options.quick)
+    {
+        warmups = min(warmups, 1);
+        reps = min(reps, 3);
+    }
+    for (int i = 0; i < warmups; i++)
+        rep();
+
+    vector<double> nsPerOp;
+    long long totalOps = 0;
+    for (int i = 0; i < reps; i++)
+    {
+        Clock::time_point start = Clock::now();
+        long long ops = rep();
+        double ns = chrono::duration<double, nano>(Clock::now() - start).count();
+        nsPerOp.push_back(ns / max(ops, 1LL));
+        totalOps += ops;
+    }
+
+    BenchResult r;
+    r.name = name;
+    r.rows = rows;
+    r.cols = cols;
+    r.ships = ships;
+    r.reps = reps;
+    r.opsPerRep = totalOps / reps;
+    double sum = 0;
+    for (size_t i = 0; i < nsPerOp.size(); i++)
+        sum += nsPerOp[i];
+    r.mean = sum / reps;
+    double ss = 0;
+    for (size_t i = 0; i < nsPerOp.size(); i++)
+        ss += (nsPerOp[i] - r.mean) * (nsPerOp[i] - r.mean);
+    r.stddev = (reps > 1 ? sqrt(ss / (reps - 1)) : 0);
+    r.ci95 = tQuantile(reps - 1) * r.stddev / sqrt(double(reps));
+    sort(nsPerOp.begin(), nsPerOp.end());
+    r.min = nsPerOp.front();
+    r.median = (reps % 2 == 1 ? nsPerOp[reps/2] : (nsPerOp[reps/2-1] + nsPerOp[reps/2]) / 2);
+
+    fprintf(stderr, "%-44s %4dx%-4d %3d ships %12.1f ns/op  +/- %.1f (%d reps x %lld ops)\n",
+            name.c_str(), rows, cols, ships, r.mean, r.ci95, reps, r.opsPerRep);
+    g_results.push_back(r);
+    return &g_results.back();
+}
+
+static string jsonString(const string& s)
+{
+    string out = "\"";
+    for (size_t i = 0; i < s.size(); i++)
+    {
+        if (s[i] == '"'  ||  s[i] == '\\')
+            out += '\\';
+        out += s[i];
+    }
+    return out + "\"";
+}
+
+static void writeJson(ostream& out)
+{
+    out << "{\n  \"suite\": \"battleship\",\n  \"timestamp\": " << long(time(nullptr))
+        << ",\n  \"quick\": " << (g_options.quick ? "true" : "false")
+        << ",\n  \"unit\": \"ns/op\",\n  \"results\": [";
+    for (size_t i = 0; i < g_results.size(); i++)
+    {
+        const BenchResult& r = g_results[i];
+        out << (i == 0 ? "\n" : ",\n")
+            << "    {\"name\": " << jsonString(r.name)
+            << ", \"rows\": " << r.rows << ", \"cols\": " << r.cols
+            << ", \"ships\": " << r.ships << ", \"reps\": " << r.reps
+            << ", \"opsPerRep\": " << r.opsPerRep
+            << ", \"mean\": " << r.mean << ", \"ci95\": " << r.ci95
+            << ", \"stddev\": " << r.stddev << ", \"min\": " << r.min
+            << ", \"median\": " << r.median;
+        if (!r.profile.empty())
+        {
+            out << ", \"profile\": [";
+            for (size_t k = 0; k < r.profile.size(); k++)
+                out << (k == 0 ? "" : ", ") << r.profile[k];
+            out << "]";
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+//******************** Fixtures ***************************************
+
+  // Add nShips ships of lengths 2 through 6 in turn, each with its own
+  // printable symbol
+static bool addFleet(Game& g, int nShips)
+{
+    string symbols;
+    for (char ch = '!'; ch <= '~'; ch++)
+        if (ch != 'X'  &&  ch != '.'  &&  ch != 'o')
+            symbols += ch;
+    for (int i = 0; i < nShips; i++)
+        if (i >= int(symbols.size())  ||
+            !g.addShip(2 + i % 5, symbols[i], string("ship ") + symbols[i]))
+            return false;
+    return true;
+}
+
+struct Config
+{
+    int size;
+    int ships;
+};
+
+  // Board sizes and fleets: the first two use the compile-time sized board,
+  // the others the run-time sized one
+static const Config BOARDS[] = { { 10, 5 }, { 10, 8 }, { 100, 50 }, { 1000, 80 } };
+  // Players are too slow to play out games on the largest board in a
+  // benchmark run
+static const Config PLAYERBOARDS[] = { { 10, 5 }, { 10, 8 }, { 100, 50 } };
+
+static const char* const PLAYERTYPES[] = { "awful", "mediocre", "good", "montecarlo", "mcts" };
+
+  // MonteCarloPlayer and MctsPlayer spend a fixed time budget on each move,
+  // on a pool of threads
+static bool searches(const string& type)
+{
+    return type == "montecarlo"  ||  type == "mcts";
+}
+
+  // Only the standard board is worth timing for a player that searches
+static bool playerRunsOn(const string& type, const Config& c)
+{
+    return !searches(type)  ||  c.size == 10;
+}
+
+static string caseName(const string& what, const Config& c)
+{
+    ostringstream s;
+    s << what << "/" << c.size << "x" << c.size << "/" << c.ships;
+    return s.str();
+}
+
+//******************** Board cases ************************************
+
+static void benchBoard(const Config& c)
+{
+    Game g(c.size, c.size, 1);
+    addFleet(g, c.ships);
+    FleetPlacer placer(g);
+    RandomEngine rng(2);
+    Board b(g);
+
+      // A few layouts to cycle through, so the branches don't settle on one
+    const int NLAYOUTS = 16;
+    vector<vector<FleetPlacer::Placement> > layouts;
+    for (int i = 0; i < NLAYOUTS; i++)
+    {
+        placer.draw(rng);
+        layouts.push_back(placer.fleet());
+    }
+    int next = 0;
+
+    measure(caseName("board.placeShip+unplaceShip", c), c.size, c.size, c.ships, 3, 15, [&]() {
+        long long ops = 0;
+        for (int k = 0; k < 200; k++)
+        {
+            const vector<FleetPlacer::Placement>& fleet = layouts[next++ % NLAYOUTS];
+            for (size_t i = 0; i < fleet.size(); i++)
+                b.placeShip(fleet[i].topOrLeft, fleet[i].shipId, fleet[i].dir);
+            for (size_t i = 0; i < fleet.size(); i++)
+                b.unplaceShip(fleet[i].topOrLeft, fleet[i].shipId, fleet[i].dir);
+            ops += 2 * fleet.size();
+        }
+        return ops;
+    });
+
+      // Every cell in a random order, or on a large board the first 20000
+    int nCells = c.size * c.size;
+    vector<Point> order;
+    for (int r = 0; r < c.size; r++)
+        for (int col = 0; col < c.size; col++)
+            order.push_back(Point(r, col));
+    for (int i = nCells - 1; i > 0; i--)
+        swap(order[i], order[rng.nextInt(i + 1)]);
+    int nShots = min(nCells, 20000);
+
+    measure(caseName("board.attack", c), c.size, c.size, c.ships, 3, 15, [&]() {
+        b.clear();
+        const vector<FleetPlacer::Placement>& fleet = layouts[next++ % NLAYOUTS];
+        for (size_t i = 0; i < fleet.size(); i++)
+            b.placeShip(fleet[i].topOrLeft, fleet[i].shipId, fleet[i].dir);
+        bool shotHit;
+        bool shipDestroyed;
+        int shipId;
+        for (int i = 0; i < nShots; i++)
+            b.attack(order[i], shotHit, shipDestroyed, shipId);
+        return (long long) nShots;
+    });
+
+    b.clear();
+    const vector<FleetPlacer::Placement>& fleet = layouts[0];
+    for (size_t i = 0; i < fleet.size(); i++)
+        b.placeShip(fleet[i].topOrLeft, fleet[i].shipId, fleet[i].dir);
+
+      // A search's make and unmake: every shot taken back must leave the
+      // board answering the same shots the same way, and a copy of a board
+      // part way through a game must answer as the board does
+    int nSearch = min(nCells, 64);
+    int bad = 0;
+    Board copy(g);
+    for (int round = 0; round < 2; round++)
+    {
+        vector<int> answers;
+        for (int i = 0; i < nShots; i++)
+        {
+            bool shotHit;
+            bool shipDestroyed;
+            int shipId;
+            bool valid = b.attack(order[i], shotHit, shipDestroyed, shipId);
+            answers.push_back(valid + 2 * shotHit + 4 * shipDestroyed + 8 * (shipId + 1));
+            if (i == nShots / 2)
+                copy.copyFrom(b);
+        }
+        if (nShots == nCells  &&  !b.allShipsDestroyed())
+            bad++;
+        for (int i = nShots - 1; i >= 0; i--)
+            if (!b.unattack(order[i]))
+                bad++;
+        if (b.allShipsDestroyed()  ||  b.unattack(order[0]))
+            bad++;
+        for (int i = nShots / 2 + 1; i < nShots; i++)
+        {
+            bool shotHit;
+            bool shipDestroyed;
+            int shipId;
+            bool valid = copy.attack(order[i], shotHit, shipDestroyed, shipId);
+            if (answers[i] != valid + 2 * shotHit + 4 * shipDestroyed + 8 * (shipId + 1))
+                bad++;
+        }
+    }
+    if (bad > 0)
+    {
+        fprintf(stderr, "%s: %d wrong answers after unattack or copyFrom\n",
+                caseName("board", c).c_str(), bad);
+        g_failures++;
+    }
+
+      // Returning to a saved position: after a ship has been moved, another
+      // taken up and put back where it was, and more shots fired, copying
+      // the saved board back must leave every placement and every shot
+      // answered as on a board built from scratch in the saved position
+    bad = 0;
+    int nSaved = nShots / 4;
+    for (int i = 0; i < nSaved; i++)
+    {
+        bool shotHit;
+        bool shipDestroyed;
+        int shipId;
+        b.attack(order[i], shotHit, shipDestroyed, shipId);
+    }
+    copy.copyFrom(b);
+    int moving = fleet.front().shipId;
+    b.unplaceShip(fleet.front().topOrLeft, moving, fleet.front().dir);
+    bool moved = false;
+    for (int i = 0; i < nCells  &&  !moved; i++)
+    {
+        Point p(i / c.size, i % c.size);
+        if (p.r == fleet.front().topOrLeft.r  &&  p.c == fleet.front().topOrLeft.c)
+            continue;
+        moved = b.placeShip(p, moving, HORIZONTAL)  ||  b.placeShip(p, moving, VERTICAL);
+    }
+    const FleetPlacer::Placement& same = fleet.back();
+    if (!moved  ||  !b.unplaceShip(same.topOrLeft, same.shipId, same.dir)  ||
+        !b.placeShip(same.topOrLeft, same.shipId, same.dir))
+        bad++;
+    for (int i = nSaved; i < nShots; i++)
+    {
+        bool shotHit;
+        bool shipDestroyed;
+        int shipId;
+        b.attack(order[i], shotHit, shipDestroyed, shipId);
+    }
+    b.copyFrom(copy);
+    Board fresh(g);
+    for (size_t i = 0; i < fleet.size(); i++)
+        fresh.placeShip(fleet[i].topOrLeft, fleet[i].shipId, fleet[i].dir);
+    for (int i = 0; i < nSaved; i++)
+    {
+        bool shotHit;
+        bool shipDestroyed;
+        int shipId;
+        fresh.attack(order[i], shotHit, shipDestroyed, shipId);
+    }
+    for (int k = -1; k <= g.nShips(); k++)
+    {
+        Point p1(-1, -1);
+        Point p2(-1, -1);
+        Direction d1 = HORIZONTAL;
+        Direction d2 = HORIZONTAL;
+        bool on1 = b.shipPlacement(k, p1, d1);
+        bool on2 = fresh.shipPlacement(k, p2, d2);
+        if (on1 != on2  ||  (on1  &&  (p1.r != p2.r  ||  p1.c != p2.c  ||  d1 != d2)))
+            bad++;
+    }
+    for (int i = 0; i < nShots; i++)
+    {
+        bool hit1;
+        bool hit2;
+        bool sunk1;
+        bool sunk2;
+        int id1;
+        int id2;
+        bool valid1 = b.attack(order[i], hit1, sunk1, id1);
+        bool valid2 = fresh.attack(order[i], hit2, sunk2, id2);
+        if (valid1 != valid2  ||  hit1 != hit2  ||  sunk1 != sunk2  ||  id1 != id2  ||
+            b.allShipsDestroyed() != fresh.allShipsDestroyed())
+            bad++;
+    }
+    if (bad > 0)
+    {
+        fprintf(stderr, "%s: %d wrong answers after returning to a saved position\n",
+                caseName("board", c).c_str(), bad);
+        g_failures++;
+    }
+    b.clear();
+    for (size_t i = 0; i < fleet.size(); i++)
+        b.placeShip(fleet[i].topOrLeft, fleet[i].shipId, fleet[i].dir);
+
+    measure(caseName("board.attack+unattack", c), c.size, c.size, c.ships, 3, 15, [&]() {
+        long long ops = 0;
+        bool shotHit;
+        bool shipDestroyed;
+        int shipId;
+        for (int k = 0; k < 200; k++)
+        {
+            for (int i = 0; i < nSearch; i++)
+                b.attack(order[i], shotHit, shipDestroyed, shipId);
+            for (int i = nSearch - 1; i >= 0; i--)
+                b.unattack(order[i]);
+            ops += 2 * nSearch;
+        }
+        return ops;
+    });
+
+    for (int i = 0; i < nSearch / 2; i++)
+    {
+        bool shotHit;
+        bool shipDestroyed;
+        int shipId;
+        b.attack(order[i], shotHit, shipDestroyed, shipId);
+    }
+    measure(caseName("board.copyFrom", c), c.size, c.size, c.ships, 3, 15, [&]() {
+        const int N = max(100, 20000000 / nCells);
+        for (int i = 0; i < N; i++)
+            copy.copyFrom(b);
+        return (long long) N;
+    });
+    for (int i = nSearch / 2 - 1; i >= 0; i--)
+        b.unattack(order[i]);
+
+    measure(caseName("board.allShipsDestroyed", c), c.size, c.size, c.ships, 3, 15, [&]() {
+        const int N = 1000000;
+        const Board& cb = b;
+        int destroyed = 0;
+        for (int i = 0; i < N; i++)
+            destroyed += cb.allShipsDestroyed();
+        asm volatile("" : : "r"(destroyed)); //keep the loop
+        return (long long) N;
+    });
+
+    int nDraws = (c.size >= 100 ? 1000 : 20000);
+    measure(caseName("fleetPlacer.uniform", c), c.size, c.size, c.ships, 3, 15, [&]() {
+        for (int i = 0; i < nDraws; i++)
+            placer.draw(rng, FleetPlacer::UNIFORM);
+        return (long long) nDraws;
+    });
+    measure(caseName("fleetPlacer.apart", c), c.size, c.size, c.ships, 3, 15, [&]() {
+        for (int i = 0; i < nDraws; i++)
+            placer.draw(rng, FleetPlacer::APART);
+        return (long long) nDraws;
+    });
+}
+
+//******************** Player cases ***********************************
+
+static void benchPlayer(const string& type, const Config& c)
+{
+    Game g(c.size, c.size, 3);
+    addFleet(g, c.ships);
+    Board b(g);
+
+    Player* p = createPlayer(type, type, g);
+    int nPlacements = (c.size >= 100 ? 50 : 1000);
+    measure(caseName(type + ".placeShips", c), c.size, c.size, c.ships, 2, 15, [&]() {
+        for (int i = 0; i < nPlacements; i++)
+        {
+            b.clear();
+            p->placeShips(b);
+        }
+        return (long long) nPlacements;
+    });
+    delete p;
+
+      // A move is recommendAttack plus recording its result, against a
+      // fleet the player can't see.  The profile gives the mean cost for
+      // each tenth of the game, so any growth in per-move cost as the game
+      // goes on shows up.
+    const int NBUCKETS = 10;
+    vector<double> bucketNs(NBUCKETS, 0);
+    vector<long long> bucketMoves(NBUCKETS, 0);
+    bool slow = searches(type);
+    int gamesPerRep = (slow ? 1 : c.size >= 100 ? 2 : 50);
+    int gameNo = 0;
+    Player* placer = createPlayer("mediocre", "placer", g);
+    BenchResult* r = measure(caseName(type + ".recommendAttack+record", c),
+                             c.size, c.size, c.ships, 1, (slow ? 3 : 10), [&]() {
+        long long moves = 0;
+        vector<double> ns;
+        for (int k = 0; k < gamesPerRep; k++)
+        {
+            Game game(c.size, c.size, 1000 + gameNo++);
+            addFleet(game, c.ships);
+            Board target(game);
+            placer->placeShips(target);
+            Player* attacker = createPlayer(type, type, game);
+            ns.clear();
+            while (!target.allShipsDestroyed())
+            {
+                bool shotHit;
+                bool shipDestroyed;
+                int shipId;
+                Clock::time_point start = Clock::now();
+                Point t = attacker->recommendAttack();
+                if (target.attack(t, shotHit, shipDestroyed, shipId))
+                    attacker->recordAttackResult(t, true, shotHit, shipDestroyed, shipId);
+                ns.push_back(chrono::duration<double, nano>(Clock::now() - start).count());
+            }
+            for (size_t i = 0; i < ns.size(); i++)
+            {
+                int bucket = int(i * NBUCKETS / ns.size());
+                bucketNs[bucket] += ns[i];
+                bucketMoves[bucket]++;
+            }
+            moves += ns.size();
+            delete attacker;
+        }
+        return moves;
+    });
+    delete placer;
+    if (r != nullptr)
+        for (int i = 0; i < NBUCKETS; i++)
+            r->profile.push_back(bucketMoves[i] == 0 ? 0 : bucketNs[i] / bucketMoves[i]);
+}
+
+//******************** Game cases *************************************
+
+  // Whole matches between two player types on the standard board, taking
+  // turns at moving first.  Game::simulate runs the same match loop as
+  // Game::play, without the console output.
+static void benchMatch(const string& type1, const string& type2)
+{
+    Config c = { 10, 5 };
+    bool slow = (searches(type1)  ||  searches(type2));
+    int gamesPerRep = (slow ? 1 : 200);
+    int gameNo = 0;
+    measure(caseName("game.simulate." + type1 + "-vs-" + type2, c), c.size, c.size, c.ships,
+            1, (slow ? 3 : 10), [&]() {
+        for (int k = 0; k < gamesPerRep; k++)
+        {
+            Game g(c.size, c.size, 5000 + gameNo);
+            addFleet(g, c.ships);
+            Player* p1 = createPlayer(type1, type1, g);
+            Player* p2 = createPlayer(type2, type2, g);
+            if (gameNo++ % 2 == 0)
+                g.simulate(p1, p2);
+            else
+                g.simulate(p2, p1);
+            delete p1;
+            delete p2;
+        }
+        return (long long) gamesPerRep;
+    });
+}
+
+  // The same matches as benchMatch, through runMatch instantiated for the
+  // two concrete classes, so the gain from calling the players directly
+  // can be read off against the game.simulate case of the same pair.  Any
+  // game whose result differs from Game::simulate's is reported.
+template <class T1, class T2>
+static void benchTypedMatch(const string& type1, const string& type2)
+{
+    Config c = { 10, 5 };
+    const int gamesPerRep = 200;
+    int gameNo = 0;
+    int differ = 0;
+    measure(caseName("game.typed." + type1 + "-vs-" + type2, c), c.size, c.size, c.ships,
+            1, 10, [&]() {
+        for (int k = 0; k < gamesPerRep; k++)
+        {
+            Game g(c.size, c.size, 5000 + gameNo);
+            addFleet(g, c.ships);
+            T1 p1(type1, g);
+            T2 p2(type2, g);
+            if (gameNo++ % 2 == 0)
+                simulateMatch(g, p1, p2);
+            else
+                simulateMatch(g, p2, p1);
+        }
+        return (long long) gamesPerRep;
+    });
+    if (!selected(caseName("game.typed." + type1 + "-vs-" + type2, c)))
+        return;
+    for (int k = 0; k < 100; k++)
+    {
+        Game g1(c.size, c.size, 7000 + k);
+        addFleet(g1, c.ships);
+        Player* v1 = createPlayer(type1, type1, g1);
+        Player* v2 = createPlayer(type2, type2, g1);
+        MatchResult virt = g1.simulate(v1, v2);
+        Game g2(c.size, c.size, 7000 + k);
+        addFleet(g2, c.ships);
+        T1 p1(type1, g2);
+        T2 p2(type2, g2);
+        MatchResult typed = simulateMatch(g2, p1, p2);
+        if ((virt.winner == v1) != (typed.winner == &p1)  ||  virt.turns != typed.turns  ||
+            virt.shotsFired[1] != typed.shotsFired[1]  ||  virt.hits[0] != typed.hits[0])
+            differ++;
+        delete v1;
+        delete v2;
+    }
+    if (differ > 0)
+    {
+        fprintf(stderr, "%d of 100 typed matches differ from Game::simulate\n", differ);
+        g_failures++;
+    }
+}
+
+  // The same matches as benchMatch, through Game::simulate with an
+  // observer that ignores everything, so that every move goes through the
+  // move clock; set against game.simulate of the same pair for its cost.
+  // The clock only watches players this quick, so the results must be the
+  // same as Game::simulate's.
+static void benchTimedMatch(const string& type1, const string& type2)
+{
+    Config c = { 10, 5 };
+    string name = caseName("game.timed." + type1 + "-vs-" + type2, c);
+    const int gamesPerRep = 200;
+    int gameNo = 0;
+    NullObserver none;
+    measure(name, c.size, c.size, c.ships, 1, 10, [&]() {
+        for (int k = 0; k < gamesPerRep; k++)
+        {
+            Game g(c.size, c.size, 5000 + gameNo);
+            addFleet(g, c.ships);
+            Player* p1 = createPlayer(type1, type1, g);
+            Player* p2 = createPlayer(type2, type2, g);
+            if (gameNo++ % 2 == 0)
+                g.simulate(p1, p2, none);
+            else
+                g.simulate(p2, p1, none);
+            delete p1;
+            delete p2;
+        }
+        return (long long) gamesPerRep;
+    });
+    if (!selected(name))
+        return;
+    int differ = 0;
+    for (int k = 0; k < 100; k++)
+    {
+        MatchResult r[2];
+        for (int timed = 0; timed < 2; timed++)
+        {
+            Game g(c.size, c.size, 7000 + k);
+            addFleet(g, c.ships);
+            Player* p1 = createPlayer(type1, type1, g);
+            Player* p2 = createPlayer(type2, type2, g);
+            r[timed] = (timed ? g.simulate(p1, p2, none) : g.simulate(p1, p2));
+            r[timed].winner = (r[timed].winner == p1 ? nullptr : p2);
+            delete p1;
+            delete p2;
+        }
+        if ((r[0].winner == nullptr) != (r[1].winner == nullptr)  ||  r[0].turns != r[1].turns  ||
+            r[0].shotsFired[1] != r[1].shotsFired[1]  ||  r[0].hits[0] != r[1].hits[0])
+            differ++;
+    }
+    if (differ > 0)
+    {
+        fprintf(stderr, "%d of 100 timed matches differ from Game::simulate\n", differ);
+        g_failures++;
+    }
+}
+
+  // A player that thinks until its move is called off, ignoring its
+  // deadline, though it gives up after a second
+class StallPlayer final : public Player
+{
+  public:
+    explicit StallPlayer(const Game& g) : Player("stall", g) {}
+    virtual bool placeShips(Board&) { return false; }
+    virtual Point recommendAttack() { return Point(0, 0); }
+    virtual Point recommendAttackBy(Deadline, const CancelToken& cancel)
+    {
+        Clock::time_point giveUp = Clock::now() + chrono::seconds(1);
+        while (!cancel.cancelled()  &&  Clock::now() < giveUp)
+            this_thread::yield();
+        return Point(0, 0);
+    }
+    virtual bool isCancellable() const { return true; }
+    virtual void recordAttackResult(Point, bool, bool, bool, int) {}
+    virtual void recordAttackByOpponent(Point) {}
+    virtual void reset() {}
+};
+
+  // A match between the two searching players with a move time limit
+  // below their own budgets, reporting the latencies of each.  Their median
+  // move must come in under the limit, and every overrun must have cost a
+  // wasted shot.  A search whose move is called off before it starts must
+  // still answer at once with a cell on the board.  MoveClock must call
+  // off a move that ignores its deadline once it passes, and forfeit it,
+  // and must keep a move called off after its turn starts called off.
+static void benchDeadlines()
+{
+    Config c = { 10, 5 };
+    string name = caseName("game.deadline.montecarlo-vs-mcts", c);
+    if (!selected(name))
+        return;
+    const int LIMITMS = 2;
+    Game g(c.size, c.size, 31);
+    addFleet(g, c.ships);
+    g.setMoveTimeLimit(LIMITMS);
+    Player* players[2] = { createPlayer("montecarlo", "montecarlo", g),
+                           createPlayer("mcts", "mcts", g) };
+    NullObserver none;
+    MatchResult result = g.simulate(players[0], players[1], none);
+    for (int who = 0; who < 2; who++)
+    {
+        MoveLatency l = g.moveLatency(who);
+        fprintf(stderr, "%s: %s made %d moves, p50 %.2f ms, p99 %.2f ms, max %.2f ms, %d over %d ms\n",
+                name.c_str(), players[who]->name().c_str(), l.moves, l.p50Ms, l.p99Ms, l.maxMs,
+                l.overruns, LIMITMS);
+        if (l.moves == 0  ||  l.p50Ms > LIMITMS)
+        {
+            fprintf(stderr, "%s: %s doesn't keep to its deadline\n", name.c_str(),
+                    players[who]->name().c_str());
+            g_failures++;
+        }
+        if (result.wastedShots[who] != l.overruns)
+        {
+            fprintf(stderr, "%s: %s overran %d times but wasted %d shots\n", name.c_str(),
+                    players[who]->name().c_str(), l.overruns, result.wastedShots[who]);
+            g_failures++;
+        }
+        delete players[who];
+    }
+
+    StallPlayer stall(g);
+    MoveClock clock(LIMITMS, 2);
+    Point target;
+    clock.cancelMove(); //before the turn, so forgotten
+    clock.startTurn();
+    Clock::time_point stallStart = Clock::now();
+    bool inTime = clock.recommend(&stall, 0, target);
+    double stallMs = chrono::duration<double, milli>(Clock::now() - stallStart).count();
+    if (inTime  ||  stallMs < LIMITMS  ||  stallMs > 100  ||  clock.latency(0).overruns != 1)
+    {
+        fprintf(stderr, "%s: a move ignoring its deadline took %.1f ms and was %s\n", name.c_str(),
+                stallMs, (inTime ? "kept" : "forfeited"));
+        g_failures++;
+    }
+    clock.startTurn();
+    clock.cancelMove();
+    if (!clock.recommend(&stall, 1, target)  ||  clock.latency(1).overruns != 0)
+    {
+        fprintf(stderr, "%s: a move called off after its turn started was not cut short\n",
+                name.c_str());
+        g_failures++;
+    }
+
+    MctsPlayer slow("mcts", g, 1, 1000);
+    CancelToken cancel;
+    cancel.cancel();
+    Clock::time_point start = Clock::now();
+    Point p = slow.recommendAttackBy(Player::Deadline::max(), cancel);
+    double ms = chrono::duration<double, milli>(Clock::now() - start).count();
+    if (!g.isValid(p)  ||  ms > 100)
+    {
+        fprintf(stderr, "%s: a called-off move took %.1f ms\n", name.c_str(), ms);
+        g_failures++;
+    }
+}
+
+//******************** Coroutine cases ********************************
+
+#if BATTLESHIP_COROUTINES
+
+  // benchTypedMatch's matches through runMatchAsync, each run with runNow.
+  // Ordinary players never suspend it, so against the game.typed case of
+  // the same pair this shows what the coroutine costs.  Any match whose
+  // result differs from simulateMatch's is reported.
+template <class T1, class T2>
+static void benchAsyncMatch(const string& type1, const string& type2)
+{
+    Config c = { 10, 5 };
+    string name = caseName("game.async." + type1 + "-vs-" + type2, c);
+    if (!selected(name))
+        return;
+    const int gamesPerRep = 200;
+    int gameNo = 0;
+    NullObserver none;
+    measure(name, c.size, c.size, c.ships, 1, 10, [&]() {
+        for (int k = 0; k < gamesPerRep; k++)
+        {
+            Game g(c.size, c.size, 5000 + gameNo);
+            addFleet(g, c.ships);
+            T1 p1(type1, g);
+            T2 p2(type2, g);
+            Board b1(g);
+            Board b2(g);
+            MatchResult result = { nullptr, 0, { 0, 0 }, { 0, 0 }, { 0, 0 } };
+            if (gameNo++ % 2 == 0)
+                runMatchAsync(g, &p1, &p2, b1, b2, none, result).runNow();
+            else
+                runMatchAsync(g, &p2, &p1, b1, b2, none, result).runNow();
+        }
+        return (long long) gamesPerRep;
+    });
+    int differ = 0;
+    for (int k = 0; k < 100; k++)
+    {
+        Game g1(c.size, c.size, 7000 + k);
+        addFleet(g1, c.ships);
+        T1 t1(type1, g1);
+        T2 t2(type2, g1);
+        MatchResult typed = simulateMatch(g1, t1, t2);
+        Game g2(c.size, c.size, 7000 + k);
+        addFleet(g2, c.ships);
+        T1 a1(type1, g2);
+        T2 a2(type2, g2);
+        Board b1(g2);
+        Board b2(g2);
+        MatchResult async = { nullptr, 0, { 0, 0 }, { 0, 0 }, { 0, 0 } };
+        if (!runMatchAsync(g2, &a1, &a2, b1, b2, none, async).runNow()  ||
+            (typed.winner == &t1) != (async.winner == &a1)  ||  typed.turns != async.turns  ||
+            typed.shotsFired[1] != async.shotsFired[1]  ||  typed.hits[0] != async.hits[0])
+            differ++;
+    }
+    if (differ > 0)
+    {
+        fprintf(stderr, "%d of 100 coroutine matches differ from the typed ones\n", differ);
+        g_failures++;
+    }
+}
+
+static const Game& withFiveShips(Game& g)
+{
+    addFleet(g, 5);
+    return g;
+}
+
+  // A match between a human answering through a mailbox and a good player
+struct HumanMatch
+{
+    Game game;
+    MailboxLines lines;
+    AsyncHumanPlayer human;
+    GoodPlayer good;
+    unique_ptr<Board> boards[2];
+    MatchResult result;
+    vector<string> answers;     //every answer the human will give
+    size_t next;
+
+    HumanMatch(uint64_t seed, Scheduler& s, ostream& prompts)
+     : game(10, 10, seed), lines(s), human("human", withFiveShips(game), lines, prompts),
+       good("good", game), next(0)
+    {
+        boards[0].reset(new Board(game));
+        boards[1].reset(new Board(game));
+        MatchResult none = { nullptr, 0, { 0, 0 }, { 0, 0 }, { 0, 0 } };
+        result = none;
+        for (int i = 0; i < game.nShips(); i++)
+        {
+            answers.push_back("h");
+            answers.push_back(to_string(i) + " 0");
+        }
+        for (int r = 0; r < game.rows(); r++)
+            for (int col = 0; col < game.cols(); col++)
+                answers.push_back(to_string(r) + " " + to_string(col));
+    }
+};
+
+  // Many matches at once on one Scheduler, each between an AsyncHumanPlayer
+  // and a good player.  The humans' answers are sent only once they are
+  // waiting for them, so every answer suspends its match and resumes it.
+  // The cost per match includes all of that and the prompts.  Every match
+  // must be played to a win.
+static void benchAsyncHumans()
+{
+    Config c = { 10, 5 };
+    string name = caseName("scheduler.async-human-vs-good", c);
+    if (!selected(name))
+        return;
+    const int nMatches = (g_options.quick ? 200 : 2000);
+    ostream nowhere(nullptr); //the prompts
+    NullObserver none;
+    uint64_t seed = 21;
+    int bad = 0;
+    measure(name, c.size, c.size, c.ships, 1, 5, [&]() {
+        Scheduler scheduler;
+        vector<unique_ptr<HumanMatch> > matches;
+        for (int i = 0; i < nMatches; i++)
+        {
+            matches.push_back(unique_ptr<HumanMatch>(new HumanMatch(seed++, scheduler, nowhere)));
+            HumanMatch& m = *matches.back();
+            scheduler.spawn(runMatchAsync(m.game, &m.human, &m.good, *m.boards[0], *m.boards[1],
+                                          none, m.result));
+        }
+        while (scheduler.poll() > 0)
+        {
+            for (int i = 0; i < nMatches; i++)
+            {
+                HumanMatch& m = *matches[i];
+                if (!m.lines.waiting())
+                    continue;
+                if (m.next == m.answers.size())
+                {
+                    bad++; //still playing after every cell was attacked
+                    return (long long) nMatches;
+                }
+                m.lines.send(m.answers[m.next++]);
+            }
+        }
+        for (int i = 0; i < nMatches; i++)
+            if (matches[i]->result.winner == nullptr)
+                bad++;
+        return (long long) nMatches;
+    });
+    if (bad > 0)
+    {
+        fprintf(stderr, "%s: %d matches didn't end in a win\n", name.c_str(), bad);
+        g_failures++;
+    }
+}
+
+#endif // BATTLESHIP_COROUTINES
+
+//******************** Lockstep cases *********************************
+
+  // A player that puts down a given fleet and attacks as AwfulPlayer does,
+  // to check LockstepSweep against the ordinary match loop
+class SweepPlayer final : public Player
+{
+  public:
+    SweepPlayer(const Game& g, const vector<FleetPlacer::Placement>& fleet)
+     : Player("sweep", g), m_attacker("sweep", g), m_fleet(fleet) {}
+    virtual bool placeShips(Board& b)
+    {
+        for (size_t i = 0; i < m_fleet.size(); i++)
+            if (!b.placeShip(m_fleet[i].topOrLeft, m_fleet[i].shipId, m_fleet[i].dir))
+                return false;
+        return true;
+    }
+    virtual Point recommendAttack() { return m_attacker.recommendAttack(); }
+    virtual void recordAttackResult(Point, bool, bool, bool, int) {}
+    virtual void recordAttackByOpponent(Point) {}
+    virtual void reset() { m_attacker.reset(); }
+
+  private:
+    AwfulPlayer m_attacker;
+    vector<FleetPlacer::Placement> m_fleet;
+};
+
+static vector<FleetPlacer::Placement> awfulFleet(const Game& g)
+{
+    vector<FleetPlacer::Placement> fleet;
+    for (int k = 0; k < g.nShips(); k++)
+    {
+        FleetPlacer::Placement pl = { k, Point(k, 0), HORIZONTAL };
+        fleet.push_back(pl);
+    }
+    return fleet;
+}
+
+  // Whether every match engine has played agrees with runMatch between
+  // SweepPlayers with the same fleets
+static int lockstepDisagreements(const Game& g, const LockstepSweep& engine,
+                                 const vector<vector<FleetPlacer::Placement> >& fleets)
+{
+    int differ = 0;
+    Board b1(g);
+    Board b2(g);
+    for (int i = 0; i < engine.nMatches(); i++)
+    {
+        SweepPlayer p1(g, fleets[2*i]);
+        SweepPlayer p2(g, fleets[2*i+1]);
+        MatchResult r = simulateMatch(g, p1, p2, b1, b2);
+        int winner = (r.winner == &p1 ? 0 : r.winner == &p2 ? 1 : -1);
+        if (engine.winner(i) != winner  ||  engine.turns(i) != r.turns  ||
+            engine.shotsFired(i, 0) != r.shotsFired[0]  ||  engine.shotsFired(i, 1) != r.shotsFired[1]  ||
+            engine.hits(i, 0) != r.hits[0]  ||  engine.hits(i, 1) != r.hits[1])
+            differ++;
+    }
+    return differ;
+}
+
+  // LockstepSweep playing awful-vs-awful matches, to set against the
+  // game.typed and game.simulate cases of that pair, and matches between
+  // sweepers with fleets placed at random.  Matches with random fleets,
+  // run with and without AVX2, must agree with the match loop, and
+  // awful-vs-awful must give the same tallies as Game::simulate.
+static void benchLockstep()
+{
+    Config c = { 10, 5 };
+    Game g(c.size, c.size, 9);
+    addFleet(g, c.ships);
+    const int NMATCHES = 4096;
+    LockstepSweep engine(g);
+    string suffix = (LockstepSweep::vectorized() ? "" : ".novector");
+
+    vector<FleetPlacer::Placement> awful = awfulFleet(g);
+    measure(caseName("lockstep.awful-vs-awful" + suffix, c), c.size, c.size, c.ships, 3, 15, [&]() {
+        engine.clear();
+        for (int i = 0; i < NMATCHES; i++)
+            engine.addMatch(awful, awful);
+        engine.run();
+        return (long long) NMATCHES;
+    });
+    measure(caseName("lockstep.awful-vs-awful.scalar", c), c.size, c.size, c.ships, 3, 15, [&]() {
+        engine.clear();
+        for (int i = 0; i < NMATCHES; i++)
+            engine.addMatch(awful, awful);
+        engine.runScalar();
+        return (long long) NMATCHES;
+    });
+
+    FleetPlacer placer(g);
+    RandomEngine rng(17);
+    vector<vector<FleetPlacer::Placement> > fleets;
+    for (int i = 0; i < 2 * NMATCHES; i++)
+    {
+        placer.draw(rng);
+        fleets.push_back(placer.fleet());
+    }
+    measure(caseName("lockstep.sweep.random-fleets" + suffix, c), c.size, c.size, c.ships, 3, 15, [&]() {
+        engine.clear();
+        for (int i = 0; i < NMATCHES; i++)
+            engine.addMatch(fleets[2*i], fleets[2*i+1]);
+        engine.run();
+        return (long long) NMATCHES;
+    });
+    if (!selected("lockstep."))
+        return;
+
+    int differ = 0;
+    for (int scalar = 0; scalar < 2; scalar++)
+    {
+        engine.clear();
+        for (int i = 0; i < NMATCHES; i++)
+            engine.addMatch(fleets[2*i], fleets[2*i+1]);
+        if (scalar)
+            engine.runScalar();
+        else
+            engine.run();
+        differ += lockstepDisagreements(g, engine, fleets);
+    }
+
+    const int NGAMES = 200;
+    long long tally[2][3] = {}; //wins by the first player, turns, shots
+    engine.clear();
+    for (int k = 0; k < NGAMES; k++)
+    {
+        Game game(c.size, c.size, 3000 + k);
+        addFleet(game, c.ships);
+        Player* p1 = createPlayer("awful", "awful", game);
+        Player* p2 = createPlayer("awful", "awful", game);
+        MatchResult r = game.simulate(p1, p2);
+        tally[0][0] += (r.winner == p1);
+        tally[0][1] += r.turns;
+        tally[0][2] += r.shotsFired[0] + r.shotsFired[1];
+        delete p1;
+        delete p2;
+        engine.addMatch(awful, awful);
+    }
+    engine.run();
+    for (int i = 0; i < NGAMES; i++)
+    {
+        tally[1][0] += (engine.winner(i) == 0);
+        tally[1][1] += engine.turns(i);
+        tally[1][2] += engine.shotsFired(i, 0) + engine.shotsFired(i, 1);
+    }
+    if (tally[0][0] != tally[1][0]  ||  tally[0][1] != tally[1][1]  ||  tally[0][2] != tally[1][2])
+        differ++;
+    if (differ > 0)
+    {
+        fprintf(stderr, "lockstep: %d disagreements with the match loop\n", differ);
+        g_failures++;
+    }
+}
+
+//******************** Tournament cases *******************************
+
+static bool addFiveShips(Game& g)
+{
+    return addFleet(g, 5);
+}
+
+  // A tournament between the searching players, played on one worker
+  // thread and then on two with the same seed; since their moves search a
+  // fixed number of playouts, the totals must be the same
+static void benchTournamentSeeds()
+{
+    string name = "tournament.seeded.montecarlo-vs-mcts";
+    if (!selected(name))
+        return;
+    const long long NGAMES = (g_options.quick ? 4 : 10);
+    TournamentResult r[2];
+    for (int i = 0; i < 2; i++)
+        r[i] = runTournament("montecarlo", "mcts", 10, 10, addFiveShips, NGAMES, 1 + i, 41);
+    fprintf(stderr, "%-44s %lld games in %.2f s and %.2f s, %lld and %lld turns\n",
+            name.c_str(), NGAMES, r[0].seconds, r[1].seconds, r[0].turns, r[1].turns);
+    if (r[0].turns != r[1].turns  ||  r[0].wins[0] != r[1].wins[0]  ||
+        r[0].hits[0] != r[1].hits[0]  ||  r[0].hits[1] != r[1].hits[1])
+    {
+        fprintf(stderr, "%s: the totals depend on the number of threads\n", name.c_str());
+        g_failures++;
+    }
+}
+
+//******************** Allocation cases *******************************
+
+  // A tournament recycles each worker's game, boards and players, so once
+  // a worker has played its first game, more games mean no more
+  // allocations.  Count the allocations of a one-thread tournament of n
+  // games and of 2n games with the same seed, in each form of operator
+  // new; they must be the same.
+static void benchAllocations(const string& type1, const string& type2)
+{
+    string name = "alloc.tournament." + type1 + "-vs-" + type2;
+    if (!selected(name))
+        return;
+    const long long NGAMES = (g_options.quick ? 200 : 2000);
+
+      // First make sure every form is counted at all
+    struct alignas(64) Line
+    {
+        char bytes[64];
+    };
+    long long seen[NALLOCATIONFORMS];
+    for (int f = 0; f < NALLOCATIONFORMS; f++)
+        seen[f] = g_allocations[f].load();
+    delete new int;
+    delete[] new int[3];
+    delete new Line;
+    delete[] new Line[3];
+    for (int f = 0; f < NALLOCATIONFORMS; f++)
+    {
+        if (g_allocations[f].load() == seen[f])
+        {
+            fprintf(stderr, "%s: %s isn't counted\n", name.c_str(), ALLOCATIONFORMNAMES[f]);
+            g_failures++;
+        }
+    }
+
+    long long counts[2][NALLOCATIONFORMS];
+    for (int i = 0; i < 2; i++)
+    {
+        long long before[NALLOCATIONFORMS];
+        for (int f = 0; f < NALLOCATIONFORMS; f++)
+            before[f] = g_allocations[f].load();
+        runTournament(type1, type2, 10, 10, addFiveShips, NGAMES << i, 1, 99);
+        for (int f = 0; f < NALLOCATIONFORMS; f++)
+            counts[i][f] = g_allocations[f].load() - before[f];
+    }
+    long long total[2] = { 0, 0 };
+    for (int f = 0; f < NALLOCATIONFORMS; f++)
+    {
+        total[0] += counts[0][f];
+        total[1] += counts[1][f];
+    }
+    double perGame = double(total[1] - total[0]) / NGAMES;
+    fprintf(stderr, "%-44s %lld allocations for %lld games, %lld for %lld: %.2f per game\n",
+            name.c_str(), total[0], NGAMES, total[1], 2 * NGAMES, perGame);
+    for (int f = 0; f < NALLOCATIONFORMS; f++)
+    {
+        if (counts[1][f] != counts[0][f])
+        {
+            fprintf(stderr, "%s: games call %s once the tournament is going\n", name.c_str(),
+                    ALLOCATIONFORMNAMES[f]);
+            g_failures++;
+        }
+    }
+}
+
+//******************** Transposition cases ****************************
+
+  // The Knowledge of a board after the shots at the given cells, in order
+static uint64_t knowledgeHash(const Game& g, const vector<FleetPlacer::Placement>& fleet,
+                              const vector<Point>& shots)
+{
+    Board b(g);
+    for (size_t i = 0; i < fleet.size(); i++)
+        b.placeShip(fleet[i].topOrLeft, fleet[i].shipId, fleet[i].dir);
+    Knowledge k(g);
+    for (size_t i = 0; i < shots.size(); i++)
+    {
+        bool shotHit;
+        bool shipDestroyed;
+        int shipId;
+        if (b.attack(shots[i], shotHit, shipDestroyed, shipId))
+            k.record(shots[i], shotHit, shipDestroyed, shipId);
+    }
+    return k.hash();
+}
+
+  // Knowledge must stay true to the board when ships touch, so that which
+  // hits a sunk ship covered can be in doubt: no cell of a ship afloat
+  // blocked, no sunk ship's cell an open hit, and, where the ways the sunk
+  // ships could lie are listed, the true one among them.  The endgame
+  // solver must still pick unfired cells in such positions.
+static void checkSunkShips()
+{
+    const int SIZE = 7;
+    Game g(SIZE, SIZE, 31);
+    addFleet(g, 5);
+    FleetPlacer placer(g);
+    RandomEngine rng(37);
+    EndgameSolver solver(g);
+    int wrong = 0;
+    int unsure = 0;
+    int listed = 0;
+    int solved = 0;
+    vector<int> shipAt(SIZE * SIZE);
+    for (int trial = 0; trial < 300; trial++)
+    {
+        placer.draw(rng); //ships may touch
+        Board b(g);
+        fill(shipAt.begin(), shipAt.end(), -1);
+        for (size_t i = 0; i < placer.fleet().size(); i++)
+        {
+            const FleetPlacer::Placement& pl = placer.fleet()[i];
+            b.placeShip(pl.topOrLeft, pl.shipId, pl.dir);
+            for (int j = 0; j < g.shipLength(pl.shipId); j++)
+                shipAt[(pl.topOrLeft.r + (pl.dir == VERTICAL ? j : 0)) * SIZE +
+                       pl.topOrLeft.c + (pl.dir == HORIZONTAL ? j : 0)] = pl.shipId;
+        }
+        vector<Point> order;
+        for (int r = 0; r < SIZE; r++)
+            for (int c = 0; c < SIZE; c++)
+                order.push_back(Point(r, c));
+        for (int i = int(order.size()) - 1; i > 0; i--)
+            swap(order[i], order[rng.nextInt(i + 1)]);
+        Knowledge k(g);
+        for (size_t n = 0; n < order.size()  &&  !b.allShipsDestroyed(); n++)
+        {
+            bool shotHit;
+            bool shipDestroyed;
+            int shipId;
+            b.attack(order[n], shotHit, shipDestroyed, shipId);
+            k.record(order[n], shotHit, shipDestroyed, shipId);
+            for (int cell = 0; cell < SIZE * SIZE; cell++)
+            {
+                int id = shipAt[cell];
+                bool afloat = (id >= 0  &&  !k.shipSunk(id));
+                if ((afloat  &&  k.blocked(cell / SIZE, cell % SIZE))  ||
+                    (!afloat  &&  k.openHit(cell / SIZE, cell % SIZE)))
+                    wrong++;
+            }
+            const vector<Point>& hits = k.unsureHits();
+            if (hits.empty())
+                continue;
+            unsure++;
+            if (k.sunkCoversExact())
+            {
+                listed++;
+                uint64_t truth = 0;
+                for (size_t u = 0; u < hits.size(); u++)
+                    if (k.shipSunk(shipAt[hits[u].r * SIZE + hits[u].c]))
+                        truth |= uint64_t(1) << u;
+                const vector<uint64_t>& covers = k.sunkCovers();
+                if (find(covers.begin(), covers.end(), truth) == covers.end())
+                    wrong++;
+            }
+            Point p;
+            if (k.shipsAfloat() > 0  &&  solver.solve(k, p))
+            {
+                solved++;
+                if (k.fired(p.r, p.c))
+                    wrong++;
+            }
+        }
+    }
+    fprintf(stderr, "knowledge: %d positions with unsure hits, %d with their covers listed, "
+            "%d solved\n", unsure, listed, solved);
+    if (wrong > 0  ||  listed == 0)
+    {
+        fprintf(stderr, "knowledge: %d things wrong with ships touching\n", wrong);
+        g_failures++;
+    }
+}
+
+  // Knowledge's hash must depend on what was learned and not on the order
+  // of the shots, and the table must never hand back a value stored for
+  // another key, even with threads storing into the same slots at once,
+  // and Knowledge must pass checkSunkShips.  Then the cost of a probe, and good-vs-good matches with the players
+  // sharing a table, to set against game.typed.good-vs-good; their results
+  // must be the same as without it.
+static void benchTranspositions()
+{
+    Config c = { 10, 5 };
+    string name = caseName("tt.probe", c);
+    if (!selected(name)  &&  !selected(caseName("game.typed.good-vs-good.table", c)))
+        return;
+    Game g(c.size, c.size, 17);
+    addFleet(g, c.ships);
+    FleetPlacer placer(g);
+    RandomEngine rng(23);
+    int wrong = 0;
+    for (int trial = 0; trial < 200; trial++)
+    {
+        placer.draw(rng, FleetPlacer::APART); //so every sunk ship is resolved exactly
+        vector<Point> order;
+        for (int r = 0; r < c.size; r++)
+            for (int col = 0; col < c.size; col++)
+                order.push_back(Point(r, col));
+        for (int i = int(order.size()) - 1; i > 0; i--)
+            swap(order[i], order[rng.nextInt(i + 1)]);
+        int n = 1 + rng.nextInt(int(order.size()));
+        vector<Point> shots(order.begin(), order.begin() + n);
+        uint64_t h = knowledgeHash(g, placer.fleet(), shots);
+        for (int i = n - 1; i > 0; i--)
+            swap(shots[i], shots[rng.nextInt(i + 1)]);
+        if (knowledgeHash(g, placer.fleet(), shots) != h)
+            wrong++; //the same cells in another order
+        shots.push_back(order[n % order.size()]);
+        if (n < int(order.size())  &&  knowledgeHash(g, placer.fleet(), shots) == h)
+            wrong++; //one shot more
+    }
+
+    TranspositionTable shared(1024);
+    auto valueFor = [](uint64_t key) { return (key * 0x9E3779B97F4A7C15ULL) | 1; };
+    atomic<int> torn(0);
+    auto hammer = [&](uint64_t seed) {
+        RandomEngine r(seed);
+        for (int i = 0; i < 200000; i++)
+        {
+            uint64_t key = r.next() & 0xFFFFF; //many keys to a slot
+            uint64_t value;
+            if (shared.probe(key, value)  &&  value != valueFor(key))
+                torn++;
+            shared.store(key, valueFor(key));
+        }
+    };
+    thread other(hammer, 1);
+    hammer(2);
+    other.join();
+    if (wrong > 0  ||  torn > 0)
+    {
+        fprintf(stderr, "tt: %d wrong knowledge hashes, %d wrong table values\n", wrong, int(torn));
+        g_failures++;
+    }
+    checkSunkShips();
+
+    TranspositionTable table;
+    vector<uint64_t> keys;
+    for (int i = 0; i < 4096; i++)
+    {
+        keys.push_back(rng.next());
+        if (i % 2 == 0)
+            table.store(keys.back(), valueFor(keys.back()));
+    }
+    measure(name, c.size, c.size, c.ships, 3, 15, [&]() {
+        const int N = 1000000;
+        uint64_t found = 0;
+        for (int i = 0; i < N; i++)
+        {
+            uint64_t value;
+            if (table.probe(keys[i & 4095], value))
+                found += value;
+        }
+        asm volatile("" : : "r"(found)); //keep the loop
+        return (long long) N;
+    });
+
+    table.clear();
+    const int gamesPerRep = 200;
+    int gameNo = 0;
+    measure(caseName("game.typed.good-vs-good.table", c), c.size, c.size, c.ships, 1, 10, [&]() {
+        for (int k = 0; k < gamesPerRep; k++)
+        {
+            Game tg(c.size, c.size, 5000 + gameNo++);
+            addFleet(tg, c.ships);
+            GoodPlayer p1("good", tg, &table);
+            GoodPlayer p2("good", tg, &table);
+            simulateMatch(tg, p1, p2);
+        }
+        return (long long) gamesPerRep;
+    });
+    int differ = 0;
+    for (int k = 0; k < 100; k++)
+    {
+        Game g1(c.size, c.size, 7000 + k);
+        addFleet(g1, c.ships);
+        GoodPlayer a1("good", g1);
+        GoodPlayer a2("good", g1);
+        MatchResult plain = simulateMatch(g1, a1, a2);
+        Game g2(c.size, c.size, 7000 + k);
+        addFleet(g2, c.ships);
+        GoodPlayer b1("good", g2, &table);
+        GoodPlayer b2("good", g2, &table);
+        MatchResult cached = simulateMatch(g2, b1, b2);
+        if ((plain.winner == &a1) != (cached.winner == &b1)  ||  plain.turns != cached.turns  ||
+            plain.hits[0] != cached.hits[0]  ||  plain.hits[1] != cached.hits[1])
+            differ++;
+    }
+    if (differ > 0)
+    {
+        fprintf(stderr, "tt: %d of 100 matches differ with a shared table\n", differ);
+        g_failures++;
+    }
+}
+
+//******************** Endgame cases **********************************
+
+  // Solve each position with solver, noting the answer (or (-1,-1) if it
+  // wasn't solved), and return how many positions it searched
+static long long solveAll(EndgameSolver& solver, const vector<Knowledge>& positions,
+                          vector<Point>& answers, bool backwards = false)
+{
+    long long searched = 0;
+    answers.assign(positions.size(), Point(-1, -1));
+    for (size_t n = 0; n < positions.size(); n++)
+    {
+        size_t i = (backwards ? positions.size() - 1 - n : n);
+        Point p;
+        if (solver.solve(positions[i], p))
+            answers[i] = p;
+        searched += solver.lastSolve().searched;
+    }
+    return searched;
+}
+
+  // EndgameSolver on the positions a GoodPlayer reaches once at most two
+  // ships are afloat, with the default limits.  Each solve must pick an
+  // unfired cell and pick it again when asked again; the share of
+  // positions solved within the limits and the slowest solve are reported.
+  // A table kept from one move to the next, or shared by two threads at
+  // once, must save searching positions found in it by earlier moves,
+  // games or the other thread, and must not change a single answer.
+static void benchEndgame()
+{
+    Config c = { 10, 5 };
+    string name = caseName("endgame.solve", c);
+    if (!selected(name))
+        return;
+    Game g(c.size, c.size, 29);
+    addFleet(g, c.ships);
+    vector<Knowledge> positions;
+    for (int game = 0; game < 100; game++)
+    {
+        Board b(g);
+        GoodPlayer placer("placer", g);
+        placer.placeShips(b);
+        GoodPlayer attacker("good", g);
+        Knowledge k(g);
+        while (!b.allShipsDestroyed())
+        {
+            Point p = attacker.recommendAttack();
+            bool shotHit;
+            bool shipDestroyed;
+            int shipId;
+            bool valid = b.attack(p, shotHit, shipDestroyed, shipId);
+            attacker.recordAttackResult(p, valid, shotHit, shipDestroyed, shipId);
+            if (!valid)
+                break;
+            k.record(p, shotHit, shipDestroyed, shipId);
+            if (k.shipsAfloat() <= 2  &&  !b.allShipsDestroyed())
+                positions.push_back(k);
+        }
+    }
+
+    EndgameSolver solver(g);
+    int solved = 0;
+    int bad = 0;
+    long long maxWork = 0;
+    double slowest = 0;
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        Point p;
+        Clock::time_point start = Clock::now();
+        bool ok = solver.solve(positions[i], p);
+        slowest = max(slowest, chrono::duration<double, micro>(Clock::now() - start).count());
+        maxWork = max(maxWork, solver.lastSolve().work);
+        if (!ok)
+            continue;
+        solved++;
+        Point again;
+        if (positions[i].fired(p.r, p.c)  ||  !solver.solve(positions[i], again)  ||
+            again.r != p.r  ||  again.c != p.c)
+            bad++;
+    }
+    fprintf(stderr, "endgame: %d of %zu positions solved, at most %lld work, slowest %.0f us\n",
+            solved, positions.size(), maxWork, slowest);
+    if (bad > 0)
+    {
+        fprintf(stderr, "endgame: %d solves fired at a known cell or changed their minds\n", bad);
+        g_failures++;
+    }
+
+    TranspositionTable cold;
+    EndgameSolver fresh(g, &cold);
+    vector<Point> expected(positions.size());
+    long long coldSearched = 0;
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        cold.clear();
+        Point p;
+        if (fresh.solve(positions[i], p))
+            expected[i] = p;
+        else
+            expected[i] = Point(-1, -1);
+        coldSearched += fresh.lastSolve().searched;
+    }
+    TranspositionTable kept;
+    EndgameSolver warm(g, &kept);
+    vector<Point> answers[3];
+    long long warmSearched = solveAll(warm, positions, answers[0]);
+    TranspositionTable shared;
+    EndgameSolver solvers[2] = { EndgameSolver(g, &shared), EndgameSolver(g, &shared) };
+    long long sharedSearched[2];
+    thread other([&]() { sharedSearched[1] = solveAll(solvers[1], positions, answers[2], true); });
+    sharedSearched[0] = solveAll(solvers[0], positions, answers[1]);
+    other.join();
+    int changed = 0;
+    for (int a = 0; a < 3; a++)
+        for (size_t i = 0; i < positions.size(); i++)
+            if (answers[a][i].r != expected[i].r  ||  answers[a][i].c != expected[i].c)
+                changed++;
+    long long bothSearched = sharedSearched[0] + sharedSearched[1];
+    fprintf(stderr, "endgame: %lld positions searched with a cold table, %lld with one kept "
+            "between moves, %lld with one shared by two threads\n",
+            coldSearched, warmSearched, bothSearched);
+    if (changed > 0  ||  warmSearched >= coldSearched  ||  bothSearched >= 2 * warmSearched)
+    {
+        fprintf(stderr, "endgame: %d answers changed with a warm table, or it saved nothing\n",
+                changed);
+        g_failures++;
+    }
+
+    size_t next = 0;
+    measure(name, c.size, c.size, c.ships, 1, 10, [&]() {
+        const int N = 200;
+        for (int i = 0; i < N; i++)
+        {
+            Point p;
+            solver.solve(positions[next++ % positions.size()], p);
+        }
+        return (long long) N;
+    });
+}
+
+//******************** Search cases ***********************************
+
+  // MctsPlayer's playouts per second against the number of worker threads,
+  // up to one per hardware thread, over the first moves of games, when its
+  // trees are largest.  Each worker grows its own tree, so the rate should
+  // grow about in step with the cores.  The node cap is set low enough to
+  // be reached, and no search may ever hold more nodes than it.
+static void benchSearch()
+{
+    Config c = { 10, 5 };
+    const int MOVES = 10;
+    const int MSPERMOVE = 5;
+    const int MAXNODES = 1 << 11;
+    int hardware = max(1, int(thread::hardware_concurrency()));
+    vector<int> threads;
+    for (int n = 1; n < hardware; n *= 2)
+        threads.push_back(n);
+    threads.push_back(hardware);
+
+    double onePerSecond = 0;
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        int n = threads[i];
+        int gameNo = 0;
+        long long playouts = 0;
+        double seconds = 0;
+        int mostNodes = 0;
+        BenchResult* r = measure(caseName("mcts.playouts.t" + to_string(n), c),
+                                 c.size, c.size, c.ships, 1, 5, [&]() {
+            Game g(c.size, c.size, 7000 + gameNo++);
+            addFleet(g, c.ships);
+            Board target(g);
+            MediocrePlayer placer("placer", g);
+            placer.placeShips(target);
+            MctsPlayer attacker("mcts", g, n, MSPERMOVE, MAXNODES);
+            long long done = 0;
+            for (int m = 0; m < MOVES  &&  !target.allShipsDestroyed(); m++)
+            {
+                bool shotHit;
+                bool shipDestroyed;
+                int shipId;
+                Point t = attacker.recommendAttack();
+                bool valid = target.attack(t, shotHit, shipDestroyed, shipId);
+                attacker.recordAttackResult(t, valid, shotHit, shipDestroyed, shipId);
+                const MctsPlayer::Stats& stats = attacker.lastSearch();
+                done += stats.playouts;
+                seconds += stats.seconds;
+                mostNodes = max(mostNodes, stats.nodes);
+            }
+            playouts += done;
+            return done;
+        });
+        if (r == nullptr)
+            continue;
+        double perSecond = playouts / seconds;
+        if (n == 1)
+            onePerSecond = perSecond;
+        fprintf(stderr, "mcts: %d threads, %.0f playouts/s (%.2fx one thread), at most %d nodes\n",
+                n, perSecond, (onePerSecond > 0 ? perSecond / onePerSecond : 0), mostNodes);
+        if (mostNodes > MAXNODES)
+        {
+            fprintf(stderr, "mcts: %d nodes in use, over the cap of %d\n", mostNodes, MAXNODES);
+            g_failures++;
+        }
+    }
+}
+
+//******************** Replay cases ***********************************
+
+  // Record a batch of matches to a replay file, then map it and scan it;
+  // every match must replay to a sunk fleet for the loser
+static void benchReplay()
+{
+    Config c = { 10, 5 };
+    const char* path = "bench_replay.bin";
+    const int NGAMES = 2000;
+    if (!selected(caseName("replay.scanShots", c)))
+        return;
+    {
+        ofstream out(path, ios::binary);
+        ReplayWriter writer(out);
+        for (int k = 0; k < NGAMES; k++)
+        {
+            Game g(c.size, c.size, 500 + k);
+            addFleet(g, c.ships);
+            Player* p1 = createPlayer("good", "good", g);
+            Player* p2 = createPlayer("mediocre", "mediocre", g);
+            g.simulate(p1, p2, writer);
+            delete p1;
+            delete p2;
+        }
+    }
+
+    ReplayReader reader;
+    if (!reader.open(path))
+    {
+        fprintf(stderr, "Couldn't read back %s\n", path);
+        return;
+    }
+    measure(caseName("replay.scanShots", c), c.size, c.size, c.ships, 3, 15, [&]() {
+        reader.rewind();
+        ReplayGame game;
+        long long shots = 0;
+        int sum = 0;
+        while (reader.next(game))
+            for (int k = 0; k < game.nShots(); k++)
+            {
+                sum += game.shot(k).r;
+                shots++;
+            }
+        asm volatile("" : : "r"(sum)); //keep the loop
+        return shots;
+    });
+
+    int bad = 0;
+    reader.rewind();
+    ReplayGame game;
+    while (reader.next(game))
+    {
+        Game g(game.rows(), game.cols());
+        if (game.winner() < 0  ||  !game.addFleetTo(g))
+        {
+            bad++;
+            continue;
+        }
+        Board b(g); //only now that g has its fleet
+        if (!game.boardAt(b, 1 - game.winner(), game.nShots())  ||  !b.allShipsDestroyed())
+            bad++;
+    }
+    reader.close();
+    remove(path);
+    if (bad > 0)
+    {
+        fprintf(stderr, "%d of %d recorded matches failed to replay\n", bad, NGAMES);
+        g_failures++;
+    }
+}
+
+  // Matches played through Game::play, Game::simulate with an observer and
+  // Game::simulate alone, with a replay file set, must each be appended to
+  // the file and replay to the winner and number of shots they had
+static void benchPlayedReplays()
+{
+    Config c = { 10, 5 };
+    string name = caseName("replay.played", c);
+    if (!selected(name))
+        return;
+    const char* path = "bench_played.bin";
+    remove(path);
+    Game g(c.size, c.size, 77);
+    addFleet(g, c.ships);
+    Player* p1 = createPlayer("good", "good", g);
+    Player* p2 = createPlayer("mediocre", "mediocre", g);
+    if (!g.setReplayFile(path))
+    {
+        fprintf(stderr, "%s: couldn't set the replay file %s\n", name.c_str(), path);
+        g_failures++;
+        return;
+    }
+    int winners[3];
+    int shots[3];
+    streambuf* console = cout.rdbuf(nullptr); //play shows the match, but cout carries the report
+    Player* winner = g.play(p1, p2, false);
+    cout.rdbuf(console);
+    winners[0] = (winner == p1 ? 0 : winner == p2 ? 1 : -1);
+    shots[0] = -1; //play doesn't say
+    NullObserver none;
+    for (int i = 1; i < 3; i++)
+    {
+        p1->reset();
+        p2->reset();
+        MatchResult r = (i == 1 ? g.simulate(p2, p1, none) : g.simulate(p1, p2));
+        Player* first = (i == 1 ? p2 : p1);
+        winners[i] = (r.winner == first ? 0 : r.winner != nullptr ? 1 : -1);
+        shots[i] = r.shotsFired[0] + r.shotsFired[1];
+    }
+    g.setReplayFile("");
+    delete p1;
+    delete p2;
+
+    int bad = 0;
+    int n = 0;
+    ReplayReader reader;
+    if (!reader.open(path))
+        bad++;
+    ReplayGame game;
+    for ( ; bad == 0  &&  reader.next(game); n++)
+    {
+        Game rg(game.rows(), game.cols());
+        if (n >= 3  ||  game.winner() != winners[n]  ||  game.winner() < 0  ||
+            (shots[n] >= 0  &&  game.nShots() != shots[n])  ||  !game.addFleetTo(rg))
+        {
+            bad++;
+            continue;
+        }
+        Board b(rg);
+        if (!game.boardAt(b, 1 - game.winner(), game.nShots())  ||  !b.allShipsDestroyed())
+            bad++;
+    }
+    reader.close();
+    remove(path);
+    fprintf(stderr, "%-44s %d of 3 matches recorded\n", name.c_str(), n);
+    if (bad > 0  ||  n != 3)
+    {
+        fprintf(stderr, "%s: played matches weren't recorded as they went\n", name.c_str());
+        g_failures++;
+    }
+}
+
+//******************** Server cases ***********************************
+
+  // A client of the match server that places a fleet drawn by FleetPlacer
+  // and fires at every cell in turn, playing a given number of games
+struct ServerBot
+{
+    MatchClient client;
+    unique_ptr<Game> game;      //built from the first GAME_START
+    unique_ptr<FleetPlacer> placer;
+    RandomEngine rng;
+    int nextCell = 0;
+    int gamesLeft = 0;
+
+    explicit ServerBot(uint64_t seed) : rng(seed) {}
+};
+
+  // Deal with one message to bot; false if it shows something went wrong
+static bool serveBot(ServerBot& bot, const ServerMessage& m, Protocol::Opponent opponent,
+                     long long& gamesOver)
+{
+    switch (m.type)
+    {
+      case Protocol::GAME_START:
+        if (bot.game == nullptr)
+        {
+            bot.game.reset(new Game(m.rows, m.cols, 0));
+            for (size_t i = 0; i < m.shipLengths.size(); i++)
+                bot.game->addShip(m.shipLengths[i], m.shipSymbols[i], "ship");
+            bot.placer.reset(new FleetPlacer(*bot.game));
+        }
+        bot.nextCell = 0;
+        return bot.placer->draw(bot.rng)  &&  bot.client.place(bot.placer->fleet());
+      case Protocol::YOUR_TURN:
+      {
+        int cols = bot.game->cols();
+        Point p(bot.nextCell / cols, bot.nextCell % cols);
+        bot.nextCell++;
+        return bot.client.fire(p);
+      }
+      case Protocol::PLACED:
+        return m.value == 1;
+      case Protocol::SHOT_RESULT:
+        return (m.value & Protocol::RESULT_VALID) != 0;
+      case Protocol::OPPONENT_SHOT:
+        return true;
+      case Protocol::GAME_OVER:
+        gamesOver++;
+        if (m.value == Protocol::OUTCOME_ABANDONED)
+            return false;
+        if (--bot.gamesLeft > 0)
+            return bot.client.newGame(opponent);
+        bot.client.disconnect();
+        return true;
+      default:
+        return false;
+    }
+}
+
+  // Matches on a MatchServer running in its own thread, played by nClients
+  // clients at once, all driven from this thread, each playing
+  // gamesPerClient games one after another against opponent.  Against a
+  // client opponent the clients are paired with each other, so nClients
+  // must be even.  A game is everything from NEW_GAME to GAME_OVER, so the
+  // cost per game includes the socket round trip of every move.  Any game
+  // that doesn't run to a proper end is reported.
+static void benchServer(Protocol::Opponent opponent, const string& type)
+{
+    Config c = { 10, 5 };
+    string name = caseName("server.remote-vs-" + type, c);
+    if (!selected(name))
+        return;
+    const char* path = "bench_server.sock";
+    MatchServer server(c.size, c.size, addFiveShips);
+    if (!server.listen(path))
+    {
+        g_failures++;
+        return;
+    }
+    thread serving([&]() { server.run(); });
+
+    const int nClients = (g_options.quick ? 200 : 1000);
+    const int gamesPerClient = 4;
+    const int perMatch = (opponent == Protocol::OPPONENT_REMOTE ? 2 : 1); //clients in each
+    long long gamesOver = 0;
+    long long expected = 0;
+    int bad = 0;
+    uint64_t seed = 11;
+    measure(name, c.size, c.size, c.ships, 1, 5, [&]() {
+        vector<unique_ptr<ServerBot> > bots;
+        for (int i = 0; i < nClients; i++)
+        {
+            bots.push_back(unique_ptr<ServerBot>(new ServerBot(seed++)));
+            ServerBot& bot = *bots.back();
+            bot.gamesLeft = gamesPerClient;
+            if (!bot.client.connect(path)  ||  !bot.client.newGame(opponent))
+                bad++;
+        }
+        expected += (long long) nClients * gamesPerClient;
+
+        vector<pollfd> fds(bots.size());
+        for (size_t i = 0; i < bots.size(); i++)
+        {
+            fds[i].fd = bots[i]->client.fd();
+            fds[i].events = POLLIN;
+        }
+        int nConnected = nClients;
+        ServerMessage m;
+        while (nConnected > 0)
+        {
+            if (::poll(fds.data(), fds.size(), 5000) <= 0)
+            {
+                bad++; //nothing from the server for too long
+                break;
+            }
+            for (size_t i = 0; i < bots.size(); i++)
+            {
+                if (fds[i].revents == 0)
+                    continue;
+                ServerBot& bot = *bots[i];
+                while (bot.client.receive(m, false))
+                    if (!serveBot(bot, m, opponent, gamesOver))
+                        bad++;
+                if (!bot.client.connected())
+                {
+                    fds[i].fd = -1; //poll ignores it from now on
+                    nConnected--;
+                }
+            }
+        }
+        return (long long) nClients * gamesPerClient / perMatch;
+    });
+
+    server.stop();
+    serving.join();
+    remove(path);
+    fprintf(stderr, "%-44s %d clients at once, %lld games over of %lld, %lld matches on the server\n",
+            name.c_str(), nClients, gamesOver, expected, server.matchesPlayed());
+    if (bad > 0  ||  gamesOver != expected  ||  server.matchesPlayed() != expected / perMatch)
+    {
+        fprintf(stderr, "%s: %d problems; not every game ran to its end\n", name.c_str(), bad);
+        g_failures++;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    string jsonPath;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--quick") == 0)
+            g_options.quick = true;
+        else if (strcmp(argv[i], "--json") == 0  &&  i+1 < argc)
+            jsonPath = argv[++i];
+        else
+            g_options.filters.push_back(argv[i]);
+    }
+
+    for (const Config& c : BOARDS)
+        benchBoard(c);
+    for (const char* type : PLAYERTYPES)
+        for (const Config& c : PLAYERBOARDS)
+            if (playerRunsOn(type, c))
+                benchPlayer(type, c);
+    int nTypes = sizeof(PLAYERTYPES) / sizeof(PLAYERTYPES[0]);
+    for (int i = 0; i < nTypes; i++)
+        for (int j = i; j < nTypes; j++)
+            benchMatch(PLAYERTYPES[i], PLAYERTYPES[j]);
+    benchTypedMatch<AwfulPlayer, AwfulPlayer>("awful", "awful");
+    benchTypedMatch<AwfulPlayer, MediocrePlayer>("awful", "mediocre");
+    benchTypedMatch<AwfulPlayer, GoodPlayer>("awful", "good");
+    benchTypedMatch<MediocrePlayer, MediocrePlayer>("mediocre", "mediocre");
+    benchTypedMatch<MediocrePlayer, GoodPlayer>("mediocre", "good");
+    benchTypedMatch<GoodPlayer, GoodPlayer>("good", "good");
+    benchTimedMatch("awful", "awful");
+    benchTimedMatch("good", "good");
+    benchDeadlines();
+#if BATTLESHIP_COROUTINES
+    benchAsyncMatch<AwfulPlayer, AwfulPlayer>("awful", "awful");
+    benchAsyncMatch<MediocrePlayer, GoodPlayer>("mediocre", "good");
+    benchAsyncMatch<GoodPlayer, GoodPlayer>("good", "good");
+    benchAsyncHumans();
+#endif
+    benchLockstep();
+    benchTranspositions();
+    benchEndgame();
+    benchSearch();
+    benchReplay();
+    benchPlayedReplays();
+    benchTournamentSeeds();
+    for (int i = 0; i < nTypes; i++)
+        for (int j = i; j < nTypes; j++)
+            if (!searches(PLAYERTYPES[i])  &&  !searches(PLAYERTYPES[j])) //their moves run on a pool
+                benchAllocations(PLAYERTYPES[i], PLAYERTYPES[j]);
+    benchServer(Protocol::OPPONENT_AWFUL, "awful");
+    benchServer(Protocol::OPPONENT_MEDIOCRE, "mediocre");
+    benchServer(Protocol::OPPONENT_GOOD, "good");
+    benchServer(Protocol::OPPONENT_REMOTE, "remote");
+
+    if (jsonPath.empty())
+        writeJson(cout);
+    else
+    {
+        ofstream out(jsonPath);
+        writeJson(out);
+    }
+    return (g_failures == 0 ? 0 : 1);
+}
@@ -1,10 +1,10 @@
 #ifndef GLOBALS_INCLUDED
 #define GLOBALS_INCLUDED
 
-#include <random>
+#include "Random.h"
 
-const int MAXROWS = 10;
-const int MAXCOLS = 10;
+const int MAXROWS = 1000;
+const int MAXCOLS = 1000;
 
 enum Direction {
     HORIZONTAL, VERTICAL
@@ -19,13 +19,13 @@ class Point
     int c;
 };
 
-  // Return a uniformly distributed random int from 0 to limit-1
+  // Return a uniformly distributed random int from 0 to limit-1, drawn from
+  // this thread's own unseeded generator.  Code that must be reproducible
+  // should draw from the game's generator (Game::rng) instead.
 inline int randInt(int limit)
 {
-    static std::random_device rd;
-    static std::mt19937 generator(rd());
-    std::uniform_int_distribution<> distro(0, limit-1);
-    return distro(generator);
+    static thread_local RandomEngine generator(freshSeed());
+    return generator.nextInt(limit);
 }
 
 #endif // GLOBALS_INCLUDED
@@ -1,10 +1,26 @@
 #include "Game.h"
 #include "Player.h"
+#include "Tournament.h"
+#include "MatchServer.h"
+#include "Instrument.h"
+#include <cstring>
 #include <iostream>
 #include <string>
 
 using namespace std;
 
+  // Usage: battleship [--replay file]
+  //
+  // With --replay, every match played through Game::play below is appended
+  // to that replay file (see Replay.h).
+static string replayPath;
+
+void recordMatches(Game& g)
+{
+    if (!g.setReplayFile(replayPath))
+        cout << "Can't write the replay file " << replayPath << endl;
+}
+
 bool addStandardShips(Game& g)
 {
     return g.addShip(5, 'A', "aircraft carrier")  &&
@@ -14,9 +30,13 @@ bool addStandardShips(Game& g)
            g.addShip(2, 'P', "patrol boat");
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+    if (argc == 3  &&  strcmp(argv[1], "--replay") == 0)
+        replayPath = argv[2];
     const int NTRIALS = 10;
+    const int NSILENT = 100000;
+    const char* const SOCKETPATH = "battleship.sock";
 
     cout << "Select one of these choices for an example of the game:" << endl;
     cout << "  1.  A mini-game between two mediocre players" << endl;
@@ -25,6 +45,12 @@ int main()
          << "-game match between a mediocre and an awful player, with no pauses"
          << endl;
     cout << "  4.  A human player against a human player" << endl;
+    cout << "  5.  A " << NSILENT
+         << "-game match between a mediocre and an awful player, with no output,"
+         << endl << "      spread over every core"
+         << endl;
+    cout << "  6.  Host matches for clients connecting to the socket "
+         << SOCKETPATH << endl;
     cout << "Enter your choice: ";
     string line;
     getline(cin,line);
@@ -35,6 +61,7 @@ int main()
     else if (line[0] == '1')
     {
         Game g(2, 3);
+        recordMatches(g);
         g.addShip(2, 'R', "rowboat");
         Player* p1 = createPlayer("mediocre", "Popeye", g);
         Player* p2 = createPlayer("mediocre", "Bluto", g);
@@ -46,6 +73,7 @@ int main()
     else if (line[0] == '2')
     {
         Game g(10, 10);
+        recordMatches(g);
         addStandardShips(g);
         Player* p1 = createPlayer("mediocre", "Mediocre Midori", g);
         Player* p2 = createPlayer("human", "Shuman the Human", g);
@@ -57,21 +85,27 @@ int main()
     {
         int nMediocreWins = 0;
 
+        Game g(10, 10);
+        recordMatches(g);
+        addStandardShips(g);
+        Player* p1 = createPlayer("awful", "Awful Audrey", g);
+        Player* p2 = createPlayer("mediocre", "Mediocre Mimi", g);
         for (int k = 1; k <= NTRIALS; k++)
         {
             cout << "============================= Game " << k
                  << " =============================" << endl;
-            Game g(10, 10);
-            addStandardShips(g);
-            Player* p1 = createPlayer("awful", "Awful Audrey", g);
-            Player* p2 = createPlayer("mediocre", "Mediocre Mimi", g);
+            if (k > 1)
+            {
+                p1->reset(); //same players, fresh memories
+                p2->reset();
+            }
             Player* winner = (k % 2 == 1 ?
                                 g.play(p1, p2, false) : g.play(p2, p1, false));
             if (winner == p2)
                 nMediocreWins++;
-            delete p1;
-            delete p2;
         }
+        delete p1;
+        delete p2;
         cout << "The mediocre player won " << nMediocreWins << " out of "
              << NTRIALS << " games." << endl;
           // We'd expect a mediocre player to win most of the games against
@@ -81,6 +115,7 @@ int main()
     else if (line[0] == '4')
     {
         Game g(10, 10);
+        recordMatches(g);
         addStandardShips(g);
         Player* p1 = createPlayer("human", "Loomin the Human", g);
         Player* p2 = createPlayer("human", "Shuman the Human", g);
@@ -88,9 +123,30 @@ int main()
         delete p1;
         delete p2;
     }
-
+    else if (line[0] == '5')
+    {
+        TournamentResult result = runTournament("awful", "mediocre", 10, 10,
+                                                addStandardShips, NSILENT);
+        cout << "The mediocre player won " << result.wins[1] << " out of "
+             << result.games << " games, with "
+             << result.shotsFired[0] + result.shotsFired[1]
+             << " shots fired in all." << endl;
+        cout << "Played " << result.gamesPerSecond() << " games/sec on "
+             << result.threads << " threads (seed " << result.seed << ")."
+             << endl;
+    }
+    else if (line[0] == '6')
+    {
+        MatchServer server(10, 10, addStandardShips);
+        if (server.listen(SOCKETPATH))
+        {
+            cout << "Serving at " << SOCKETPATH << "; interrupt to stop." << endl;
+            server.run();
+        }
+    }
     else
     {
        cout << "That's not one of the choices." << endl;
     }
+    instrumentReport(cout); //only in a build with BATTLESHIP_INSTRUMENT set
 }